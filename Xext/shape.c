@@ -27,6 +27,7 @@ in this Software without prior written authorization from The Open Group.
 #include <dix-config.h>
 
 #include <stdlib.h>
+#include <string.h>
 #include <X11/X.h>
 #include <X11/Xproto.h>
 #include <X11/extensions/shapeproto.h>
@@ -34,6 +35,7 @@ in this Software without prior written authorization from The Open Group.
 #include "dix/dix_priv.h"
 #include "dix/gc_priv.h"
 #include "dix/rpcbuf_priv.h"
+#include "dix/screen_hooks_priv.h"
 #include "dix/window_priv.h"
 #include "miext/extinit_priv.h"
 #include "Xext/panoramiX.h"
@@ -50,6 +52,7 @@ in this Software without prior written authorization from The Open Group.
 #include "opaque.h"
 #include "regionstr.h"
 #include "gcstruct.h"
+#include "servermd.h"
 #include "protocol-versions.h"
 
 Bool noShapeExtension = FALSE;
@@ -91,6 +94,158 @@ typedef struct _ShapeEvent {
     XID clientResource;
 } ShapeEventRec;
 
+/*
+ * Animated shaped windows tend to cycle through a small set of masks, and
+ * converting a bitmap into a region is the most expensive part of a
+ * ShapeMask request.  Each screen keeps a few recently converted masks,
+ * keyed by the bitmap contents rather than the pixmap, so entries never
+ * need invalidating when a pixmap is drawn to or freed.
+ */
+
+#define SHAPE_MASK_CACHE_SIZE		8
+#define SHAPE_MASK_CACHE_MAX_BYTES	(512 * 1024)
+
+typedef struct _ShapeMaskCacheEntry {
+    unsigned short width;
+    unsigned short height;
+    char *bits;
+    RegionPtr region;
+} ShapeMaskCacheEntryRec, *ShapeMaskCacheEntryPtr;
+
+typedef struct _ShapeScreen {
+    /* most recently used first */
+    ShapeMaskCacheEntryRec maskCache[SHAPE_MASK_CACHE_SIZE];
+} ShapeScreenRec, *ShapeScreenPtr;
+
+static DevPrivateKeyRec ShapeScreenPrivateKeyRec;
+
+#define ShapeGetScreenPriv(s) ((ShapeScreenPtr) \
+    dixLookupPrivate(&(s)->devPrivates, &ShapeScreenPrivateKeyRec))
+
+static void
+ShapeMaskCacheEntryFree(ShapeMaskCacheEntryPtr entry)
+{
+    free(entry->bits);
+    if (entry->region)
+        RegionDestroy(entry->region);
+    memset(entry, 0, sizeof(*entry));
+}
+
+static void
+ShapeScreenClose(CallbackListPtr *pcbl, ScreenPtr pScreen, void *unused)
+{
+    ShapeScreenPtr pShapeScreen = ShapeGetScreenPriv(pScreen);
+
+    dixScreenUnhookClose(pScreen, ShapeScreenClose);
+    if (!pShapeScreen)
+        return;
+
+    for (int i = 0; i < SHAPE_MASK_CACHE_SIZE; i++)
+        ShapeMaskCacheEntryFree(&pShapeScreen->maskCache[i]);
+    dixSetPrivate(&pScreen->devPrivates, &ShapeScreenPrivateKeyRec, NULL);
+    free(pShapeScreen);
+}
+
+static ShapeScreenPtr
+ShapeInitScreenPriv(ScreenPtr pScreen)
+{
+    ShapeScreenPtr pShapeScreen = ShapeGetScreenPriv(pScreen);
+
+    if (!pShapeScreen) {
+        pShapeScreen = calloc(1, sizeof(ShapeScreenRec));
+        if (!pShapeScreen)
+            return NULL;
+        dixSetPrivate(&pScreen->devPrivates, &ShapeScreenPrivateKeyRec,
+                      pShapeScreen);
+        dixScreenHookClose(pScreen, ShapeScreenClose);
+    }
+    return pShapeScreen;
+}
+
+/*
+ * BitmapToRegion with a lookup in the per-screen mask cache.  The bitmap
+ * is fetched with GetImage and compared byte for byte against the cached
+ * masks; on a miss the converted region is added to the cache, evicting
+ * the least recently used entry.
+ */
+static RegionPtr
+ShapeBitmapToRegion(ScreenPtr pScreen, PixmapPtr pPixmap)
+{
+    ShapeScreenPtr pShapeScreen = ShapeInitScreenPriv(pScreen);
+    unsigned short width = pPixmap->drawable.width;
+    unsigned short height = pPixmap->drawable.height;
+    size_t size = (size_t) PixmapBytePad(width, 1) * height;
+    ShapeMaskCacheEntryRec entry;
+    RegionPtr pRegion;
+    char *bits;
+    int i;
+
+    if (!pShapeScreen || size == 0 || size > SHAPE_MASK_CACHE_MAX_BYTES)
+        return BitmapToRegion(pScreen, pPixmap);
+
+    bits = malloc(size);
+    if (!bits)
+        return BitmapToRegion(pScreen, pPixmap);
+    (*pScreen->GetImage) (&pPixmap->drawable, 0, 0, width, height,
+                          ZPixmap, ~0, bits);
+
+    for (i = 0; i < SHAPE_MASK_CACHE_SIZE; i++) {
+        ShapeMaskCacheEntryPtr pEntry = &pShapeScreen->maskCache[i];
+
+        if (!pEntry->region)
+            break;
+        if (pEntry->width != width || pEntry->height != height ||
+            memcmp(pEntry->bits, bits, size) != 0)
+            continue;
+
+        free(bits);
+        pRegion = RegionDuplicate(pEntry->region);
+        if (i > 0) {
+            entry = *pEntry;
+            memmove(&pShapeScreen->maskCache[1], &pShapeScreen->maskCache[0],
+                    i * sizeof(ShapeMaskCacheEntryRec));
+            pShapeScreen->maskCache[0] = entry;
+        }
+        return pRegion;
+    }
+
+    pRegion = BitmapToRegion(pScreen, pPixmap);
+    if (!pRegion) {
+        free(bits);
+        return NULL;
+    }
+
+    entry.width = width;
+    entry.height = height;
+    entry.bits = bits;
+    entry.region = RegionDuplicate(pRegion);
+    if (!entry.region) {
+        free(bits);
+        return pRegion;
+    }
+
+    ShapeMaskCacheEntryFree(&pShapeScreen->maskCache[SHAPE_MASK_CACHE_SIZE - 1]);
+    memmove(&pShapeScreen->maskCache[1], &pShapeScreen->maskCache[0],
+            (SHAPE_MASK_CACHE_SIZE - 1) * sizeof(ShapeMaskCacheEntryRec));
+    pShapeScreen->maskCache[0] = entry;
+    return pRegion;
+}
+
+/*
+ * A window without a shape region and one with a shape region are
+ * different even when the region covers the default shape, since the
+ * protocol reports them differently.
+ */
+static Bool
+ShapeRegionsEqual(RegionPtr a, RegionPtr b)
+{
+    if (a == b)
+        return TRUE;
+    if (!a || !b)
+        return FALSE;
+    return RegionEqual(a, b);
+}
+
 /****************
  * ShapeExtensionInit
  *
@@ -106,6 +261,9 @@ RegionOperate(ClientPtr client,
               RegionPtr *destRgnp,
               RegionPtr srcRgn, int op, int xoff, int yoff, CreateDftPtr create)
 {
+    RegionPtr newRgn = *destRgnp;
+    Bool changed;
+
     if (srcRgn && (xoff || yoff))
         RegionTranslate(srcRgn, xoff, yoff);
     if (!pWin->parent) {
@@ -121,8 +279,7 @@ RegionOperate(ClientPtr client,
      */
     if (srcRgn == NULL) {
         if (*destRgnp != NULL) {
-            RegionDestroy(*destRgnp);
-            *destRgnp = 0;
+            newRgn = NULL;
             /* go on to remove shape and generate ShapeNotify */
         }
         else {
@@ -138,43 +295,63 @@ RegionOperate(ClientPtr client,
         }
     }
     else
+        /* The result is built in a new region so that it can be compared
+         * against the current shape before anything is revalidated. */
         switch (op) {
         case ShapeSet:
-            if (*destRgnp)
-                RegionDestroy(*destRgnp);
-            *destRgnp = srcRgn;
+            newRgn = srcRgn;
             srcRgn = 0;
             break;
         case ShapeUnion:
-            if (*destRgnp)
-                RegionUnion(*destRgnp, *destRgnp, srcRgn);
+            if (*destRgnp) {
+                newRgn = RegionCreate((BoxPtr) 0, 0);
+                RegionUnion(newRgn, *destRgnp, srcRgn);
+            }
             break;
         case ShapeIntersect:
-            if (*destRgnp)
-                RegionIntersect(*destRgnp, *destRgnp, srcRgn);
+            if (*destRgnp) {
+                newRgn = RegionCreate((BoxPtr) 0, 0);
+                RegionIntersect(newRgn, *destRgnp, srcRgn);
+            }
             else {
-                *destRgnp = srcRgn;
+                newRgn = srcRgn;
                 srcRgn = 0;
             }
             break;
         case ShapeSubtract:
-            if (!*destRgnp)
-                *destRgnp = (*create) (pWin);
-            RegionSubtract(*destRgnp, *destRgnp, srcRgn);
+            if (*destRgnp) {
+                newRgn = RegionCreate((BoxPtr) 0, 0);
+                RegionSubtract(newRgn, *destRgnp, srcRgn);
+            }
+            else {
+                newRgn = (*create) (pWin);
+                RegionSubtract(newRgn, newRgn, srcRgn);
+            }
             break;
         case ShapeInvert:
-            if (!*destRgnp)
-                *destRgnp = RegionCreate((BoxPtr) 0, 0);
-            else
-                RegionSubtract(*destRgnp, srcRgn, *destRgnp);
+            newRgn = RegionCreate((BoxPtr) 0, 0);
+            if (*destRgnp)
+                RegionSubtract(newRgn, srcRgn, *destRgnp);
             break;
         default:
+            RegionDestroy(srcRgn);
             client->errorValue = op;
             return BadValue;
         }
     if (srcRgn)
         RegionDestroy(srcRgn);
-    (*pWin->drawable.pScreen->SetShape) (pWin, kind);
+
+    changed = !ShapeRegionsEqual(*destRgnp, newRgn);
+    if (newRgn != *destRgnp) {
+        if (*destRgnp)
+            RegionDestroy(*destRgnp);
+        *destRgnp = newRgn;
+    }
+
+    /* Reapplying the current shape, which animated windows do for every
+     * frame that doesn't change their outline, only needs the event. */
+    if (changed)
+        (*pWin->drawable.pScreen->SetShape) (pWin, kind);
     SendShapeNotify(pWin, kind);
     return Success;
 }
@@ -356,7 +533,7 @@ ShapeMask(ClientPtr client, xShapeMaskReq *stuff)
         if (pPixmap->drawable.pScreen != pScreen ||
             pPixmap->drawable.depth != 1)
             return BadMatch;
-        srcRgn = BitmapToRegion(pScreen, pPixmap);
+        srcRgn = ShapeBitmapToRegion(pScreen, pPixmap);
         if (!srcRgn)
             return BadAlloc;
     }
@@ -572,7 +749,7 @@ ShapeOffset(ClientPtr client, xShapeOffsetReq *stuff)
         client->errorValue = stuff->destKind;
         return BadValue;
     }
-    if (srcRgn) {
+    if (srcRgn && (stuff->xOff || stuff->yOff)) {
         RegionTranslate(srcRgn, stuff->xOff, stuff->yOff);
         (*pWin->drawable.pScreen->SetShape) (pWin, stuff->destKind);
     }
@@ -1166,6 +1343,9 @@ ShapeExtensionInit(void)
 {
     ExtensionEntry *extEntry;
 
+    if (!dixRegisterPrivateKey(&ShapeScreenPrivateKeyRec, PRIVATE_SCREEN, 0))
+        return;
+
     ClientType = CreateNewResourceType(ShapeFreeClient, "ShapeClient");
     ShapeEventType = CreateNewResourceType(ShapeFreeEvents, "ShapeEvent");
     if (ClientType && ShapeEventType &&
@@ -1191,6 +1191,8 @@ FreeCounter(void *env, XID id)
             free(ptl); /* destroy the trigger list as we go */
         }
         if (IsSystemCounter(pCounter)) {
+            /* let the implementation drop any hooks it still has */
+            (*pCounter->pSysCounterInfo->BracketValues) (pCounter, NULL, NULL);
             xorg_list_del(&pCounter->pSysCounterInfo->entry);
             free(pCounter->pSysCounterInfo->name);
             free(pCounter->pSysCounterInfo->private);
@@ -2485,19 +2487,35 @@ SyncExtensionInit(void)
  * ***** SERVERTIME implementation - should go in its own file in OS directory?
  */
 
-static void *ServertimeCounter;
-static int64_t Now;
-static int64_t *pnext_time;
+/*
+ * SERVERTIME counts milliseconds, SERVERTIME_US microseconds of the
+ * server's monotonic clock.  Both only hook into the block and wakeup
+ * handlers while some trigger waits for them to pass a value.
+ */
+typedef struct {
+    SyncCounter *counter;
+    int64_t now;
+    int64_t *next_time;         /* bracket_greater, NULL if none */
+    int64_t units_per_ms;
+} ServertimeRec, *ServertimePtr;
 
-static void GetTime(void)
+static ServertimeRec ServertimeMillis = { .units_per_ms = 1 };
+static ServertimeRec ServertimeMicros = { .units_per_ms = 1000 };
+
+static void GetTime(ServertimePtr st)
 {
-    unsigned long millis = GetTimeInMillis();
-    unsigned long maxis = Now >> 32;
+    if (st == &ServertimeMicros) {
+        st->now = GetTimeInMicros();
+    }
+    else {
+        unsigned long millis = GetTimeInMillis();
+        unsigned long maxis = st->now >> 32;
 
-    if (millis < (Now & 0xffffffff))
-        maxis++;
+        if (millis < (st->now & 0xffffffff))
+            maxis++;
 
-    Now = ((int64_t)maxis << 32) | millis;
+        st->now = ((int64_t)maxis << 32) | millis;
+    }
 }
 
 /*
@@ -2507,16 +2525,19 @@ static void GetTime(void)
 /*ARGSUSED*/ static void
 ServertimeBlockHandler(void *env, void *wt)
 {
+    ServertimePtr st = env;
     unsigned long timeout;
 
-    if (pnext_time) {
-        GetTime();
+    if (st->next_time) {
+        GetTime(st);
 
-        if (Now >= *pnext_time) {
+        if (st->now >= *st->next_time) {
             timeout = 0;
         }
         else {
-            timeout = *pnext_time - Now;
+            /* round up, so we don't wake up just before the value */
+            timeout = (*st->next_time - st->now + st->units_per_ms - 1) /
+                st->units_per_ms;
         }
         AdjustWaitForDelay(wt, timeout);        /* os/utils.c */
     }
@@ -2528,35 +2549,57 @@ ServertimeBlockHandler(void *env, void *wt)
 /*ARGSUSED*/ static void
 ServertimeWakeupHandler(void *env, int rc)
 {
-    if (pnext_time) {
-        GetTime();
+    ServertimePtr st = env;
+
+    if (st->next_time) {
+        GetTime(st);
 
-        if (Now >= *pnext_time) {
-            SyncChangeCounter(ServertimeCounter, Now);
+        if (st->now >= *st->next_time) {
+            SyncChangeCounter(st->counter, st->now);
         }
     }
 }
 
+static void
+ServertimeSetBracket(ServertimePtr st, int64_t *pbracket_greater)
+{
+    if (!st->next_time && pbracket_greater) {
+        RegisterBlockAndWakeupHandlers(ServertimeBlockHandler,
+                                       ServertimeWakeupHandler, st);
+    }
+    else if (st->next_time && !pbracket_greater) {
+        RemoveBlockAndWakeupHandlers(ServertimeBlockHandler,
+                                     ServertimeWakeupHandler, st);
+    }
+    st->next_time = pbracket_greater;
+}
+
 static void
 ServertimeQueryValue(void *pCounter, int64_t *pValue_return)
 {
-    GetTime();
-    *pValue_return = Now;
+    GetTime(&ServertimeMillis);
+    *pValue_return = ServertimeMillis.now;
 }
 
 static void
 ServertimeBracketValues(void *pCounter, int64_t *pbracket_less,
                         int64_t *pbracket_greater)
 {
-    if (!pnext_time && pbracket_greater) {
-        RegisterBlockAndWakeupHandlers(ServertimeBlockHandler,
-                                       ServertimeWakeupHandler, NULL);
-    }
-    else if (pnext_time && !pbracket_greater) {
-        RemoveBlockAndWakeupHandlers(ServertimeBlockHandler,
-                                     ServertimeWakeupHandler, NULL);
-    }
-    pnext_time = pbracket_greater;
+    ServertimeSetBracket(&ServertimeMillis, pbracket_greater);
+}
+
+static void
+ServertimeMicrosQueryValue(void *pCounter, int64_t *pValue_return)
+{
+    GetTime(&ServertimeMicros);
+    *pValue_return = ServertimeMicros.now;
+}
+
+static void
+ServertimeMicrosBracketValues(void *pCounter, int64_t *pbracket_less,
+                              int64_t *pbracket_greater)
+{
+    ServertimeSetBracket(&ServertimeMicros, pbracket_greater);
 }
 
 static void
@@ -2564,12 +2607,23 @@ SyncInitServerTime(void)
 {
     int64_t resolution = 4;
 
-    Now = GetTimeInMillis();
-    ServertimeCounter = SyncCreateSystemCounter("SERVERTIME", Now, resolution,
-                                                XSyncCounterNeverDecreases,
-                                                ServertimeQueryValue,
-                                                ServertimeBracketValues);
-    pnext_time = NULL;
+    ServertimeMillis.now = GetTimeInMillis();
+    ServertimeMillis.next_time = NULL;
+    ServertimeMillis.counter =
+        SyncCreateSystemCounter("SERVERTIME", ServertimeMillis.now,
+                                resolution, XSyncCounterNeverDecreases,
+                                ServertimeQueryValue,
+                                ServertimeBracketValues);
+
+    /* alarms still only fire with the millisecond granularity of the
+     * server's poll timeout, but the value itself is exact */
+    ServertimeMicros.now = GetTimeInMicros();
+    ServertimeMicros.next_time = NULL;
+    ServertimeMicros.counter =
+        SyncCreateSystemCounter("SERVERTIME_US", ServertimeMicros.now,
+                                1, XSyncCounterNeverDecreases,
+                                ServertimeMicrosQueryValue,
+                                ServertimeMicrosBracketValues);
 }
 
 /*
@@ -2580,13 +2634,34 @@ typedef struct {
     int64_t *value_less;
     int64_t *value_greater;
     int deviceid;
+    SyncCounter *counter;
+    struct xorg_list entry;     /* in IdleCounterList while bracketed */
+    Bool deleted;               /* lost its brackets during the wakeup pass */
 } IdleCounterPriv;
 
+/*
+ * The idle counters that have brackets.  A single block and wakeup handler
+ * pair evaluates all of them once per dispatch cycle, reading the clock
+ * once, instead of one pair per counter each reading it again.
+ *
+ * Firing an alarm can free an Await, which unbrackets every counter it
+ * waits on, so counters are only marked deleted while the wakeup handler
+ * walks the list and are unlinked once it is done.
+ */
+static struct xorg_list IdleCounterList = { &IdleCounterList, &IdleCounterList };
+static Bool inIdleTimeWakeup;
+static Bool idleCounterDeleted;
+
+static int64_t
+IdleTimeAt(int deviceid, CARD32 now)
+{
+    return (CARD32) (now - LastEventTime(deviceid).milliseconds);
+}
+
 static void
 IdleTimeQueryValue(void *pCounter, int64_t *pValue_return)
 {
     int deviceid = XIAllDevices;
-    CARD32 idle;
 
     if (pCounter) {
         SyncCounter *counter = pCounter;
@@ -2594,28 +2669,21 @@ IdleTimeQueryValue(void *pCounter, int64_t *pValue_return)
         if (priv)
             deviceid = priv->deviceid;
     }
-    idle = GetTimeInMillis() - LastEventTime(deviceid).milliseconds;
-    *pValue_return = idle;
+    *pValue_return = IdleTimeAt(deviceid, GetTimeInMillis());
 }
 
 static void
-IdleTimeBlockHandler(void *pCounter, void *wt)
+IdleTimeBlockCounter(IdleCounterPriv *priv, void *wt, CARD32 now)
 {
-    SyncCounter *counter = pCounter;
-    IdleCounterPriv *priv = SysCounterGetPrivate(counter);
-    if (!priv)
-        return;
+    SyncCounter *counter = priv->counter;
     int64_t *less = priv->value_less;
     int64_t *greater = priv->value_greater;
     int64_t idle, old_idle;
-    SyncTriggerList *list = counter->sync.pTriglist;
+    SyncTriggerList *list;
     SyncTrigger *trig;
 
-    if (!less && !greater)
-        return;
-
     old_idle = counter->value;
-    IdleTimeQueryValue(counter, &idle);
+    idle = IdleTimeAt(priv->deviceid, now);
     counter->value = idle;      /* push, so CheckTrigger works */
 
     /**
@@ -2678,6 +2746,16 @@ IdleTimeBlockHandler(void *pCounter, void *wt)
     counter->value = old_idle;  /* pop */
 }
 
+static void
+IdleTimeBlockHandler(void *env, void *wt)
+{
+    IdleCounterPriv *priv;
+    CARD32 now = GetTimeInMillis();
+
+    xorg_list_for_each_entry(priv, &IdleCounterList, entry)
+        IdleTimeBlockCounter(priv, wt, now);
+}
+
 static void
 IdleTimeCheckBrackets(SyncCounter *counter, int64_t idle,
                       int64_t *less, int64_t *greater)
@@ -2691,20 +2769,12 @@ IdleTimeCheckBrackets(SyncCounter *counter, int64_t idle,
 }
 
 static void
-IdleTimeWakeupHandler(void *pCounter, int rc)
+IdleTimeWakeupCounter(IdleCounterPriv *priv, CARD32 now)
 {
-    SyncCounter *counter = pCounter;
-    IdleCounterPriv *priv = SysCounterGetPrivate(counter);
-    if (!priv)
-        return;
+    SyncCounter *counter = priv->counter;
     int64_t *less = priv->value_less;
     int64_t *greater = priv->value_greater;
-    int64_t idle;
-
-    if (!less && !greater)
-        return;
-
-    IdleTimeQueryValue(pCounter, &idle);
+    int64_t idle = IdleTimeAt(priv->deviceid, now);
 
     /*
       There is no guarantee for the WakeupHandler to be called within a specific
@@ -2724,6 +2794,33 @@ IdleTimeWakeupHandler(void *pCounter, int rc)
     IdleTimeCheckBrackets(counter, idle, less, greater);
 }
 
+static void
+IdleTimeWakeupHandler(void *env, int rc)
+{
+    IdleCounterPriv *priv, *next;
+    CARD32 now = GetTimeInMillis();
+
+    inIdleTimeWakeup = TRUE;
+    xorg_list_for_each_entry(priv, &IdleCounterList, entry) {
+        if (!priv->deleted)
+            IdleTimeWakeupCounter(priv, now);
+    }
+    inIdleTimeWakeup = FALSE;
+
+    if (idleCounterDeleted) {
+        xorg_list_for_each_entry_safe(priv, next, &IdleCounterList, entry) {
+            if (priv->deleted) {
+                priv->deleted = FALSE;
+                xorg_list_del(&priv->entry);
+            }
+        }
+        idleCounterDeleted = FALSE;
+        if (xorg_list_is_empty(&IdleCounterList))
+            RemoveBlockAndWakeupHandlers(IdleTimeBlockHandler,
+                                         IdleTimeWakeupHandler, NULL);
+    }
+}
+
 static void
 IdleTimeBracketValues(void *pCounter, int64_t *pbracket_less,
                       int64_t *pbracket_greater)
@@ -2732,20 +2829,34 @@ IdleTimeBracketValues(void *pCounter, int64_t *pbracket_less,
     IdleCounterPriv *priv = SysCounterGetPrivate(counter);
     if (!priv)
         return;
-    int64_t *less = priv->value_less;
-    int64_t *greater = priv->value_greater;
-    Bool registered = (less || greater);
+    Bool registered = (priv->value_less || priv->value_greater);
 
     if (registered && !pbracket_less && !pbracket_greater) {
-        RemoveBlockAndWakeupHandlers(IdleTimeBlockHandler,
-                                     IdleTimeWakeupHandler, pCounter);
+        if (inIdleTimeWakeup) {
+            priv->deleted = TRUE;
+            idleCounterDeleted = TRUE;
+        }
+        else {
+            xorg_list_del(&priv->entry);
+            if (xorg_list_is_empty(&IdleCounterList))
+                RemoveBlockAndWakeupHandlers(IdleTimeBlockHandler,
+                                             IdleTimeWakeupHandler, NULL);
+        }
     }
     else if (!registered && (pbracket_less || pbracket_greater)) {
         /* Reset flag must be zero so we don't force a idle timer reset on
-           the first wakeup */
-        LastEventTimeToggleResetAll(FALSE);
-        RegisterBlockAndWakeupHandlers(IdleTimeBlockHandler,
-                                       IdleTimeWakeupHandler, pCounter);
+           the first wakeup.  Only this counter's, the others are live. */
+        LastEventTimeToggleResetFlag(priv->deviceid, FALSE);
+        if (priv->deleted) {
+            /* unbracketed earlier in this wakeup pass, still linked */
+            priv->deleted = FALSE;
+        }
+        else {
+            if (xorg_list_is_empty(&IdleCounterList))
+                RegisterBlockAndWakeupHandlers(IdleTimeBlockHandler,
+                                               IdleTimeWakeupHandler, NULL);
+            xorg_list_append(&priv->entry, &IdleCounterList);
+        }
     }
 
     priv->value_greater = pbracket_greater;
@@ -2777,6 +2888,8 @@ init_system_idle_counter(const char *name, int deviceid)
 
     priv->value_less = priv->value_greater = NULL;
     priv->deviceid = deviceid;
+    priv->counter = idle_time_counter;
+    xorg_list_init(&priv->entry);
 
     idle_time_counter->pSysCounterInfo->private = priv;
     return idle_time_counter;
@@ -72,6 +72,8 @@ typedef struct PointerBarrierClient *PointerBarrierClientPtr;
 
 struct PointerBarrierDevice {
     struct xorg_list entry;
+    struct xorg_list hit_entry; /* in BarrierScreenRec.hits while hit is set */
+    struct PointerBarrierClient *client;
     int deviceid;
     Time last_timestamp;
     int barrier_event_id;
@@ -85,7 +87,7 @@ struct PointerBarrierClient {
     ScreenPtr screen;
     Window window;
     struct PointerBarrier barrier;
-    struct xorg_list entry;
+    unsigned int serial;        /* creation order, see barrier_find_nearest */
     /* num_devices/device_ids are devices the barrier applies to */
     int num_devices;
     int *device_ids; /* num_devices */
@@ -94,8 +96,18 @@ struct PointerBarrierClient {
     struct xorg_list per_device;
 };
 
+/* barriers of one orientation, sorted by the coordinate they sit at */
+struct BarrierIndex {
+    struct PointerBarrierClient **barriers;
+    int num;
+    int size;
+};
+
 typedef struct _BarrierScreen {
-    struct xorg_list barriers;
+    struct BarrierIndex vertical;       /* sorted by x */
+    struct BarrierIndex horizontal;     /* sorted by y */
+    struct xorg_list hits;      /* devices hitting a barrier, newest barrier first */
+    unsigned int next_serial;
 } BarrierScreenRec, *BarrierScreenPtr;
 
 #define GetBarrierScreen(s) ((BarrierScreenPtr)dixLookupPrivate(&(s)->devPrivates, BarrierScreenPrivateKey))
@@ -114,6 +126,7 @@ static struct PointerBarrierDevice *AllocBarrierDevice(void)
     pbd->hit = FALSE;
     pbd->seen = FALSE;
     xorg_list_init(&pbd->entry);
+    xorg_list_init(&pbd->hit_entry);
 
     return pbd;
 }
@@ -124,6 +137,7 @@ static void FreePointerBarrierClient(struct PointerBarrierClient *c)
 
     if (!xorg_list_is_empty(&c->per_device)) {
         xorg_list_for_each_entry_safe(pbd, tmp, &c->per_device, entry) {
+            xorg_list_del(&pbd->hit_entry);
             free(pbd);
         }
     }
@@ -156,6 +170,78 @@ barrier_is_vertical(const struct PointerBarrier *barrier)
     return barrier->x1 == barrier->x2;
 }
 
+static struct BarrierIndex *
+barrier_index_for(BarrierScreenPtr cs, const struct PointerBarrier *barrier)
+{
+    return barrier_is_vertical(barrier) ? &cs->vertical : &cs->horizontal;
+}
+
+static int
+barrier_index_key(const struct PointerBarrier *barrier)
+{
+    return barrier_is_vertical(barrier) ? barrier->x1 : barrier->y1;
+}
+
+/**
+ * @return The position of the first barrier in the index at or beyond key.
+ */
+static int
+barrier_index_lower_bound(const struct BarrierIndex *index, int key)
+{
+    int lo = 0, hi = index->num;
+
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+
+        if (barrier_index_key(&index->barriers[mid]->barrier) < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* callers hold the input lock */
+static Bool
+barrier_index_insert(struct BarrierIndex *index, struct PointerBarrierClient *c)
+{
+    int pos;
+
+    if (index->num == index->size) {
+        int size = index->size ? index->size * 2 : 16;
+        struct PointerBarrierClient **barriers =
+            reallocarray(index->barriers, size, sizeof(*barriers));
+
+        if (!barriers)
+            return FALSE;
+        index->barriers = barriers;
+        index->size = size;
+    }
+
+    pos = barrier_index_lower_bound(index, barrier_index_key(&c->barrier));
+    memmove(&index->barriers[pos + 1], &index->barriers[pos],
+            (index->num - pos) * sizeof(*index->barriers));
+    index->barriers[pos] = c;
+    index->num++;
+    return TRUE;
+}
+
+/* callers hold the input lock */
+static void
+barrier_index_remove(struct BarrierIndex *index, struct PointerBarrierClient *c)
+{
+    int pos = barrier_index_lower_bound(index, barrier_index_key(&c->barrier));
+
+    for (; pos < index->num; pos++) {
+        if (index->barriers[pos] == c) {
+            index->num--;
+            memmove(&index->barriers[pos], &index->barriers[pos + 1],
+                    (index->num - pos) * sizeof(*index->barriers));
+            return;
+        }
+    }
+}
+
 /**
  * @return The set of barrier movement directions the movement vector
  * x1/y1 → x2/y2 represents.
@@ -317,29 +403,24 @@ barrier_blocks_device(struct PointerBarrierClient *client,
     return FALSE;
 }
 
-/**
- * Find the nearest barrier client that is blocking movement from x1/y1 to x2/y2.
- *
- * @param dir Only barriers blocking movement in direction dir are checked
- * @param x1 X start coordinate of movement vector
- * @param y1 Y start coordinate of movement vector
- * @param x2 X end coordinate of movement vector
- * @param y2 Y end coordinate of movement vector
- * @return The barrier nearest to the movement origin that blocks this movement.
- */
-static struct PointerBarrierClient *
-barrier_find_nearest(BarrierScreenPtr cs, DeviceIntPtr dev,
-                     int dir,
-                     int x1, int y1, int x2, int y2)
+static void
+barrier_find_nearest_in(struct BarrierIndex *index, DeviceIntPtr dev, int dir,
+                        int lo, int hi,
+                        int x1, int y1, int x2, int y2,
+                        struct PointerBarrierClient **nearest,
+                        double *min_distance)
 {
-    struct PointerBarrierClient *c, *nearest = NULL;
-    double min_distance = INT_MAX;      /* can't get higher than that in X anyway */
+    int i;
 
-    xorg_list_for_each_entry(c, &cs->barriers, entry) {
+    for (i = barrier_index_lower_bound(index, lo); i < index->num; i++) {
+        struct PointerBarrierClient *c = index->barriers[i];
         struct PointerBarrier *b = &c->barrier;
         struct PointerBarrierDevice *pbd;
         double distance;
 
+        if (barrier_index_key(b) > hi)
+            break;
+
         pbd = GetBarrierDevice(c, dev->id);
         if (!pbd)
             continue;
@@ -354,12 +435,44 @@ barrier_find_nearest(BarrierScreenPtr cs, DeviceIntPtr dev,
             continue;
 
         if (barrier_is_blocking(b, x1, y1, x2, y2, &distance)) {
-            if (min_distance > distance) {
-                min_distance = distance;
-                nearest = c;
+            /* on a tie the newer barrier wins */
+            if (*min_distance > distance ||
+                (*min_distance == distance && *nearest &&
+                 (*nearest)->serial < c->serial)) {
+                *min_distance = distance;
+                *nearest = c;
             }
         }
     }
+}
+
+/**
+ * Find the nearest barrier client that is blocking movement from x1/y1 to x2/y2.
+ *
+ * Only barriers sitting between the start and end coordinate of the
+ * movement can block it, so just those are looked at.
+ *
+ * @param dir Only barriers blocking movement in direction dir are checked
+ * @param x1 X start coordinate of movement vector
+ * @param y1 Y start coordinate of movement vector
+ * @param x2 X end coordinate of movement vector
+ * @param y2 Y end coordinate of movement vector
+ * @return The barrier nearest to the movement origin that blocks this movement.
+ */
+static struct PointerBarrierClient *
+barrier_find_nearest(BarrierScreenPtr cs, DeviceIntPtr dev,
+                     int dir,
+                     int x1, int y1, int x2, int y2)
+{
+    struct PointerBarrierClient *nearest = NULL;
+    double min_distance = INT_MAX;      /* can't get higher than that in X anyway */
+
+    barrier_find_nearest_in(&cs->vertical, dev, dir,
+                            min(x1, x2), max(x1, x2), x1, y1, x2, y2,
+                            &nearest, &min_distance);
+    barrier_find_nearest_in(&cs->horizontal, dev, dir,
+                            min(y1, y2), max(y1, y2), x1, y1, x2, y2,
+                            &nearest, &min_distance);
 
     return nearest;
 }
@@ -390,6 +503,25 @@ barrier_clamp_to_barrier(struct PointerBarrier *barrier, int dir, int *x,
     }
 }
 
+/**
+ * Keep track of a device hitting a barrier, so the barrier can be checked
+ * for the device leaving it without going through all barriers.  The list
+ * is kept newest barrier first, the order leave events are sent in.
+ */
+static void
+barrier_add_hit(BarrierScreenPtr cs, struct PointerBarrierDevice *pbd)
+{
+    struct PointerBarrierDevice *p;
+
+    xorg_list_for_each_entry(p, &cs->hits, hit_entry) {
+        if (p->client->serial < pbd->client->serial) {
+            xorg_list_append(&pbd->hit_entry, &p->hit_entry);
+            return;
+        }
+    }
+    xorg_list_append(&pbd->hit_entry, &cs->hits);
+}
+
 void
 input_constrain_cursor(DeviceIntPtr dev, ScreenPtr screen,
                        int current_x, int current_y,
@@ -422,7 +554,7 @@ input_constrain_cursor(DeviceIntPtr dev, ScreenPtr screen,
     if (nevents)
         *nevents = 0;
 
-    if (xorg_list_is_empty(&cs->barriers) || InputDevIsFloating(dev))
+    if ((!cs->vertical.num && !cs->horizontal.num) || InputDevIsFloating(dev))
         goto out;
 
     /**
@@ -457,6 +589,8 @@ input_constrain_cursor(DeviceIntPtr dev, ScreenPtr screen,
 
         new_sequence = !pbd->hit;
 
+        if (!pbd->hit)
+            barrier_add_hit(cs, pbd);
         pbd->seen = TRUE;
         pbd->hit = TRUE;
 
@@ -490,22 +624,23 @@ input_constrain_cursor(DeviceIntPtr dev, ScreenPtr screen,
         *nevents += 1;
     }
 
-    xorg_list_for_each_entry(c, &cs->barriers, entry) {
-        struct PointerBarrierDevice *pbd;
+    /* only barriers already hit can be left */
+    struct PointerBarrierDevice *pbd, *tmp;
+
+    xorg_list_for_each_entry_safe(pbd, tmp, &cs->hits, hit_entry) {
         int flags = 0;
 
-        pbd = GetBarrierDevice(c, master->id);
-        if (!pbd)
+        if (pbd->deviceid != master->id)
             continue;
 
+        c = pbd->client;
         pbd->seen = FALSE;
-        if (!pbd->hit)
-            continue;
 
         if (barrier_inside_hit_box(&c->barrier, x, y))
             continue;
 
         pbd->hit = FALSE;
+        xorg_list_del(&pbd->hit_entry);
 
         ev.type = ET_BarrierLeave;
 
@@ -621,6 +756,7 @@ CreatePointerBarrierClient(ClientPtr client,
             goto error;
         }
         pbd->deviceid = dev->id;
+        pbd->client = ret;
 
         input_lock();
         xorg_list_add(&pbd->entry, &ret->per_device);
@@ -640,7 +776,12 @@ CreatePointerBarrierClient(ClientPtr client,
     if (barrier_is_vertical(&ret->barrier))
         ret->barrier.directions &= ~(BarrierPositiveY | BarrierNegativeY);
     input_lock();
-    xorg_list_add(&ret->entry, &cs->barriers);
+    ret->serial = cs->next_serial++;
+    if (!barrier_index_insert(barrier_index_for(cs, &ret->barrier), ret)) {
+        input_unlock();
+        err = BadAlloc;
+        goto error;
+    }
     input_unlock();
 
     *client_out = ret;
@@ -708,10 +849,10 @@ BarrierFreeBarrier(void *data, XID id)
     }
 
     input_lock();
-    xorg_list_del(&c->entry);
+    barrier_index_remove(barrier_index_for(GetBarrierScreen(screen), &c->barrier), c);
+    FreePointerBarrierClient(c);
     input_unlock();
 
-    FreePointerBarrierClient(c);
     return Success;
 }
 
@@ -728,6 +869,7 @@ static void add_master_func(void *res, XID id, void *devid)
     if (!pbd)
         return;
     pbd->deviceid = *deviceid;
+    pbd->client = barrier;
 
     input_lock();
     xorg_list_add(&pbd->entry, &barrier->per_device);
@@ -778,6 +920,7 @@ static void remove_master_func(void *res, XID id, void *devid)
 
     input_lock();
     xorg_list_del(&pbd->entry);
+    xorg_list_del(&pbd->hit_entry);
     input_unlock();
     free(pbd);
 }
@@ -944,7 +1087,7 @@ XIBarrierInit(void)
         cs = (BarrierScreenPtr) calloc(1, sizeof(BarrierScreenRec));
         if (!cs)
             return FALSE;
-        xorg_list_init(&cs->barriers);
+        xorg_list_init(&cs->hits);
         SetBarrierScreen(walkScreen, cs);
     }
 
@@ -961,6 +1104,10 @@ XIBarrierReset(void)
     for (i = 0; i < screenInfo.numScreens; i++) {
         ScreenPtr walkScreen = screenInfo.screens[i];
         BarrierScreenPtr cs = GetBarrierScreen(walkScreen);
+        if (cs) {
+            free(cs->vertical.barriers);
+            free(cs->horizontal.barriers);
+        }
         free(cs);
         SetBarrierScreen(walkScreen, NULL);
     }
@@ -58,6 +58,13 @@ static DevPrivateKeyRec DamageClientPrivateKeyRec;
 
 Bool noDamageExtension = FALSE;
 
+int damageBatchInterval = -1;
+
+/* Above this many rectangles, batched damage is sent as its extents */
+#define DAMAGE_BATCH_MAX_RECTS 64
+
+static struct xorg_list damageExtPending;
+
 static void
 DamageNoteCritical(ClientPtr pClient)
 {
@@ -137,6 +144,73 @@ DamageExtNotify(DamageExtPtr pDamageExt, BoxPtr pBoxes, int nBoxes)
     DamageNoteCritical(pClient);
 }
 
+/*
+ * With -damagebatch, rectangle reports are accumulated per damage object
+ * and sent from the block handler, at most once per interval per client.
+ */
+static void
+DamageExtQueue(DamageExtPtr pDamageExt, RegionPtr pRegion)
+{
+    RegionPtr pending = &pDamageExt->pending;
+
+    pDamageExt->batched_rects += RegionNumRects(pRegion);
+    if (!RegionUnion(pending, pending, pRegion) ||
+        RegionNumRects(pending) > DAMAGE_BATCH_MAX_RECTS) {
+        BoxRec extents = *RegionExtents(pending);
+
+        RegionUninit(pending);
+        RegionInit(pending, &extents, 1);
+    }
+
+    if (xorg_list_is_empty(&pDamageExt->pending_entry))
+        xorg_list_append(&pDamageExt->pending_entry, &damageExtPending);
+}
+
+static void
+DamageExtSendPending(DamageExtPtr pDamageExt)
+{
+    RegionPtr pending = &pDamageExt->pending;
+
+    if (RegionNotEmpty(pending)) {
+        pDamageExt->sent_rects += RegionNumRects(pending);
+        DamageExtNotify(pDamageExt, RegionRects(pending),
+                        RegionNumRects(pending));
+    }
+    xorg_list_del(&pDamageExt->pending_entry);
+    RegionEmpty(pending);
+}
+
+static void
+DamageExtBlockHandler(void *data, void *timeout)
+{
+    DamageExtPtr pDamageExt, tmp;
+    DamageClientPtr pDamageClient;
+    CARD32 now, elapsed;
+
+    if (xorg_list_is_empty(&damageExtPending))
+        return;
+
+    /* decide per client first, so that all of a client's damage objects
+     * go out in the same batch */
+    now = GetTimeInMillis();
+    xorg_list_for_each_entry(pDamageExt, &damageExtPending, pending_entry) {
+        pDamageClient = GetDamageClient(pDamageExt->pClient);
+        elapsed = now - pDamageClient->last_batch;
+        pDamageClient->batch_due = elapsed >= (CARD32) damageBatchInterval;
+        if (!pDamageClient->batch_due)
+            AdjustWaitForDelay(timeout, damageBatchInterval - elapsed);
+    }
+
+    xorg_list_for_each_entry_safe(pDamageExt, tmp, &damageExtPending,
+                                  pending_entry) {
+        pDamageClient = GetDamageClient(pDamageExt->pClient);
+        if (pDamageClient->batch_due) {
+            pDamageClient->last_batch = now;
+            DamageExtSendPending(pDamageExt);
+        }
+    }
+}
+
 static void
 DamageExtReport(DamagePtr pDamage, RegionPtr pRegion, void *closure)
 {
@@ -145,8 +219,11 @@ DamageExtReport(DamagePtr pDamage, RegionPtr pRegion, void *closure)
     switch (pDamageExt->level) {
     case DamageReportRawRegion:
     case DamageReportDeltaRegion:
-        DamageExtNotify(pDamageExt, RegionRects(pRegion),
-                        RegionNumRects(pRegion));
+        if (damageBatchInterval >= 0)
+            DamageExtQueue(pDamageExt, pRegion);
+        else
+            DamageExtNotify(pDamageExt, RegionRects(pRegion),
+                            RegionNumRects(pRegion));
         break;
     case DamageReportBoundingBox:
         DamageExtNotify(pDamageExt, RegionExtents(pRegion), 1);
@@ -236,6 +313,8 @@ DamageExtCreate(DrawablePtr pDrawable, DamageReportLevel level,
     pDamageExt->pDrawable = pDrawable;
     pDamageExt->level = level;
     pDamageExt->pClient = client;
+    RegionNull(&pDamageExt->pending);
+    xorg_list_init(&pDamageExt->pending_entry);
     pDamageExt->pDamage = DamageCreate(DamageExtReport, DamageExtDestroy, level,
                                        FALSE, pDrawable->pScreen, pDamageExt);
     if (!pDamageExt->pDamage) {
@@ -566,6 +645,13 @@ FreeDamageExt(void *value, XID did)
     if (pDamageExt->pDamage) {
         DamageDestroy(pDamageExt->pDamage);
     }
+    if (pDamageExt->batched_rects)
+        LogMessageVerb(X_INFO, 5,
+                       "damage 0x%x: sent %u of %u reported rectangles\n",
+                       (unsigned int) did, pDamageExt->sent_rects,
+                       pDamageExt->batched_rects);
+    xorg_list_del(&pDamageExt->pending_entry);
+    RegionUninit(&pDamageExt->pending);
     free(pDamageExt);
     return Success;
 }
@@ -724,6 +810,13 @@ DamageExtensionInit(void)
         (&DamageClientPrivateKeyRec, PRIVATE_CLIENT, sizeof(DamageClientRec)))
         return;
 
+    xorg_list_init(&damageExtPending);
+    if (damageBatchInterval >= 0 &&
+        !RegisterBlockAndWakeupHandlers(DamageExtBlockHandler,
+                                        (ServerWakeupHandlerProcPtr) NoopDDA,
+                                        NULL))
+        return;
+
     if ((extEntry = AddExtension(DAMAGE_NAME, XDamageNumberEvents,
                                  XDamageNumberErrors,
                                  ProcDamageDispatch, SProcDamageDispatch,
@@ -30,6 +30,7 @@
 
 #include "dix/selection_priv.h"
 
+#include "list.h"
 #include "misc.h"
 #include "os.h"
 #include "dixstruct.h"
@@ -43,6 +44,8 @@ typedef struct _DamageClient {
     CARD32 major_version;
     CARD32 minor_version;
     int critical;
+    CARD32 last_batch;          /* time batched damage was last sent */
+    Bool batch_due;
 } DamageClientRec, *DamageClientPtr;
 
 #define GetDamageClient(pClient) ((DamageClientPtr)dixLookupPrivate(&(pClient)->devPrivates, DamageClientPrivateKey))
@@ -54,6 +57,10 @@ typedef struct _DamageExt {
     ClientPtr pClient;
     XID id;
     XID drawable;
+    RegionRec pending;          /* batched damage not yet sent */
+    struct xorg_list pending_entry;
+    CARD32 batched_rects;       /* rectangles reported while batching */
+    CARD32 sent_rects;          /* rectangles actually sent for those */
 } DamageExtRec, *DamageExtPtr;
 
 #define VERIFY_DAMAGEEXT(pDamageExt, rid, client, mode) { \
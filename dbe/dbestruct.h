@@ -38,6 +38,7 @@
 #include <X11/extensions/dbeproto.h>
 #include "windowstr.h"
 #include "privates.h"
+#include "damage.h"
 
 typedef struct {
     VisualID visual;            /* one visual ID that supports double-buffering */
@@ -156,6 +157,16 @@ typedef struct _DbeWindowPrivRec {
      */
     PixmapPtr pFrontBuffer;
 
+    /* Drawing to the back buffer and to the window since the last swap, and
+     * the (window relative) part of the window that was visible then.  The
+     * MI swap uses these to copy only what changed; swapValid is FALSE when
+     * the next swap has to copy the whole buffer.
+     */
+    DamagePtr pBackDamage;
+    DamagePtr pFrontDamage;
+    RegionRec swapVisible;
+    Bool swapValid;
+
     /* Device-specific private information.
      */
     PrivateRec *devPrivates;
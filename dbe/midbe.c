@@ -117,6 +117,147 @@ miDbeGetVisualInfo(ScreenPtr pScreen, XdbeScreenVisualInfo * pScrVisInfo)
 
 }                               /* miDbeGetVisualInfo() */
 
+/******************************************************************************
+ *
+ * DBE MI Procedure: miDbeTrackDamage
+ *
+ * Description:
+ *
+ *     These functions record drawing to the back buffer and to the window
+ *     between swaps.  As long as the window showed the back buffer after the
+ *     last swap, the next swap only needs to copy what was drawn to either
+ *     of them since, plus whatever part of the window was exposed meanwhile.
+ *     Without damage records every swap copies the whole buffer.
+ *
+ *****************************************************************************/
+
+static void
+miDbeDamageDestroy(DamagePtr pDamage, void *closure)
+{
+    DbeWindowPrivPtr pDbeWindowPriv = closure;
+
+    if (pDbeWindowPriv->pBackDamage == pDamage)
+        pDbeWindowPriv->pBackDamage = NULL;
+    if (pDbeWindowPriv->pFrontDamage == pDamage)
+        pDbeWindowPriv->pFrontDamage = NULL;
+    pDbeWindowPriv->swapValid = FALSE;
+}
+
+static void
+miDbeTrackDamage(WindowPtr pWin, DbeWindowPrivPtr pDbeWindowPriv)
+{
+    ScreenPtr pScreen = pWin->drawable.pScreen;
+
+    RegionNull(&pDbeWindowPriv->swapVisible);
+    pDbeWindowPriv->swapValid = FALSE;
+
+    pDbeWindowPriv->pBackDamage =
+        DamageCreate(NULL, miDbeDamageDestroy, DamageReportNone, TRUE,
+                     pScreen, pDbeWindowPriv);
+    pDbeWindowPriv->pFrontDamage =
+        DamageCreate(NULL, miDbeDamageDestroy, DamageReportNone, TRUE,
+                     pScreen, pDbeWindowPriv);
+
+    if (!pDbeWindowPriv->pBackDamage || !pDbeWindowPriv->pFrontDamage) {
+        if (pDbeWindowPriv->pBackDamage)
+            DamageDestroy(pDbeWindowPriv->pBackDamage);
+        if (pDbeWindowPriv->pFrontDamage)
+            DamageDestroy(pDbeWindowPriv->pFrontDamage);
+        return;
+    }
+
+    DamageRegister(&pDbeWindowPriv->pBackBuffer->drawable,
+                   pDbeWindowPriv->pBackDamage);
+    DamageRegister(&pWin->drawable, pDbeWindowPriv->pFrontDamage);
+}
+
+static void
+miDbeUntrackDamage(DbeWindowPrivPtr pDbeWindowPriv)
+{
+    if (pDbeWindowPriv->pBackDamage)
+        DamageDestroy(pDbeWindowPriv->pBackDamage);
+    if (pDbeWindowPriv->pFrontDamage)
+        DamageDestroy(pDbeWindowPriv->pFrontDamage);
+    RegionUninit(&pDbeWindowPriv->swapVisible);
+}
+
+/*
+ * The back buffer pixmap was replaced, move its damage record along and
+ * make the next swap a full one.
+ */
+static void
+miDbeBackBufferChanged(DbeWindowPrivPtr pDbeWindowPriv)
+{
+    if (pDbeWindowPriv->pBackDamage) {
+        DamageUnregister(pDbeWindowPriv->pBackDamage);
+        DamageRegister(&pDbeWindowPriv->pBackBuffer->drawable,
+                       pDbeWindowPriv->pBackDamage);
+    }
+    pDbeWindowPriv->swapValid = FALSE;
+}
+
+/*
+ * Returns the window relative region the swap has to copy, or NULL if
+ * it has to copy everything.
+ */
+static RegionPtr
+miDbeSwapRegion(WindowPtr pWin, DbeWindowPrivPtr pDbeWindowPriv)
+{
+    RegionPtr pRegion;
+    RegionRec exposed;
+    BoxRec box;
+
+    if (!pDbeWindowPriv->swapValid || !pDbeWindowPriv->pBackDamage ||
+        !pDbeWindowPriv->pFrontDamage)
+        return NULL;
+
+    if (!(pRegion = RegionCreate(NullBox, 0)))
+        return NULL;
+
+    RegionUnion(pRegion, DamageRegion(pDbeWindowPriv->pBackDamage),
+                DamageRegion(pDbeWindowPriv->pFrontDamage));
+
+    /* newly exposed parts of the window may hold anything */
+    RegionNull(&exposed);
+    RegionCopy(&exposed, &pWin->clipList);
+    RegionTranslate(&exposed, -pWin->drawable.x, -pWin->drawable.y);
+    RegionSubtract(&exposed, &exposed, &pDbeWindowPriv->swapVisible);
+    RegionUnion(pRegion, pRegion, &exposed);
+    RegionUninit(&exposed);
+
+    box.x1 = 0;
+    box.y1 = 0;
+    box.x2 = pWin->drawable.width;
+    box.y2 = pWin->drawable.height;
+    if (RegionContainsRect(pRegion, &box) == rgnIN) {
+        RegionDestroy(pRegion);
+        return NULL;
+    }
+    RegionInit(&exposed, &box, 1);
+    RegionIntersect(pRegion, pRegion, &exposed);
+    RegionUninit(&exposed);
+
+    return pRegion;
+}
+
+/*
+ * The window shows the back buffer now, start recording from scratch.
+ */
+static void
+miDbeSwapDone(WindowPtr pWin, DbeWindowPrivPtr pDbeWindowPriv)
+{
+    if (!pDbeWindowPriv->pBackDamage || !pDbeWindowPriv->pFrontDamage)
+        return;
+
+    DamageEmpty(pDbeWindowPriv->pBackDamage);
+    DamageEmpty(pDbeWindowPriv->pFrontDamage);
+
+    pDbeWindowPriv->swapValid =
+        RegionCopy(&pDbeWindowPriv->swapVisible, &pWin->clipList);
+    RegionTranslate(&pDbeWindowPriv->swapVisible,
+                    -pWin->drawable.x, -pWin->drawable.y);
+}
+
 /******************************************************************************
  *
  * DBE MI Procedure: miAllocBackBufferName
@@ -191,6 +332,8 @@ miDbeAllocBackBufferName(WindowPtr pWin, XID bufId, int swapAction)
         }
         FreeScratchGC(pGC);
 
+        miDbeTrackDamage(pWin, pDbeWindowPriv);
+
     }                           /* if no buffer associated with the window */
 
     else {
@@ -233,6 +376,99 @@ miDbeAliasBuffers(DbeWindowPrivPtr pDbeWindowPriv)
 
 }                               /* miDbeAliasBuffers() */
 
+/******************************************************************************
+ *
+ * DBE MI Procedure: miDbeExchangeBuffers
+ *
+ * Description:
+ *
+ *     A window redirected by Composite has a pixmap of its own.  If nothing
+ *     else holds a reference to that pixmap and it matches the back buffer,
+ *     the swap can hand the back buffer to the window as its new pixmap and
+ *     keep the old window pixmap as back buffer, instead of copying.  The
+ *     old contents end up in the back buffer, which is just what
+ *     XdbeUntouched asks for; XdbeUndefined doesn't care and XdbeBackground
+ *     clears it afterwards anyway.  XdbeCopied needs the back buffer intact,
+ *     so it always copies.
+ *
+ *****************************************************************************/
+
+static Bool
+miDbeCanExchange(WindowPtr pWin, DbeWindowPrivPtr pDbeWindowPriv,
+                 int swapAction)
+{
+    ScreenPtr pScreen = pWin->drawable.pScreen;
+    PixmapPtr pWinPixmap, pBackBuffer = pDbeWindowPriv->pBackBuffer;
+
+    if (swapAction == XdbeCopied)
+        return FALSE;
+
+    /* the pixmap must cover exactly this window and nothing else */
+    if (pWin->redirectDraw == RedirectDrawNone || pWin->firstChild ||
+        wBorderWidth(pWin) || !pScreen->GetWindowPixmap ||
+        !pScreen->SetWindowPixmap)
+        return FALSE;
+
+    pWinPixmap = (*pScreen->GetWindowPixmap) (pWin);
+
+    /* a named window pixmap must keep showing the window */
+    return pWinPixmap->refcnt == 1 &&
+        pWinPixmap != (*pScreen->GetScreenPixmap) (pScreen) &&
+        pWinPixmap->drawable.width == pBackBuffer->drawable.width &&
+        pWinPixmap->drawable.height == pBackBuffer->drawable.height &&
+        pWinPixmap->drawable.depth == pBackBuffer->drawable.depth &&
+        pWinPixmap->drawable.bitsPerPixel == pBackBuffer->drawable.bitsPerPixel;
+}
+
+static void
+miDbeExchangeBuffers(WindowPtr pWin, DbeWindowPrivPtr pDbeWindowPriv)
+{
+    ScreenPtr pScreen = pWin->drawable.pScreen;
+    PixmapPtr pWinPixmap = (*pScreen->GetWindowPixmap) (pWin);
+    PixmapPtr pBackBuffer = pDbeWindowPriv->pBackBuffer;
+
+    pBackBuffer->screen_x = pWinPixmap->screen_x;
+    pBackBuffer->screen_y = pWinPixmap->screen_y;
+    pWinPixmap->screen_x = 0;
+    pWinPixmap->screen_y = 0;
+
+    (*pScreen->SetWindowPixmap) (pWin, pBackBuffer);
+    pWin->drawable.serialNumber = NEXT_SERIAL_NUMBER;
+
+    pDbeWindowPriv->pBackBuffer = pWinPixmap;
+    miDbeAliasBuffers(pDbeWindowPriv);
+    miDbeBackBufferChanged(pDbeWindowPriv);
+
+    /* all of the window changed, tell the compositing manager */
+    DamageDamageRegion(&pWin->drawable, &pWin->borderClip);
+}
+
+/*
+ * Copy the back buffer to the window, limited to what changed since the
+ * previous swap where possible.
+ */
+static void
+miDbeCopyBuffers(WindowPtr pWin, DbeWindowPrivPtr pDbeWindowPriv, GCPtr pGC)
+{
+    RegionPtr pCopyRegion = miDbeSwapRegion(pWin, pDbeWindowPriv);
+
+    if (!pCopyRegion || RegionNotEmpty(pCopyRegion)) {
+        if (pCopyRegion)
+            (*pGC->funcs->ChangeClip) (pGC, CT_REGION, pCopyRegion, 0);
+        ValidateGC((DrawablePtr) pWin, pGC);
+        (void) (*pGC->ops->CopyArea) ((DrawablePtr) pDbeWindowPriv->pBackBuffer,
+                                      (DrawablePtr) pWin, pGC, 0, 0,
+                                      pWin->drawable.width,
+                                      pWin->drawable.height, 0, 0);
+        if (pCopyRegion)
+            (*pGC->funcs->ChangeClip) (pGC, CT_NONE, NULL, 0);
+    }
+    else
+        RegionDestroy(pCopyRegion);
+
+    miDbeSwapDone(pWin, pDbeWindowPriv);
+}
+
 /******************************************************************************
  *
  * DBE MI Procedure: miDbeSwapBuffers
@@ -252,11 +488,13 @@ miDbeSwapBuffers(ClientPtr client, int *pNumWindows, DbeSwapInfoPtr swapInfo)
     WindowPtr pWin;
     PixmapPtr pTmpBuffer;
     xRectangle clearRect;
+    Bool exchange;
 
     pWin = swapInfo[0].pWindow;
     pDbeScreenPriv = DBE_SCREEN_PRIV_FROM_WINDOW(pWin);
     pDbeWindowPriv = DBE_WINDOW_PRIV(pWin);
     pGC = GetScratchGC(pWin->drawable.depth, pWin->drawable.pScreen);
+    exchange = miDbeCanExchange(pWin, pDbeWindowPriv, swapInfo[0].swapAction);
 
     /*
      **********************************************************************
@@ -272,6 +510,8 @@ miDbeSwapBuffers(ClientPtr client, int *pNumWindows, DbeSwapInfoPtr swapInfo)
         break;
 
     case XdbeUntouched:
+        if (exchange)
+            break;
         ValidateGC((DrawablePtr) pDbeWindowPriv->pFrontBuffer, pGC);
         (void) (*pGC->ops->CopyArea) ((DrawablePtr) pWin,
                                       (DrawablePtr) pDbeWindowPriv->pFrontBuffer,
@@ -290,11 +530,10 @@ miDbeSwapBuffers(ClientPtr client, int *pNumWindows, DbeSwapInfoPtr swapInfo)
      **********************************************************************
      */
 
-    ValidateGC((DrawablePtr) pWin, pGC);
-    (void) (*pGC->ops->CopyArea) ((DrawablePtr) pDbeWindowPriv->pBackBuffer,
-                                  (DrawablePtr) pWin, pGC, 0, 0,
-                                  pWin->drawable.width,
-                                  pWin->drawable.height, 0, 0);
+    if (exchange)
+        miDbeExchangeBuffers(pWin, pDbeWindowPriv);
+    else
+        miDbeCopyBuffers(pWin, pDbeWindowPriv, pGC);
 
     /*
      **********************************************************************
@@ -319,12 +558,15 @@ miDbeSwapBuffers(ClientPtr client, int *pNumWindows, DbeSwapInfoPtr swapInfo)
         break;
 
     case XdbeUntouched:
+        if (exchange)
+            break;
         /* Swap pixmap pointers. */
         pTmpBuffer = pDbeWindowPriv->pBackBuffer;
         pDbeWindowPriv->pBackBuffer = pDbeWindowPriv->pFrontBuffer;
         pDbeWindowPriv->pFrontBuffer = pTmpBuffer;
 
         miDbeAliasBuffers(pDbeWindowPriv);
+        miDbeBackBufferChanged(pDbeWindowPriv);
 
         break;
 
@@ -424,6 +666,8 @@ miDbeWinPrivDelete(DbeWindowPrivPtr pDbeWindowPriv, XID bufId)
      * free some stuff.
      */
 
+    miDbeUntrackDamage(pDbeWindowPriv);
+
     /* Destroy the front and back pixmaps. */
     if (pDbeWindowPriv->pFrontBuffer)
          dixDestroyPixmap(pDbeWindowPriv->pFrontBuffer, 0);
@@ -591,15 +835,19 @@ void miDbeWindowPosition(CallbackListPtr *pcbl, ScreenPtr pScreen, XorgScreenWin
                                           destx, desty);
         }
 
-        /* Destroy the old pixmaps, and point the DBE window priv to the new
-         * pixmaps.
+        /* Point the DBE window priv to the new pixmaps, and destroy the old
+         * ones once the back buffer damage moved off them.
          */
 
-        dixDestroyPixmap(pDbeWindowPriv->pFrontBuffer, 0);
-        dixDestroyPixmap(pDbeWindowPriv->pBackBuffer, 0);
+        PixmapPtr pOldFrontBuffer = pDbeWindowPriv->pFrontBuffer;
+        PixmapPtr pOldBackBuffer = pDbeWindowPriv->pBackBuffer;
 
         pDbeWindowPriv->pFrontBuffer = pFrontBuffer;
         pDbeWindowPriv->pBackBuffer = pBackBuffer;
+        miDbeBackBufferChanged(pDbeWindowPriv);
+
+        dixDestroyPixmap(pOldFrontBuffer, 0);
+        dixDestroyPixmap(pOldBackBuffer, 0);
 
         /* Make sure all XID are associated with the new back pixmap. */
         miDbeAliasBuffers(pDbeWindowPriv);
@@ -621,6 +869,10 @@ void miDbeWindowPosition(CallbackListPtr *pcbl, ScreenPtr pScreen, XorgScreenWin
 Bool
 miDbeInit(ScreenPtr pScreen, DbeScreenPrivPtr pDbeScreenPriv)
 {
+    /* swaps only copy what was damaged since the previous one */
+    if (!DamageSetup(pScreen))
+        return FALSE;
+
     dixScreenHookWindowPosition(pScreen, miDbeWindowPosition);
 
     /* Initialize the per-screen DBE function pointers. */
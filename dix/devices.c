@@ -837,8 +837,11 @@ FreeDeviceClass(int type, void **class)
             free((*t)->touches[i].sprite.spriteTrace);
             free((*t)->touches[i].listeners);
             free((*t)->touches[i].valuators);
+            if (i >= (*t)->history_pool_touches)
+                free((*t)->touches[i].history_buffer);
         }
 
+        free((*t)->history_pool);
         free((*t)->touches);
         free((*t));
         break;
@@ -1651,6 +1654,12 @@ InitTouchClassDeviceStruct(DeviceIntPtr device, unsigned int max_touches,
     if (!touch->touches)
         goto err;
     touch->num_touches = max_touches;
+    /* one history per touch, handed out by TouchInitTouchPoint() */
+    touch->history_pool = calloc((size_t)max_touches * TOUCH_HISTORY_SIZE,
+                                 sizeof(*touch->history_pool));
+    if (!touch->history_pool)
+        goto err;
+    touch->history_pool_touches = max_touches;
     for (int i = 0; i < max_touches; i++)
         TouchInitTouchPoint(touch, device->valuator, i);
 
@@ -1670,6 +1679,7 @@ InitTouchClassDeviceStruct(DeviceIntPtr device, unsigned int max_touches,
     for (int i = 0; i < touch->num_touches; i++)
         TouchFreeTouchPoint(device, i);
 
+    free(touch->history_pool);
     free(touch->touches);
     free(touch);
 
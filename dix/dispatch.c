@@ -2103,6 +2103,23 @@ ProcPutImage(ClientPtr client)
     return Success;
 }
 
+/*
+ * The image bands are fetched straight into the client's output buffer,
+ * which may still hold bytes of another client.  Clear what GetImage won't
+ * write: the line pad past the first lineBytes of each line, or the whole
+ * band if lineBytes is 0.
+ */
+static void
+ClearImageBand(char *pBuf, int nlines, long widthBytesLine, long lineBytes)
+{
+    if (lineBytes == 0) {
+        memset(pBuf, 0, nlines * widthBytesLine);
+        return;
+    }
+    for (int i = 0; i < nlines; i++, pBuf += widthBytesLine)
+        memset(pBuf + lineBytes, 0, widthBytesLine - lineBytes);
+}
+
 static int
 DoGetImage(ClientPtr client, int format, Drawable drawable,
            int x, int y, int width, int height,
@@ -2114,7 +2131,7 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
 
     /* coordinates relative to the bounding drawable */
     int relx, rely;
-    long widthBytesLine, length;
+    long widthBytesLine, lineBytes, length;
     Mask plane = 0;
     char *pBuf;
     RegionPtr pVisibleRegion = NULL;
@@ -2204,6 +2221,16 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
 
     rep.length = bytes_to_int32(length);
 
+    /* whole bytes GetImage writes per line; a partial last byte is
+     * cleared along with the pad, as fb only merges bits into it */
+    if (pDraw->type == DRAWABLE_WINDOW &&
+        !RegionNotEmpty(&((WindowPtr) pDraw)->borderClip))
+        lineBytes = 0;          /* disabled, e.g. VT switched away */
+    else if (format == ZPixmap)
+        lineBytes = (long) width * BitsPerPixel(pDraw->depth) / 8;
+    else
+        lineBytes = width / 8;
+
     if (widthBytesLine == 0 || height == 0)
         linesPerBuf = 0;
     else if (widthBytesLine >= IMAGE_BUFSIZE)
@@ -2226,9 +2253,6 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
             length += widthBytesLine;
         }
     }
-    if (!(pBuf = calloc(1, length)))
-        return BadAlloc;
-
     if (client->swapped) {
         swaps(&rep.sequenceNumber);
         swapl(&rep.length);
@@ -2249,6 +2273,10 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
         linesDone = 0;
         while (height - linesDone > 0) {
             nlines = min(linesPerBuf, height - linesDone);
+            if (!(pBuf = ReserveClientOutput(client, nlines * widthBytesLine)))
+                return Success;
+            if (lineBytes < widthBytesLine)
+                ClearImageBand(pBuf, nlines, widthBytesLine, lineBytes);
             (*pDraw->pScreen->GetImage) (pDraw,
                                          x,
                                          y + linesDone,
@@ -2264,7 +2292,7 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
             ReformatImage(pBuf, (int) (nlines * widthBytesLine),
                           BitsPerPixel(pDraw->depth), ClientOrder(client));
 
-            WriteToClient(client, (int) (nlines * widthBytesLine), pBuf);
+            CommitClientOutput(client, (int) (nlines * widthBytesLine));
             linesDone += nlines;
         }
     }
@@ -2275,6 +2303,13 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
                 linesDone = 0;
                 while (height - linesDone > 0) {
                     nlines = min(linesPerBuf, height - linesDone);
+                    pBuf = ReserveClientOutput(client,
+                                               nlines * widthBytesLine);
+                    if (!pBuf)
+                        return Success;
+                    if (lineBytes < widthBytesLine)
+                        ClearImageBand(pBuf, nlines, widthBytesLine,
+                                       lineBytes);
                     (*pDraw->pScreen->GetImage) (pDraw,
                                                  x,
                                                  y + linesDone,
@@ -2291,13 +2326,12 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
                     ReformatImage(pBuf, (int) (nlines * widthBytesLine),
                                   1, ClientOrder(client));
 
-                    WriteToClient(client, (int)(nlines * widthBytesLine), pBuf);
+                    CommitClientOutput(client, (int) (nlines * widthBytesLine));
                     linesDone += nlines;
                 }
             }
         }
     }
-    free(pBuf);
     return Success;
 }
 
@@ -165,6 +165,9 @@ void TouchEndDDXTouch(DeviceIntPtr dev, DDXTouchPointInfoPtr ti);
 DDXTouchPointInfoPtr TouchFindByDDXID(DeviceIntPtr dev,
                                       uint32_t ddx_id,
                                       Bool create);
+/* Number of events kept in a touch's event history */
+#define TOUCH_HISTORY_SIZE 100
+
 Bool TouchInitTouchPoint(TouchClassPtr touch, ValuatorClassPtr v, int index);
 void TouchFreeTouchPoint(DeviceIntPtr dev, int index);
 TouchPointInfoPtr TouchBeginTouch(DeviceIntPtr dev,
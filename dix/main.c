@@ -93,6 +93,7 @@ Equipment Corporation.
 #include "dix/gc_priv.h"
 #include "dix/registry_priv.h"
 #include "dix/selection_priv.h"
+#include "dix/snapshot_priv.h"
 #include "os/audit.h"
 #include "os/auth.h"
 #include "os/client_priv.h"
@@ -156,6 +157,7 @@ dix_main(int argc, char *argv[], char *envp[])
         OsInit();
         if (serverGeneration == 1) {
             CreateWellKnownSockets();
+            DebugSocketInit();
             for (int i = 1; i < LimitClients; i++)
                 clients[i] = NULL;
             serverClient = calloc(1, sizeof(ClientRec));
@@ -160,6 +160,10 @@ static void RebuildTable(int    /*client */
 #define INITHASHSIZE 6
 #define MAXHASHSIZE 16
 
+#define XID_CHUNK_SHIFT 12      /* IDs per chunk of the usage tracking */
+#define XID_CHUNK_SIZE (1 << XID_CHUNK_SHIFT)
+#define XID_CHUNK_COUNT ((RESOURCE_ID_MASK >> XID_CHUNK_SHIFT) + 1)
+
 typedef struct _Resource {
     struct _Resource *next;
     XID id;
@@ -167,6 +171,18 @@ typedef struct _Resource {
     void *value;
 } ResourceRec, *ResourcePtr;
 
+/*
+ * Which IDs of one of a client's ID ranges are in use, at the granularity
+ * of chunks of XID_CHUNK_SIZE IDs: the number of resources in each chunk,
+ * and a bit per chunk that is set while that number is not zero.  Kept up
+ * to date as resources come and go, so that looking for free IDs only
+ * needs to probe the hash table for IDs in partly used chunks.
+ */
+typedef struct _XIDUsage {
+    unsigned int *counts;
+    uint64_t *used;
+} XIDUsageRec, *XIDUsagePtr;
+
 typedef struct _ClientResource {
     ResourcePtr *resources;
     int elements;
@@ -174,8 +190,11 @@ typedef struct _ClientResource {
     int hashsize;               /* log(2)(buckets) */
     XID fakeID;
     XID endFakeID;
+    XIDUsageRec usage[2];       /* client IDs, and IDs with SERVER_BIT */
 } ClientResourceRec;
 
+static void FreeXIDUsage(ClientResourceRec *rrec);
+
 RESTYPE lastResourceType;
 static RESTYPE lastResourceClass;
 RESTYPE TypeMask;
@@ -658,6 +677,19 @@ InitClientResources(ClientPtr client)
         calloc(INITBUCKETS, sizeof(ResourcePtr));
     if (!clientTable[i].resources)
         return FALSE;
+    for (int j = 0; j < ARRAY_SIZE(clientTable[i].usage); j++) {
+        XIDUsagePtr usage = &clientTable[i].usage[j];
+
+        usage->counts = calloc(XID_CHUNK_COUNT, sizeof(*usage->counts));
+        usage->used = calloc((XID_CHUNK_COUNT + 63) / 64,
+                             sizeof(*usage->used));
+        if (!usage->counts || !usage->used) {
+            FreeXIDUsage(&clientTable[i]);
+            free(clientTable[i].resources);
+            clientTable[i].resources = NULL;
+            return FALSE;
+        }
+    }
     clientTable[i].buckets = INITBUCKETS;
     clientTable[i].elements = 0;
     clientTable[i].hashsize = INITHASHSIZE;
@@ -688,51 +720,150 @@ HashResourceID(XID id, unsigned int numBits)
     return (id ^ (id >> numBits)) & ~((~0U) << numBits);
 }
 
-static XID
-AvailableID(int client, XID id, XID maxid, XID goodid)
+/* the usage of the ID range id is in, or NULL if it is in neither */
+static XIDUsagePtr
+XIDUsageForID(ClientResourceRec *rrec, XID id)
+{
+    switch (id & ~(RESOURCE_CLIENT_MASK | RESOURCE_ID_MASK)) {
+    case 0:
+        return &rrec->usage[0];
+    case SERVER_BIT:
+        return &rrec->usage[1];
+    default:
+        return NULL;
+    }
+}
+
+static void
+XIDUsageAdd(ClientResourceRec *rrec, XID id)
+{
+    XIDUsagePtr usage = XIDUsageForID(rrec, id);
+    unsigned int chunk = (id & RESOURCE_ID_MASK) >> XID_CHUNK_SHIFT;
+
+    if (usage && !usage->counts[chunk]++)
+        usage->used[chunk / 64] |= (uint64_t) 1 << (chunk % 64);
+}
+
+static void
+XIDUsageRemove(ClientResourceRec *rrec, XID id)
+{
+    XIDUsagePtr usage = XIDUsageForID(rrec, id);
+    unsigned int chunk = (id & RESOURCE_ID_MASK) >> XID_CHUNK_SHIFT;
+
+    if (usage && !--usage->counts[chunk])
+        usage->used[chunk / 64] &= ~((uint64_t) 1 << (chunk % 64));
+}
+
+static inline Bool
+XIDChunkUsed(XIDUsagePtr usage, unsigned int chunk)
+{
+    return (usage->used[chunk / 64] >> (chunk % 64)) & 1;
+}
+
+static void
+FreeXIDUsage(ClientResourceRec *rrec)
+{
+    for (int i = 0; i < ARRAY_SIZE(rrec->usage); i++) {
+        free(rrec->usage[i].counts);
+        free(rrec->usage[i].used);
+        rrec->usage[i].counts = NULL;
+        rrec->usage[i].used = NULL;
+    }
+}
+
+static Bool
+XIDFree(int client, XID id)
 {
     ResourcePtr res;
 
-    if ((goodid >= id) && (goodid <= maxid))
-        return goodid;
-    for (; id <= maxid; id++) {
-        res = clientTable[client].resources[HashResourceID(id, clientTable[client].hashsize)];
-        while (res && (res->id != id))
-            res = res->next;
-        if (!res)
-            return id;
+    res = clientTable[client].resources[HashResourceID(id, clientTable[client].hashsize)];
+    while (res && (res->id != id))
+        res = res->next;
+    return !res;
+}
+
+/* the longest run of free IDs base | [*minp, *maxp] within [lo, hi] */
+static Bool
+LongestFreeRun(int client, XID base, XID lo, XID hi, XID *minp, XID *maxp)
+{
+    XID run = 0, best = 0;
+
+    for (XID off = lo; off <= hi; off++) {
+        if (!XIDFree(client, base | off)) {
+            run = 0;
+            continue;
+        }
+        if (++run > best) {
+            best = run;
+            *minp = off + 1 - run;
+            *maxp = off;
+        }
     }
-    return 0;
+    return best != 0;
 }
 
+/*
+ * Find a range of free IDs for the given client, preferably a large one:
+ * the longest run of unused chunks, grown by the free IDs next to it.  If
+ * all chunks are in use, the longest run in the least used chunk.
+ */
 void
 GetXIDRange(int client, Bool server, XID *minp, XID *maxp)
 {
-    XID id, maxid;
-    XID goodid;
-
-    id = (Mask) client << CLIENTOFFSET;
-    if (server)
-        id |= client ? SERVER_BIT : SERVER_MINID;
-    maxid = id | RESOURCE_ID_MASK;
-    goodid = 0;
-    ResourcePtr *resp = clientTable[client].resources;
-    for (int i = clientTable[client].buckets; --i >= 0;) {
-        for (ResourcePtr res = *resp++; res; res = res->next) {
-            if ((res->id < id) || (res->id > maxid))
-                continue;
-            if (((res->id - id) >= (maxid - res->id)) ?
-                (goodid = AvailableID(client, id, res->id - 1, goodid)) :
-                !(goodid = AvailableID(client, res->id + 1, maxid, goodid)))
-                maxid = res->id - 1;
-            else
-                id = res->id + 1;
+    XIDUsagePtr usage;
+    XID base, lo, from, to;
+    unsigned int run = 0, best = 0, bestEnd = 0;
+    unsigned int chunk, leastUsed = 0;
+    unsigned int nchunks = XID_CHUNK_COUNT;
+    Bool found;
+
+    base = (Mask) client << CLIENTOFFSET;
+    lo = 0;
+    if (server && client)
+        base |= SERVER_BIT;
+    else if (server)
+        lo = SERVER_MINID;
+    usage = XIDUsageForID(&clientTable[client], base);
+
+    for (chunk = 0; chunk < nchunks; chunk++) {
+        /* the IDs below lo make the first chunk a partly used one */
+        if (XIDChunkUsed(usage, chunk) || (chunk == 0 && lo)) {
+            if (usage->counts[chunk] < usage->counts[leastUsed])
+                leastUsed = chunk;
+            run = 0;
+        }
+        else if (++run > best) {
+            best = run;
+            bestEnd = chunk;
         }
     }
-    if (id > maxid)
-        id = maxid = 0;
-    *minp = id;
-    *maxp = maxid;
+
+    if (best) {
+        from = (XID) (bestEnd + 1 - best) << XID_CHUNK_SHIFT;
+        to = ((XID) (bestEnd + 1) << XID_CHUNK_SHIFT) - 1;
+        while (from > lo && XIDFree(client, base | (from - 1)))
+            from--;
+        while (to < RESOURCE_ID_MASK && XIDFree(client, base | (to + 1)))
+            to++;
+        found = TRUE;
+    }
+    else {
+        XID first = (XID) leastUsed << XID_CHUNK_SHIFT;
+
+        found = LongestFreeRun(client, base, max(first, lo),
+                               first + XID_CHUNK_SIZE - 1, &from, &to);
+        /* with several resources per ID, there may be free IDs elsewhere */
+        if (!found)
+            found = LongestFreeRun(client, base, lo, RESOURCE_ID_MASK,
+                                   &from, &to);
+    }
+
+    if (found) {
+        *minp = base | from;
+        *maxp = base | to;
+    }
+    else
+        *minp = *maxp = 0;
 }
 
 /**
@@ -745,28 +876,26 @@ GetXIDRange(int client, Bool server, XID *minp, XID *maxp)
  *  Xlib must run out of IDs while trying to generate a request that wants
  *  multiple ID's, like the Multi-buffering CreateImageBuffers request.
  *
- *  No rocket science in the implementation; just iterate over all
- *  possible IDs for the given client and pick the first count IDs
- *  that aren't in use.  A more efficient algorithm could probably be
- *  invented, but this will be used so rarely that this should suffice.
+ *  Takes the lowest unused IDs, all of an unused chunk at a time, and
+ *  only checks IDs one by one in chunks that are in use.
  */
 
 unsigned int
 GetXIDList(ClientPtr pClient, unsigned count, XID *pids)
 {
+    XIDUsagePtr usage = &clientTable[pClient->index].usage[0];
+    unsigned int nchunks = XID_CHUNK_COUNT;
     unsigned int found = 0;
-    XID rc, id = pClient->clientAsMask;
-    XID maxid;
-    void *val;
 
-    maxid = id | RESOURCE_ID_MASK;
-    while ((found < count) && (id <= maxid)) {
-        rc = dixLookupResourceByClass(&val, id, RC_ANY, serverClient,
-                                      DixGetAttrAccess);
-        if (rc == BadValue) {
-            pids[found++] = id;
+    for (unsigned int chunk = 0; chunk < nchunks && found < count; chunk++) {
+        XID id = pClient->clientAsMask | ((XID) chunk << XID_CHUNK_SHIFT);
+        XID end = id + XID_CHUNK_SIZE;
+        Bool used = XIDChunkUsed(usage, chunk);
+
+        for (; id < end && found < count; id++) {
+            if (!used || XIDFree(pClient->index, id))
+                pids[found++] = id;
         }
-        id++;
     }
     return found;
 }
@@ -841,6 +970,7 @@ AddResource(XID id, RESTYPE type, void *value)
     res->value = value;
     *head = res;
     rrec->elements++;
+    XIDUsageAdd(rrec, id);
     CallResourceStateCallback(ResourceStateAdding, res);
     return TRUE;
 }
@@ -921,6 +1051,7 @@ FreeResource(XID id, RESTYPE skipDeleteFuncType)
 #endif
                 *prev = res->next;
                 elements = --*eltptr;
+                XIDUsageRemove(&clientTable[cid], id);
 
                 doFreeResource(res, rtype == skipDeleteFuncType);
 
@@ -952,6 +1083,7 @@ FreeResourceByType(XID id, RESTYPE type, Bool skipFree)
 #endif
                 *prev = res->next;
                 clientTable[cid].elements--;
+                XIDUsageRemove(&clientTable[cid], id);
 
                 doFreeResource(res, skipFree);
 
@@ -1101,6 +1233,7 @@ FreeClientNeverRetainResources(ClientPtr client)
 #endif
                 *prev = this->next;
                 clientTable[client->index].elements--;
+                XIDUsageRemove(&clientTable[client->index], this->id);
                 elements = *eltptr;
 
                 doFreeResource(this, FALSE);
@@ -1149,6 +1282,7 @@ FreeClientResources(ClientPtr client)
 #endif
             *head = this->next;
             clientTable[client->index].elements--;
+            XIDUsageRemove(&clientTable[client->index], this->id);
 
             doFreeResource(this, FALSE);
         }
@@ -1156,6 +1290,7 @@ FreeClientResources(ClientPtr client)
     free(clientTable[client->index].resources);
     clientTable[client->index].resources = NULL;
     clientTable[client->index].buckets = 0;
+    FreeXIDUsage(&clientTable[client->index]);
 }
 
 void
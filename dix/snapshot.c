@@ -0,0 +1,484 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ *
+ * @brief server state snapshots for live debugging
+ *
+ * PrintWindowTree(), PrintPassiveGrabs() and PrintDeviceGrabInfo() write
+ * straight into the log while the server waits, which is fine on a
+ * developer's machine but not on a production desktop that has become
+ * slow.  The debug socket gives the same information without that.
+ *
+ * Snapshots are immutable text buffers published by epoch.  A reader
+ * thread accepts connections on the debug socket, asks the main thread
+ * for a new snapshot through a pipe and waits up to SNAPSHOT_WAIT_MS for
+ * an epoch newer than the one it saw.  The main thread builds it the next
+ * time it polls for work, which happens at least once per dispatch round,
+ * and swaps it in under a mutex held only for the pointer swap.  If the
+ * main thread does not get there in time, because it is stuck, the reader
+ * sends the last published snapshot instead, marked with its age.  The
+ * write to the reader, however slow, happens on the reader thread.
+ *
+ * Usage: socat - UNIX-CONNECT:<path>
+ */
+#include <dix-config.h>
+
+#include "dix/snapshot_priv.h"
+
+const char *debugSocketPath;      /* NULL: disabled */
+
+#if INPUTTHREAD
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "dix/dix_priv.h"
+#include "dix/registry_priv.h"
+#include "os/client_priv.h"
+
+#include "dixstruct.h"
+#include "inputstr.h"
+#include "resource.h"
+#include "scrnintstr.h"
+#include "windowstr.h"
+
+#define SNAPSHOT_WAIT_MS 1000
+#define SNAPSHOT_SEND_TIMEOUT_S 5
+
+typedef struct _DebugSnapshot {
+    int refcnt;                 /* protected by snapshot_mutex */
+    unsigned long epoch;
+    CARD32 time;                /* GetTimeInMillis() when taken */
+    Bool failed;                /* ran out of memory while building */
+    size_t len, size;
+    char *text;
+} DebugSnapshotRec, *DebugSnapshotPtr;
+
+static pthread_mutex_t snapshot_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t snapshot_published = PTHREAD_COND_INITIALIZER;
+static DebugSnapshotPtr current_snapshot;      /* newest published */
+static unsigned long published_epoch;
+
+static int debug_listen_fd = -1;
+static int wake_pipe[2] = { -1, -1 };
+static int thread_errno;        /* why the thread quit, logged by the main thread */
+
+static void
+SnapshotPrintf(DebugSnapshotPtr snap, const char *format, ...)
+    _X_ATTRIBUTE_PRINTF(2, 3);
+
+static void
+SnapshotPrintf(DebugSnapshotPtr snap, const char *format, ...)
+{
+    va_list args;
+    int len;
+
+    if (snap->failed)
+        return;
+
+    va_start(args, format);
+    len = vsnprintf(snap->text + snap->len, snap->size - snap->len,
+                    format, args);
+    va_end(args);
+    if (len < 0) {
+        snap->failed = TRUE;
+        return;
+    }
+
+    if (snap->len + len >= snap->size) {
+        size_t size = snap->size ? snap->size : 16384;
+        char *text;
+
+        while (snap->len + len >= size)
+            size *= 2;
+        text = realloc(snap->text, size);
+        if (!text) {
+            snap->failed = TRUE;
+            return;
+        }
+        snap->text = text;
+        snap->size = size;
+
+        va_start(args, format);
+        vsnprintf(snap->text + snap->len, snap->size - snap->len,
+                  format, args);
+        va_end(args);
+    }
+    snap->len += len;
+}
+
+static void
+SnapshotUnref(DebugSnapshotPtr snap)
+{
+    Bool last;
+
+    if (!snap)
+        return;
+    pthread_mutex_lock(&snapshot_mutex);
+    last = --snap->refcnt == 0;
+    pthread_mutex_unlock(&snapshot_mutex);
+    if (last) {
+        free(snap->text);
+        free(snap);
+    }
+}
+
+typedef struct {
+    unsigned long total;
+    unsigned long *perType;     /* indexed by type & TypeMask */
+} SnapshotResourceCount;
+
+static void
+SnapshotCountResource(void *value, XID id, RESTYPE type, void *cdata)
+{
+    SnapshotResourceCount *count = cdata;
+
+    count->total++;
+    if (count->perType && (type & TypeMask) <= (lastResourceType & TypeMask))
+        count->perType[type & TypeMask]++;
+}
+
+static void
+SnapshotClients(DebugSnapshotPtr snap)
+{
+    SnapshotResourceCount all = { 0 };
+
+    all.perType = calloc((lastResourceType & TypeMask) + 1,
+                         sizeof(unsigned long));
+
+    SnapshotPrintf(snap, "clients:\n");
+    for (int i = 0; i < currentMaxClients; i++) {
+        ClientPtr client = clients[i];
+        SnapshotResourceCount count = { 0, all.perType };
+        const char *cmdname;
+
+        if (!client)
+            continue;
+
+        FindAllClientResources(client, SnapshotCountResource, &count);
+        all.total += count.total;
+        /* a lookup could block dispatch, only print what is known */
+        cmdname = GetCachedClientCmdName(client);
+        SnapshotPrintf(snap, "  %d pid %ld seq %lu resources %lu%s%s %s\n",
+                       i, (long) GetClientPid(client),
+                       (unsigned long) client->sequence, count.total,
+                       client->clientGone ? " gone" : "",
+                       client->ignoreCount ? " ignored" : "",
+                       cmdname ? cmdname : "");
+    }
+
+    SnapshotPrintf(snap, "resources: %lu\n", all.total);
+    if (all.perType) {
+        for (RESTYPE t = 1; t <= (lastResourceType & TypeMask); t++) {
+            if (all.perType[t])
+                SnapshotPrintf(snap, "  %-24s %lu\n",
+                               LookupResourceName(t), all.perType[t]);
+        }
+        free(all.perType);
+    }
+}
+
+static void
+SnapshotWindow(DebugSnapshotPtr snap, WindowPtr pWin, int depth)
+{
+    SnapshotPrintf(snap, "  %*s0x%lx client %d %dx%d%+d%+d%s%s%s\n",
+                   2 * depth, "", (unsigned long) pWin->drawable.id,
+                   dixClientIdForXID(pWin->drawable.id),
+                   pWin->drawable.width, pWin->drawable.height,
+                   pWin->drawable.x, pWin->drawable.y,
+                   pWin->mapped ? " mapped" : "",
+                   pWin->viewable ? " viewable" : "",
+                   pWin->overrideRedirect ? " override-redirect" : "");
+}
+
+static void
+SnapshotWindows(DebugSnapshotPtr snap)
+{
+    for (int scrnum = 0; scrnum < screenInfo.numScreens; scrnum++) {
+        WindowPtr pWin = screenInfo.screens[scrnum]->root;
+        int depth = 0;
+
+        SnapshotPrintf(snap, "windows of screen %d:\n", scrnum);
+        while (pWin) {
+            SnapshotWindow(snap, pWin, depth);
+            if (pWin->firstChild) {
+                pWin = pWin->firstChild;
+                depth++;
+                continue;
+            }
+            while (pWin && !pWin->nextSib) {
+                pWin = pWin->parent;
+                depth--;
+            }
+            if (pWin)
+                pWin = pWin->nextSib;
+        }
+    }
+}
+
+static const char *
+SnapshotGrabType(GrabPtr grab)
+{
+    return (grab->grabtype == XI2) ? "xi2" :
+        ((grab->grabtype == CORE) ? "core" : "xi1");
+}
+
+static void
+SnapshotPassiveGrab(void *value, XID id, void *cdata)
+{
+    GrabPtr grab = value;
+
+    SnapshotPrintf(cdata, "  passive 0x%lx (%s) client %d device %d "
+                   "window 0x%lx type %d detail 0x%x\n",
+                   (unsigned long) id, SnapshotGrabType(grab),
+                   dixClientIdForXID(id),
+                   grab->device ? grab->device->id : -1,
+                   grab->window ? (unsigned long) grab->window->drawable.id : 0,
+                   grab->type, grab->detail.exact);
+}
+
+static void
+SnapshotGrabs(DebugSnapshotPtr snap)
+{
+    SnapshotPrintf(snap, "grabs:\n");
+    for (DeviceIntPtr dev = inputInfo.devices; dev; dev = dev->next) {
+        GrabInfoPtr devGrab = &dev->deviceGrab;
+        GrabPtr grab = devGrab->grab;
+
+        if (!grab)
+            continue;
+        SnapshotPrintf(snap, "  active 0x%lx (%s) client %d device '%s' (%d) "
+                       "window 0x%lx at %lu%s%s %s\n",
+                       (unsigned long) grab->resource, SnapshotGrabType(grab),
+                       dixClientIdForXID(grab->resource), dev->name, dev->id,
+                       grab->window ?
+                       (unsigned long) grab->window->drawable.id : 0,
+                       (unsigned long) devGrab->grabTime.milliseconds,
+                       devGrab->fromPassiveGrab ? " passive" : "",
+                       devGrab->implicitGrab ? " implicit" : "",
+                       devGrab->sync.frozen ? "frozen" : "thawed");
+    }
+    for (int i = 1; i < currentMaxClients; i++) {
+        if (clients[i] && clients[i]->clientState == ClientStateRunning)
+            FindClientResourcesByType(clients[i], X11_RESTYPE_PASSIVEGRAB,
+                                      SnapshotPassiveGrab, snap);
+    }
+}
+
+/* runs on the main thread whenever the reader thread asks for a snapshot */
+static void
+SnapshotRequested(int fd, int ready, void *data)
+{
+    DebugSnapshotPtr snap, old;
+    char buf[64];
+
+    while (read(fd, buf, sizeof(buf)) > 0)
+        ;
+
+    pthread_mutex_lock(&snapshot_mutex);
+    if (thread_errno) {
+        LogMessage(X_ERROR, "debug socket: accept failed: %s\n",
+                   strerror(thread_errno));
+        thread_errno = 0;
+        pthread_mutex_unlock(&snapshot_mutex);
+        return;
+    }
+    pthread_mutex_unlock(&snapshot_mutex);
+
+    snap = calloc(1, sizeof(DebugSnapshotRec));
+    if (!snap)
+        return;
+    snap->refcnt = 1;
+    snap->epoch = published_epoch + 1;
+    snap->time = GetTimeInMillis();
+
+    SnapshotPrintf(snap, "generation %lu time %lu clients %d\n",
+                   serverGeneration, (unsigned long) snap->time,
+                   currentMaxClients);
+    SnapshotClients(snap);
+    SnapshotWindows(snap);
+    SnapshotGrabs(snap);
+    if (snap->failed) {
+        free(snap->text);
+        free(snap);
+        return;
+    }
+
+    pthread_mutex_lock(&snapshot_mutex);
+    old = current_snapshot;
+    current_snapshot = snap;
+    published_epoch = snap->epoch;
+    pthread_cond_broadcast(&snapshot_published);
+    pthread_mutex_unlock(&snapshot_mutex);
+
+    SnapshotUnref(old);
+}
+
+static void
+SnapshotSend(int fd, const char *data, size_t len)
+{
+    while (len) {
+        ssize_t ret = send(fd, data, len, MSG_NOSIGNAL);
+
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return;
+        data += ret;
+        len -= ret;
+    }
+}
+
+static void *
+DebugSocketThread(void *arg)
+{
+    sigset_t set;
+
+    /* Don't handle any signals on this thread */
+    sigfillset(&set);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+#if defined(HAVE_PTHREAD_SETNAME_NP_WITH_TID)
+    pthread_setname_np (pthread_self(), "DebugSocketThread");
+#elif defined(HAVE_PTHREAD_SETNAME_NP_WITHOUT_TID)
+    pthread_setname_np ("DebugSocketThread");
+#endif
+
+    for (;;) {
+        struct timeval tv = { .tv_sec = SNAPSHOT_SEND_TIMEOUT_S };
+        struct timespec deadline;
+        DebugSnapshotPtr snap;
+        unsigned long wanted;
+        char header[128];
+        int fd, len;
+
+        fd = accept(debug_listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            /* the log isn't ours to write to, have the main thread do it */
+            pthread_mutex_lock(&snapshot_mutex);
+            thread_errno = errno;
+            pthread_mutex_unlock(&snapshot_mutex);
+            (void) !write(wake_pipe[1], "", 1);
+            return NULL;
+        }
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += SNAPSHOT_WAIT_MS / 1000;
+
+        pthread_mutex_lock(&snapshot_mutex);
+        wanted = published_epoch + 1;
+        /* if this fails, the reader gets told no snapshot was taken */
+        (void) !write(wake_pipe[1], "", 1);
+        while (published_epoch < wanted &&
+               pthread_cond_timedwait(&snapshot_published, &snapshot_mutex,
+                                      &deadline) != ETIMEDOUT)
+            ;
+        snap = current_snapshot;
+        if (snap)
+            snap->refcnt++;
+        pthread_mutex_unlock(&snapshot_mutex);
+
+        if (!snap)
+            len = snprintf(header, sizeof(header),
+                           "no snapshot: server busy for more than %d ms\n",
+                           SNAPSHOT_WAIT_MS);
+        else if (snap->epoch < wanted)
+            len = snprintf(header, sizeof(header),
+                           "stale snapshot %lu from %lu ms ago: server busy "
+                           "for more than %d ms\n", snap->epoch,
+                           (unsigned long) (GetTimeInMillis() - snap->time),
+                           SNAPSHOT_WAIT_MS);
+        else
+            len = snprintf(header, sizeof(header), "snapshot %lu\n",
+                           snap->epoch);
+        SnapshotSend(fd, header, len);
+        if (snap)
+            SnapshotSend(fd, snap->text, snap->len);
+        close(fd);
+
+        SnapshotUnref(snap);
+    }
+    return NULL;
+}
+
+void
+DebugSocketInit(void)
+{
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    pthread_attr_t attr;
+    pthread_t thread;
+    int fd;
+
+    if (!debugSocketPath)
+        return;
+
+    if (strlen(debugSocketPath) >= sizeof(addr.sun_path)) {
+        LogMessage(X_ERROR, "debug socket: path too long: %s\n",
+                   debugSocketPath);
+        return;
+    }
+    strcpy(addr.sun_path, debugSocketPath);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        goto fail;
+    unlink(debugSocketPath);
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0 ||
+        chmod(debugSocketPath, 0600) < 0 || listen(fd, 4) < 0)
+        goto fail;
+
+    if (pipe(wake_pipe) < 0)
+        goto fail;
+    for (int i = 0; i < 2; i++) {
+        fcntl(wake_pipe[i], F_SETFL, O_NONBLOCK);
+        fcntl(wake_pipe[i], F_SETFD, FD_CLOEXEC);
+    }
+    debug_listen_fd = fd;
+    SetNotifyFd(wake_pipe[0], SnapshotRequested, X_NOTIFY_READ, NULL);
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, DebugSocketThread, NULL) != 0) {
+        pthread_attr_destroy(&attr);
+        LogMessage(X_ERROR, "debug socket: cannot start thread\n");
+        return;
+    }
+    pthread_attr_destroy(&attr);
+
+    LogMessage(X_INFO, "debug socket: listening on %s\n", debugSocketPath);
+    return;
+
+fail:
+    LogMessage(X_ERROR, "debug socket: cannot listen on %s: %s\n",
+               debugSocketPath, strerror(errno));
+    if (fd >= 0)
+        close(fd);
+}
+
+#else                           /* INPUTTHREAD */
+
+#include "os.h"
+
+void
+DebugSocketInit(void)
+{
+    if (debugSocketPath)
+        LogMessage(X_WARNING, "debug socket: needs thread support, "
+                   "ignoring -debugsocket\n");
+}
+
+#endif                          /* INPUTTHREAD */
@@ -0,0 +1,26 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ *
+ * @brief server state snapshots for live debugging
+ *
+ * With -debugsocket, the server listens on a local stream socket and sends
+ * a text snapshot of its clients, resource counts, window trees and grabs
+ * to whoever connects, then closes the connection.  The snapshot is taken
+ * by the main thread between dispatch rounds; everything else, including
+ * writing it out, happens on a separate thread, so slow readers never hold
+ * up request processing.
+ */
+#ifndef _XSERVER_DIX_SNAPSHOT_PRIV_H
+#define _XSERVER_DIX_SNAPSHOT_PRIV_H
+
+/* path of the debug socket, NULL if disabled */
+extern const char *debugSocketPath;
+
+/*
+ * Start listening on debugSocketPath, if set.  Called once, after the
+ * server's own sockets exist; the socket survives server resets.
+ */
+void DebugSocketInit(void);
+
+#endif /* _XSERVER_DIX_SNAPSHOT_PRIV_H */
@@ -43,8 +43,6 @@
 #include "exglobals.h"
 #include "windowstr.h"
 
-#define TOUCH_HISTORY_SIZE 100
-
 Bool touchEmulatePointer = TRUE;
 
 /**
@@ -211,6 +209,9 @@ TouchInitTouchPoint(TouchClassPtr t, ValuatorClassPtr v, int index)
 
     memset(ti, 0, sizeof(*ti));
 
+    if (index < t->history_pool_touches)
+        ti->history_buffer = &t->history_pool[index * TOUCH_HISTORY_SIZE];
+
     ti->valuators = valuator_mask_new(v->numAxes);
     if (!ti->valuators)
         return FALSE;
@@ -250,10 +251,10 @@ TouchFreeTouchPoint(DeviceIntPtr device, int index)
     ti->sprite.spriteTrace = NULL;
     free(ti->listeners);
     ti->listeners = NULL;
-    free(ti->history);
-    ti->history = NULL;
-    ti->history_size = 0;
-    ti->history_elements = 0;
+    TouchEventHistoryFree(ti);
+    if (index >= device->touch->history_pool_touches)
+        free(ti->history_buffer);
+    ti->history_buffer = NULL;
 }
 
 /**
@@ -370,6 +371,10 @@ TouchEndTouch(DeviceIntPtr dev, TouchPointInfoPtr ti)
  * touchpoint that already has an event history does nothing but counts as
  * as success.
  *
+ * Touch points within the device's initial touch count use their slice of
+ * the device's history pool, any others get their own buffer on first use
+ * which is kept until the touch point is freed.
+ *
  * @return TRUE on success, FALSE on allocation errors
  */
 Bool
@@ -378,20 +383,66 @@ TouchEventHistoryAllocate(TouchPointInfoPtr ti)
     if (ti->history)
         return TRUE;
 
-    ti->history = calloc(TOUCH_HISTORY_SIZE, sizeof(*ti->history));
+    if (!ti->history_buffer)
+        ti->history_buffer = calloc(TOUCH_HISTORY_SIZE,
+                                    sizeof(*ti->history_buffer));
+    if (!ti->history_buffer)
+        return FALSE;
+
+    ti->history = ti->history_buffer;
+    ti->history_size = TOUCH_HISTORY_SIZE;
     ti->history_elements = 0;
-    if (ti->history)
-        ti->history_size = TOUCH_HISTORY_SIZE;
-    return ti->history != NULL;
+    ti->history_start = 0;
+    return TRUE;
 }
 
 void
 TouchEventHistoryFree(TouchPointInfoPtr ti)
 {
-    free(ti->history);
     ti->history = NULL;
     ti->history_size = 0;
     ti->history_elements = 0;
+    ti->history_start = 0;
+}
+
+/**
+ * Return the n-th event of the history. The TouchBegin is always in the
+ * first slot, the TouchUpdates in the remaining slots form a ring starting
+ * at history_start.
+ */
+static DeviceEvent *
+TouchEventHistoryGet(TouchPointInfoPtr ti, size_t n)
+{
+    if (n == 0)
+        return &ti->history[0];
+    return &ti->history[1 + (ti->history_start + n - 1) % (ti->history_size - 1)];
+}
+
+/**
+ * Fold the axes of a superseded TouchUpdate into the one following it, so
+ * dropping the former doesn't lose axis values the latter doesn't carry.
+ */
+static void
+TouchEventHistoryCoalesce(const DeviceEvent *from, DeviceEvent *to)
+{
+    for (int i = 0; i < MAX_VALUATORS; i++) {
+        if (!BitIsOn(from->valuators.mask, i))
+            continue;
+
+        if (!BitIsOn(to->valuators.mask, i)) {
+            SetBit(to->valuators.mask, i);
+            if (BitIsOn(from->valuators.mode, i))
+                SetBit(to->valuators.mode, i);
+            else
+                ClearBit(to->valuators.mode, i);
+            to->valuators.data[i] = from->valuators.data[i];
+        }
+        else if (!BitIsOn(from->valuators.mode, i) &&
+                 !BitIsOn(to->valuators.mode, i)) {
+            /* relative motion adds up */
+            to->valuators.data[i] += from->valuators.data[i];
+        }
+    }
 }
 
 /**
@@ -401,10 +452,15 @@ TouchEventHistoryFree(TouchPointInfoPtr ti)
  * If more than one TouchBegin is pushed onto the stack, the push is
  * ignored, calling this function multiple times for the TouchBegin is
  * valid.
+ * Once the history is full, the oldest TouchUpdate is merged into the next
+ * one and its slot reused, so a long-held touch keeps its TouchBegin and
+ * most recent motion in a fixed amount of memory.
  */
 void
 TouchEventHistoryPush(TouchPointInfoPtr ti, const DeviceEvent *ev)
 {
+    DeviceEvent *oldest;
+
     if (!ti->history)
         return;
 
@@ -426,13 +482,15 @@ TouchEventHistoryPush(TouchPointInfoPtr ti, const DeviceEvent *ev)
     if (ev->flags & (TOUCH_CLIENT_ID | TOUCH_REPLAYING))
         return;
 
-    ti->history[ti->history_elements++] = *ev;
-    /* FIXME: proper overflow fixes */
-    if (ti->history_elements > ti->history_size - 1) {
-        ti->history_elements = ti->history_size - 1;
-        DebugF("source device %d: history size %zu overflowing for touch %u\n",
-               ti->sourceid, ti->history_size, ti->client_id);
+    if (ti->history_elements < ti->history_size) {
+        *TouchEventHistoryGet(ti, ti->history_elements++) = *ev;
+        return;
     }
+
+    oldest = TouchEventHistoryGet(ti, 1);
+    TouchEventHistoryCoalesce(oldest, TouchEventHistoryGet(ti, 2));
+    *oldest = *ev;
+    ti->history_start = (ti->history_start + 1) % (ti->history_size - 1);
 }
 
 void
@@ -444,7 +502,7 @@ TouchEventHistoryReplay(TouchPointInfoPtr ti, DeviceIntPtr dev, XID resource)
     DeliverDeviceClassesChangedEvent(ti->sourceid, ti->history[0].time);
 
     for (int i = 0; i < ti->history_elements; i++) {
-        DeviceEvent *ev = &ti->history[i];
+        DeviceEvent *ev = TouchEventHistoryGet(ti, i);
 
         ev->flags |= TOUCH_REPLAYING;
         ev->resource = resource;
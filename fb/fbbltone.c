@@ -22,6 +22,8 @@
 
 #include <dix-config.h>
 
+#include <string.h>
+
 #include "fb.h"
 
 /*
@@ -119,6 +121,201 @@ static const FbBits fbStipple1Bits[2] = {
     C1(0, 32), C1(1, 32),
 };
 
+/*
+ * Wide expansion for 8, 16 and 32bpp destinations.  Every source byte is
+ * turned into one to four 64 bit pixel masks with a table lookup and
+ * written with full width stores, instead of going through the generic
+ * loop one FbBits unit at a time.  The results are identical to the
+ * generic code for every rop, planemask and alignment.
+ *
+ * This relies on screen order matching memory order for both the stipple
+ * bits and the destination pixels, and on direct memory access.
+ */
+#if !defined(FB_ACCESS_WRAPPER) && \
+    BITMAP_BIT_ORDER == LSBFirst && IMAGE_BYTE_ORDER == LSBFirst
+#define FB_BLT_ONE_WIDE
+
+#define W1(b,n,w)	((CARD64) (((b) >> (n)) & 1) * \
+			 ((((CARD64) 1) << (w)) - 1) << ((n) * (w)))
+#define W2(b,w)		(W1(b,0,w) | W1(b,1,w))
+#define W4(b,w)		(W2(b,w) | W1(b,2,w) | W1(b,3,w))
+#define W8(b,w)		(W4(b,w) | W1(b,4,w) | W1(b,5,w) | \
+			 W1(b,6,w) | W1(b,7,w))
+
+#define W8x4(b)		W8(b,8), W8((b)+1,8), W8((b)+2,8), W8((b)+3,8)
+#define W8x16(b)	W8x4(b), W8x4((b)+4), W8x4((b)+8), W8x4((b)+12)
+#define W8x64(b)	W8x16(b), W8x16((b)+16), W8x16((b)+32), W8x16((b)+48)
+
+static const CARD64 fbWideStipple8[256] = {
+    W8x64(0), W8x64(64), W8x64(128), W8x64(192)
+};
+
+static const CARD64 fbWideStipple16[16] = {
+    W4(0, 16), W4(1, 16), W4(2, 16), W4(3, 16),
+    W4(4, 16), W4(5, 16), W4(6, 16), W4(7, 16),
+    W4(8, 16), W4(9, 16), W4(10, 16), W4(11, 16),
+    W4(12, 16), W4(13, 16), W4(14, 16), W4(15, 16),
+};
+
+static const CARD64 fbWideStipple32[4] = {
+    W2(0, 32), W2(1, 32), W2(2, 32), W2(3, 32),
+};
+
+/* fetch n <= 8 stipple bits starting at bit x of a scanline */
+static inline CARD8
+fbWideStipBits(const CARD8 *line, int x, int n)
+{
+    const CARD8 *s = line + (x >> 3);
+    int shift = x & 7;
+    unsigned int bits = s[0] >> shift;
+
+    if (shift + n > 8)
+        bits |= s[1] << (8 - shift);
+    return bits & ((1 << n) - 1);
+}
+
+#define FbWideReplicate(b)	((((CARD64) (b)) << 32) | (CARD32) (b))
+
+/* expand n < 64 / bpp pixels, writing only the bytes they cover */
+static inline void
+fbWideStipplePart(CARD8 *d, CARD64 mask, int bytes, Bool copy,
+                  CARD64 fga, CARD64 fgx, CARD64 bga, CARD64 bgx)
+{
+    CARD64 v = 0;
+
+    if (!copy)
+        memcpy(&v, d, bytes);
+    v = (v & ((fga & mask) | (bga & ~mask))) ^ ((fgx & mask) | (bgx & ~mask));
+    memcpy(d, &v, bytes);
+}
+
+/* expand 64 bits worth of pixels */
+static inline void
+fbWideStipple(CARD8 *d, CARD64 mask, Bool copy, Bool transparent,
+              CARD64 fga, CARD64 fgx, CARD64 bga, CARD64 bgx)
+{
+    CARD64 v;
+
+    if (copy)
+        v = (fgx & mask) | (bgx & ~mask);
+    else {
+        if (transparent && !mask)
+            return;
+        memcpy(&v, d, sizeof(v));
+        v = (v & ((fga & mask) | (bga & ~mask))) ^
+            ((fgx & mask) | (bgx & ~mask));
+    }
+    memcpy(d, &v, sizeof(v));
+}
+
+static inline void
+fbBltOneWideLine(const CARD8 *s, int srcX, CARD8 *d, int pixels,
+                 const int bpp, const Bool copy, const Bool transparent,
+                 CARD64 fga, CARD64 fgx, CARD64 bga, CARD64 bgx)
+{
+    const int shift = srcX & 7;
+    int x;
+
+    s += srcX >> 3;
+
+    /* whole source bytes: 8 pixels, one to four 64 bit stores */
+    for (x = 0; x + 8 <= pixels; x += 8, s++) {
+        CARD8 bits = shift ? (s[0] >> shift) | (s[1] << (8 - shift)) : s[0];
+
+        switch (bpp) {
+        case 8:
+            fbWideStipple(d, fbWideStipple8[bits], copy, transparent,
+                          fga, fgx, bga, bgx);
+            d += 8;
+            break;
+        case 16:
+            fbWideStipple(d, fbWideStipple16[bits & 0xf], copy, transparent,
+                          fga, fgx, bga, bgx);
+            fbWideStipple(d + 8, fbWideStipple16[bits >> 4], copy,
+                          transparent, fga, fgx, bga, bgx);
+            d += 16;
+            break;
+        case 32:
+            fbWideStipple(d, fbWideStipple32[bits & 0x3], copy, transparent,
+                          fga, fgx, bga, bgx);
+            fbWideStipple(d + 8, fbWideStipple32[(bits >> 2) & 0x3], copy,
+                          transparent, fga, fgx, bga, bgx);
+            fbWideStipple(d + 16, fbWideStipple32[(bits >> 4) & 0x3], copy,
+                          transparent, fga, fgx, bga, bgx);
+            fbWideStipple(d + 24, fbWideStipple32[bits >> 6], copy,
+                          transparent, fga, fgx, bga, bgx);
+            d += 32;
+            break;
+        }
+    }
+
+    /* trailing pixels, one at a time */
+    for (; x < pixels; x++) {
+        CARD8 bit = fbWideStipBits(s, shift + (x & 7), 1);
+
+        fbWideStipplePart(d, bit ? ~(CARD64) 0 : 0, bpp >> 3, copy,
+                          fga, fgx, bga, bgx);
+        d += bpp >> 3;
+    }
+}
+
+static void
+fbBltOneWide(FbStip * src, FbStride srcStride, int srcX,
+             FbBits * dst, FbStride dstStride, int dstX, int dstBpp,
+             int width, int height,
+             FbBits fgand, FbBits fgxor, FbBits bgand, FbBits bgxor)
+{
+    const CARD64 fga = FbWideReplicate(fgand), fgx = FbWideReplicate(fgxor);
+    const CARD64 bga = FbWideReplicate(bgand), bgx = FbWideReplicate(bgxor);
+    const Bool copy = (fgand == 0 && bgand == 0);
+    const Bool transparent = (bgand == FB_ALLONES && bgxor == 0);
+    const int pixels = width / dstBpp;
+
+    while (height--) {
+        const CARD8 *s = (const CARD8 *) src;
+        CARD8 *d = (CARD8 *) dst + (dstX >> 3);
+
+        /* let the compiler specialize the line loop for each case */
+        switch (dstBpp | (copy ? 1 : 0)) {
+        case 8 | 1:
+            fbBltOneWideLine(s, srcX, d, pixels, 8, TRUE, FALSE,
+                             fga, fgx, bga, bgx);
+            break;
+        case 8:
+            fbBltOneWideLine(s, srcX, d, pixels, 8, FALSE, transparent,
+                             fga, fgx, bga, bgx);
+            break;
+        case 16 | 1:
+            fbBltOneWideLine(s, srcX, d, pixels, 16, TRUE, FALSE,
+                             fga, fgx, bga, bgx);
+            break;
+        case 16:
+            fbBltOneWideLine(s, srcX, d, pixels, 16, FALSE, transparent,
+                             fga, fgx, bga, bgx);
+            break;
+        case 32 | 1:
+            fbBltOneWideLine(s, srcX, d, pixels, 32, TRUE, FALSE,
+                             fga, fgx, bga, bgx);
+            break;
+        default:
+            fbBltOneWideLine(s, srcX, d, pixels, 32, FALSE, transparent,
+                             fga, fgx, bga, bgx);
+            break;
+        }
+        src += srcStride;
+        dst += dstStride;
+    }
+}
+
+#undef W1
+#undef W2
+#undef W4
+#undef W8
+#undef W8x4
+#undef W8x16
+#undef W8x64
+#endif /* wide expansion */
+
 #ifdef __clang__
 /* shift overflow is intentional */
 #pragma clang diagnostic ignored "-Wshift-overflow"
@@ -185,6 +382,14 @@ fbBltOne(FbStip * src, FbStride srcStride,      /* FbStip units per scanline */
     Bool endNeedsLoad = FALSE;  /* need load for endmask */
     int startbyte, endbyte;
 
+#ifdef FB_BLT_ONE_WIDE
+    if (dstBpp == 8 || dstBpp == 16 || dstBpp == 32) {
+        fbBltOneWide(src, srcStride, srcX, dst, dstStride, dstX, dstBpp,
+                     width, height, fgand, fgxor, bgand, bgxor);
+        return;
+    }
+#endif
+
     /*
      * Do not read past the end of the buffer!
      */
@@ -241,6 +241,13 @@ xf86GetPixFormat(ScrnInfoPtr pScrn, int depth);
 extern _X_EXPORT int
 xf86GetBppFromDepth(ScrnInfoPtr pScrn, int depth);
 
+/* xf86Parallel.c */
+
+typedef void (*xf86ParallelFunc) (void *data, int index);
+
+extern _X_EXPORT void
+xf86ParallelRun(xf86ParallelFunc func, void *data, int count);
+
 /* xf86Mode.c */
 
 extern _X_EXPORT ModeStatus
@@ -831,6 +831,7 @@ ddxGiveUp(enum ExitCode error)
     }
 
     xf86VGAarbiterFini();
+    xf86ParallelFini();
 
     if (xf86OSPMClose)
         xf86OSPMClose();
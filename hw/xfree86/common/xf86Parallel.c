@@ -0,0 +1,162 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ *
+ * @brief run independent pieces of CPU work on several cores
+ *
+ * For software rendering paths that have to finish a batch of independent
+ * copies before the server can go on, e.g. rotated shadows or PRIME
+ * secondary outputs.  The calling (main) thread takes part in the work
+ * and only returns once all of it is done, so the callers don't need any
+ * locking beyond not touching server state from the work function.
+ */
+#ifdef HAVE_XORG_CONFIG_H
+#include <xorg-config.h>
+#endif
+
+#if INPUTTHREAD
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+#include "xf86.h"
+#include "xf86_priv.h"
+
+#define PARALLEL_MAX_THREADS 4
+
+#if INPUTTHREAD
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    pthread_t threads[PARALLEL_MAX_THREADS];
+    int num_threads;
+    xf86ParallelFunc func;
+    void *data;
+    int count;
+    int next;
+    int busy;                   /* workers currently running items */
+    Bool quit;
+} parallel = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .start = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+};
+
+/* Run items until there are none left, called with the lock held */
+static void
+xf86ParallelTakeItems(void)
+{
+    while (parallel.next < parallel.count) {
+        int index = parallel.next++;
+
+        pthread_mutex_unlock(&parallel.lock);
+        parallel.func(parallel.data, index);
+        pthread_mutex_lock(&parallel.lock);
+    }
+}
+
+static void *
+xf86ParallelWorker(void *arg)
+{
+    sigset_t set;
+
+    /* Don't handle any signals on this thread */
+    sigfillset(&set);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+#if defined(HAVE_PTHREAD_SETNAME_NP_WITH_TID)
+    pthread_setname_np(pthread_self(), "ParallelWorker");
+#elif defined(HAVE_PTHREAD_SETNAME_NP_WITHOUT_TID)
+    pthread_setname_np("ParallelWorker");
+#endif
+
+    pthread_mutex_lock(&parallel.lock);
+    while (!parallel.quit) {
+        if (parallel.next >= parallel.count) {
+            pthread_cond_wait(&parallel.start, &parallel.lock);
+            continue;
+        }
+        parallel.busy++;
+        xf86ParallelTakeItems();
+        if (--parallel.busy == 0)
+            pthread_cond_signal(&parallel.done);
+    }
+    pthread_mutex_unlock(&parallel.lock);
+    return NULL;
+}
+
+static void
+xf86ParallelStartWorkers(void)
+{
+    long wanted = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+
+    if (wanted > PARALLEL_MAX_THREADS)
+        wanted = PARALLEL_MAX_THREADS;
+
+    while (parallel.num_threads < wanted) {
+        if (pthread_create(&parallel.threads[parallel.num_threads], NULL,
+                           xf86ParallelWorker, NULL) != 0)
+            break;
+        parallel.num_threads++;
+    }
+}
+
+#endif /* INPUTTHREAD */
+
+/**
+ * Call func(data, index) for every index in [0, count), spread over the
+ * calling thread and up to PARALLEL_MAX_THREADS workers (started on first
+ * use).  Returns once all calls are done.  Without thread support, or for
+ * a single item, everything runs on the calling thread.
+ *
+ * Must only be called from the main thread.
+ */
+void
+xf86ParallelRun(xf86ParallelFunc func, void *data, int count)
+{
+#if INPUTTHREAD
+    if (count > 1) {
+        xf86ParallelStartWorkers();
+
+        pthread_mutex_lock(&parallel.lock);
+        parallel.func = func;
+        parallel.data = data;
+        parallel.count = count;
+        parallel.next = 0;
+        pthread_cond_broadcast(&parallel.start);
+        xf86ParallelTakeItems();
+        while (parallel.busy)
+            pthread_cond_wait(&parallel.done, &parallel.lock);
+        parallel.count = 0;
+        pthread_mutex_unlock(&parallel.lock);
+        return;
+    }
+#endif
+
+    for (int i = 0; i < count; i++)
+        func(data, i);
+}
+
+/**
+ * Stop the worker threads, they are started again on the next
+ * xf86ParallelRun().
+ */
+void
+xf86ParallelFini(void)
+{
+#if INPUTTHREAD
+    pthread_mutex_lock(&parallel.lock);
+    parallel.quit = TRUE;
+    pthread_cond_broadcast(&parallel.start);
+    pthread_mutex_unlock(&parallel.lock);
+
+    for (int i = 0; i < parallel.num_threads; i++)
+        pthread_join(parallel.threads[i], NULL);
+
+    parallel.num_threads = 0;
+    parallel.quit = FALSE;
+#endif
+}
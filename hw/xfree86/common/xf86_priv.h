@@ -81,6 +81,9 @@ void xf86CloseLog(enum ExitCode error);
 Bool xf86LoadModules(const char **list, void **optlist);
 Bool xf86HasTTYs(void);
 
+/* xf86Parallel.c */
+void xf86ParallelFini(void);
+
 /* xf86Mode.c */
 _X_EXPORT /* only for int10 module, not supposed to be used by OOT modules */
 const char * xf86ModeStatusToString(ModeStatus status);
@@ -778,6 +778,258 @@ dispatch_secondary_dirty(ScreenPtr pScreen)
     }
 }
 
+/*
+ * Secondary outputs are updated with plain row copies when this screen's
+ * pixmaps are CPU memory (cpu_pixmap_access, i.e. no glamor) and both ends
+ * of the copy are pixmaps of this screen.  The copies are split into bands
+ * of MS_DIRTY_BAND_HEIGHT rows, which xf86ParallelRun() spreads over
+ * several cores.  Everything else goes through PixmapSyncDirtyHelper.
+ */
+#define MS_DIRTY_BAND_HEIGHT 64
+/* Log copy statistics of a secondary output every this many updates */
+#define MS_DIRTY_STATS_INTERVAL 1000
+
+typedef struct {
+    PixmapPtr src;
+    PixmapPtr dst;
+    int src_x, src_y;
+    int dst_x, dst_y;
+    int width, height;
+    int target;                 /* index in ms_dirty_work.targets */
+    CARD64 usec;                /* time the copy took */
+} ms_dirty_band;
+
+typedef struct {
+    PixmapDirtyUpdatePtr dirty;
+    PixmapPtr dst;
+    RegionRec pixregion;
+    uint64_t bytes;
+    CARD64 usec;                /* sum over its bands, whichever thread */
+} ms_dirty_target;
+
+static struct {
+    ms_dirty_band *bands;
+    int num_bands;
+    int size_bands;
+    ms_dirty_target *targets;
+    int num_targets;
+    int size_targets;
+} ms_dirty_work;
+
+static void
+ms_dirty_copy_band(void *data, int index)
+{
+    ms_dirty_band *band = (ms_dirty_band *) data + index;
+    CARD64 start = GetTimeInMicros();
+    int cpp = band->src->drawable.bitsPerPixel / 8;
+    const uint8_t *src = (const uint8_t *) band->src->devPrivate.ptr +
+        band->src_y * band->src->devKind + band->src_x * cpp;
+    uint8_t *dst = (uint8_t *) band->dst->devPrivate.ptr +
+        band->dst_y * band->dst->devKind + band->dst_x * cpp;
+
+    for (int y = 0; y < band->height; y++) {
+        memcpy(dst, src, band->width * cpp);
+        src += band->src->devKind;
+        dst += band->dst->devKind;
+    }
+    band->usec = GetTimeInMicros() - start;
+}
+
+static Bool
+ms_dirty_reserve_bands(int count)
+{
+    int size = ms_dirty_work.size_bands ? ms_dirty_work.size_bands : 64;
+    ms_dirty_band *bands;
+
+    if (ms_dirty_work.num_bands + count <= ms_dirty_work.size_bands)
+        return TRUE;
+
+    while (size < ms_dirty_work.num_bands + count)
+        size *= 2;
+
+    bands = reallocarray(ms_dirty_work.bands, size, sizeof(*bands));
+    if (!bands)
+        return FALSE;
+
+    ms_dirty_work.bands = bands;
+    ms_dirty_work.size_bands = size;
+    return TRUE;
+}
+
+static PixmapPtr
+ms_dirty_dst(PixmapDirtyUpdatePtr dirty)
+{
+    return dirty->secondary_dst->primary_pixmap ?
+        dirty->secondary_dst->primary_pixmap : dirty->secondary_dst;
+}
+
+/*
+ * Queue the copy for a secondary output on the CPU path, if it can take
+ * it.  Mirrors PixmapSyncDirtyHelper() for unrotated outputs.
+ */
+static Bool
+ms_dirty_queue_copy(ScreenPtr screen, PixmapDirtyUpdatePtr dirty)
+{
+    xf86CrtcConfigPtr config = XF86_CRTC_CONFIG_PTR(xf86ScreenToScrn(screen));
+    PixmapPtr dst = ms_dirty_dst(dirty);
+    PixmapPtr src;
+    ms_dirty_target *target;
+    RegionRec region;
+    BoxRec box;
+    BoxPtr b;
+    int n, count, src_x, src_y;
+
+    if (dirty->rotation != RR_Rotate_0 || !config->cpu_pixmap_access ||
+        dst->drawable.pScreen != screen)
+        return FALSE;
+
+    if (dirty->src->type == DRAWABLE_WINDOW)
+        src = screen->GetWindowPixmap((WindowPtr) dirty->src);
+    else
+        src = (PixmapPtr) dirty->src;
+
+    /* drawable to pixmap coordinates, as fbGetDrawable() does */
+    src_x = dirty->src->x;
+    src_y = dirty->src->y;
+#ifdef COMPOSITE
+    if (dirty->src->type == DRAWABLE_WINDOW) {
+        src_x -= src->screen_x;
+        src_y -= src->screen_y;
+    }
+#endif
+
+    if (src->drawable.pScreen != screen ||
+        !src->devPrivate.ptr || !dst->devPrivate.ptr ||
+        src->drawable.bitsPerPixel != dst->drawable.bitsPerPixel ||
+        src->drawable.bitsPerPixel < 8)
+        return FALSE;
+
+    if (ms_dirty_work.num_targets == ms_dirty_work.size_targets) {
+        int size = ms_dirty_work.size_targets + 4;
+        ms_dirty_target *targets = reallocarray(ms_dirty_work.targets, size,
+                                                sizeof(*targets));
+
+        if (!targets)
+            return FALSE;
+        ms_dirty_work.targets = targets;
+        ms_dirty_work.size_targets = size;
+    }
+
+    PixmapBox(&box, dst);
+    RegionInit(&region, &box, 1);
+    RegionTranslate(&region, dirty->x, dirty->y);
+    RegionIntersect(&region, &region, DamageRegion(dirty->damage));
+    RegionTranslate(&region, -dirty->x, -dirty->y);
+
+    count = 0;
+    n = RegionNumRects(&region);
+    b = RegionRects(&region);
+    while (n--) {
+        count += (b->y2 - b->y1 + MS_DIRTY_BAND_HEIGHT - 1) /
+            MS_DIRTY_BAND_HEIGHT;
+        b++;
+    }
+
+    if (!ms_dirty_reserve_bands(count)) {
+        RegionUninit(&region);
+        return FALSE;
+    }
+
+    target = &ms_dirty_work.targets[ms_dirty_work.num_targets++];
+    target->dirty = dirty;
+    target->dst = dst;
+    target->bytes = 0;
+    target->usec = 0;
+    PixmapRegionInit(&target->pixregion, dirty->secondary_dst);
+    DamageRegionAppend(&dirty->secondary_dst->drawable, &target->pixregion);
+
+    n = RegionNumRects(&region);
+    b = RegionRects(&region);
+    while (n--) {
+        for (int y = b->y1; y < b->y2; y += MS_DIRTY_BAND_HEIGHT) {
+            ms_dirty_band *band = &ms_dirty_work.bands[ms_dirty_work.num_bands++];
+
+            *band = (ms_dirty_band) {
+                .src = src,
+                .dst = dst,
+                .src_x = src_x + dirty->x + b->x1,
+                .src_y = src_y + dirty->y + y,
+                .dst_x = dirty->dst_x + b->x1,
+                .dst_y = dirty->dst_y + y,
+                .width = b->x2 - b->x1,
+                .height = min(MS_DIRTY_BAND_HEIGHT, b->y2 - y),
+                .target = ms_dirty_work.num_targets - 1,
+            };
+            target->bytes += (uint64_t) band->width * band->height *
+                (src->drawable.bitsPerPixel / 8);
+        }
+        b++;
+    }
+    RegionUninit(&region);
+    return TRUE;
+}
+
+static void
+ms_dirty_account(ScreenPtr screen, PixmapPtr dst, uint64_t bytes,
+                 CARD64 usec)
+{
+    ScrnInfoPtr scrn = xf86ScreenToScrn(screen);
+    modesettingPtr ms = modesettingPTR(scrn);
+    msPixmapPrivPtr ppriv;
+
+    /* the private key is this screen's, other screens' pixmaps, maybe of
+     * another driver, don't have it */
+    if (dst->drawable.pScreen != screen)
+        return;
+
+    ppriv = msGetPixmapPriv(&ms->drmmode, dst);
+    ppriv->dirty_bytes += bytes;
+    ppriv->dirty_usec += usec;
+    if (++ppriv->dirty_updates < MS_DIRTY_STATS_INTERVAL)
+        return;
+
+    xf86DrvMsgVerb(scrn->scrnIndex, X_INFO, MS_LOGLEVEL_DEBUG,
+                   "PRIME output pixmap %p: %u updates, %llu KiB copied, "
+                   "%llu us copy time average\n",
+                   (void *) dst, ppriv->dirty_updates,
+                   (unsigned long long) (ppriv->dirty_bytes >> 10),
+                   (unsigned long long) (ppriv->dirty_usec /
+                                         ppriv->dirty_updates));
+    ppriv->dirty_updates = 0;
+    ppriv->dirty_bytes = 0;
+    ppriv->dirty_usec = 0;
+}
+
+/* Run the queued copies and finish the updates of their outputs.  Each
+ * output is accounted the time of its own bands, which may have run on
+ * several threads at once, rather than that of the whole pass. */
+static void
+ms_dirty_run_copies(ScreenPtr screen, int *timeout)
+{
+    xf86ParallelRun(ms_dirty_copy_band, ms_dirty_work.bands,
+                    ms_dirty_work.num_bands);
+    for (int i = 0; i < ms_dirty_work.num_bands; i++) {
+        ms_dirty_band *band = &ms_dirty_work.bands[i];
+
+        ms_dirty_work.targets[band->target].usec += band->usec;
+    }
+    ms_dirty_work.num_bands = 0;
+
+    for (int i = 0; i < ms_dirty_work.num_targets; i++) {
+        ms_dirty_target *target = &ms_dirty_work.targets[i];
+
+        DamageRegionProcessPending(&target->dirty->secondary_dst->drawable);
+        RegionUninit(&target->pixregion);
+        DamageEmpty(target->dirty->damage);
+        ms_dirty_account(screen, target->dst, target->bytes, target->usec);
+    }
+    ms_dirty_work.num_targets = 0;
+
+    /* Ensure the secondary processes the damage immediately */
+    if (!screen->isGPU && timeout)
+        *timeout = 0;
+}
+
 static void
 redisplay_dirty(ScreenPtr screen, PixmapDirtyUpdatePtr dirty, int *timeout)
 {
@@ -815,6 +1067,7 @@ ms_dirty_update(ScreenPtr screen, int *timeout)
 
     RegionPtr region;
     PixmapDirtyUpdatePtr ent;
+    CARD64 copy_start;
 
     if (xorg_list_is_empty(&screen->pixmap_dirty_list))
         return;
@@ -838,10 +1091,19 @@ ms_dirty_update(ScreenPtr screen, int *timeout)
                     continue;
             }
 
+            if (ms_dirty_queue_copy(screen, ent))
+                continue;
+
+            copy_start = GetTimeInMicros();
             redisplay_dirty(screen, ent, timeout);
             DamageEmpty(ent->damage);
+            ms_dirty_account(screen, ms_dirty_dst(ent), 0,
+                             GetTimeInMicros() - copy_start);
         }
     }
+
+    if (ms_dirty_work.num_targets)
+        ms_dirty_run_copies(screen, timeout);
 }
 
 static PixmapDirtyUpdatePtr
@@ -1347,6 +1609,9 @@ PreInit(ScrnInfoPtr pScrn, int flags)
         goto fail;
     }
 
+    /* without glamor, pixmaps are fb pixmaps or mapped dumb buffers */
+    XF86_CRTC_CONFIG_PTR(pScrn)->cpu_pixmap_access = !ms->drmmode.glamor;
+
     /*
      * If the driver can do gamma correction, it should call xf86SetGamma() here.
      */
@@ -2201,6 +2466,13 @@ CloseScreen(ScreenPtr pScreen)
 
     pScreen->BlockHandler = ms->BlockHandler;
 
+    free(ms_dirty_work.bands);
+    ms_dirty_work.bands = NULL;
+    ms_dirty_work.size_bands = 0;
+    free(ms_dirty_work.targets);
+    ms_dirty_work.targets = NULL;
+    ms_dirty_work.size_targets = 0;
+
     pScrn->vtSema = FALSE;
     pScreen->CloseScreen = ms->CloseScreen;
     return (*pScreen->CloseScreen) (pScreen);
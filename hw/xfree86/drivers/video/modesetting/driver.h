@@ -88,6 +88,8 @@ typedef void (*ms_drm_abort_proc)(void *data);
  */
 struct ms_drm_queue {
     struct xorg_list list;
+    struct xorg_list hash;
+    struct xorg_list crtc_list;
     xf86CrtcPtr crtc;
     uint32_t seq;
     uint64_t msc;
@@ -210,6 +212,7 @@ void ms_drm_abort(ScrnInfoPtr scrn,
 void ms_drm_abort_seq(ScrnInfoPtr scrn, uint32_t seq);
 
 Bool ms_drm_queue_is_empty(void);
+void ms_drm_queue_crtc_fini(xf86CrtcPtr crtc);
 
 Bool xf86_crtc_on(xf86CrtcPtr crtc);
 
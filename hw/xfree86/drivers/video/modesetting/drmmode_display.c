@@ -568,7 +568,12 @@ crtc_add_dpms_props(drmModeAtomicReq *req, xf86CrtcPtr crtc,
         drmmode_output_private_ptr drmmode_output = output->driver_private;
 
         if (output->crtc != crtc) {
-            if (drmmode_output->current_crtc == crtc) {
+            /* Leave outputs moving to a CRTC of the same batched commit to
+             * that CRTC, whichever order their properties are added in.
+             */
+            if (drmmode_output->current_crtc == crtc &&
+                !(output->crtc &&
+                  ((drmmode_crtc_private_ptr) output->crtc->driver_private)->batched)) {
                 ret |= connector_add_prop(req, drmmode_output,
                                           DRMMODE_CONNECTOR_CRTC_ID, 0);
             }
@@ -785,6 +790,92 @@ drmmode_crtc_disable(xf86CrtcPtr crtc)
     return ret;
 }
 
+/*
+ * Mode sets of several CRTCs, as done for a screen resize or on VT switch,
+ * each used to be an atomic commit of their own.  Between
+ * drmmode_atomic_batch_begin() and drmmode_atomic_batch_end() the final
+ * commits of drmmode_crtc_set_mode() are only recorded, and then done as
+ * a single atomic commit, which is validated with TEST_ONLY first.  If
+ * that fails, the modes are set one by one, and the CRTCs whose mode
+ * could not be set are no longer marked active.
+ */
+static void
+drmmode_atomic_batch_begin(drmmode_ptr drmmode)
+{
+    modesettingPtr ms = modesettingPTR(drmmode->scrn);
+
+    if (ms->atomic_modeset)
+        drmmode->atomic_batch++;
+}
+
+static int
+drmmode_atomic_batch_add_props(drmmode_ptr drmmode, drmModeAtomicReq *req)
+{
+    xf86CrtcConfigPtr xf86_config = XF86_CRTC_CONFIG_PTR(drmmode->scrn);
+    int c, o, ret = 0;
+
+    for (c = 0; c < xf86_config->num_crtc; c++) {
+        xf86CrtcPtr crtc = xf86_config->crtc[c];
+        drmmode_crtc_private_ptr drmmode_crtc = crtc->driver_private;
+        Bool lost_outputs = FALSE, remaining_outputs = FALSE;
+        uint32_t fb_id;
+        Bool active;
+        int x, y;
+
+        if (drmmode_crtc->batched) {
+            if (!drmmode_crtc_get_fb_id(crtc, &fb_id, &x, &y))
+                return 1;
+
+            ret |= crtc_add_dpms_props(req, crtc, DPMSModeOn, &active);
+            ret |= plane_add_props(req, crtc, active ? fb_id : 0, x, y);
+            continue;
+        }
+
+        /* Orphaned CRTCs need to be disabled right now in atomic mode */
+        for (o = 0; o < xf86_config->num_output; o++) {
+            xf86OutputPtr output = xf86_config->output[o];
+            drmmode_output_private_ptr drmmode_output = output->driver_private;
+
+            if (drmmode_output->current_crtc != crtc)
+                continue;
+
+            if (output->crtc && output->crtc != crtc &&
+                ((drmmode_crtc_private_ptr) output->crtc->driver_private)->batched)
+                lost_outputs = TRUE;
+            else
+                remaining_outputs = TRUE;
+        }
+
+        if (lost_outputs && !remaining_outputs) {
+            ret |= crtc_add_prop(req, drmmode_crtc, DRMMODE_CRTC_ACTIVE, 0);
+            ret |= crtc_add_prop(req, drmmode_crtc, DRMMODE_CRTC_MODE_ID, 0);
+        }
+    }
+
+    return ret;
+}
+
+/* TEST_ONLY commit of the mode sets recorded in the current batch */
+static int
+drmmode_atomic_batch_test(drmmode_ptr drmmode)
+{
+    modesettingPtr ms = modesettingPTR(drmmode->scrn);
+    drmModeAtomicReq *req = drmModeAtomicAlloc();
+    int ret;
+
+    if (!req)
+        return 1;
+
+    ret = drmmode_atomic_batch_add_props(drmmode, req);
+    if (ret == 0)
+        ret = drmModeAtomicCommit(ms->fd, req,
+                                  DRM_MODE_ATOMIC_ALLOW_MODESET |
+                                  DRM_MODE_ATOMIC_TEST_ONLY, NULL);
+
+    drmModeAtomicFree(req);
+    return ret;
+}
+
 static void
 drmmode_set_ctm(xf86CrtcPtr crtc, const struct drm_color_ctm *ctm)
 {
@@ -833,6 +924,21 @@ drmmode_crtc_set_mode(xf86CrtcPtr crtc, Bool test_only)
     int i, ret = 0;
     const struct drm_color_ctm *ctm = NULL;
 
+    /* Committed together with the other CRTCs by drmmode_atomic_batch_end(),
+     * so test this mode along with the ones already recorded.
+     */
+    if (ms->atomic_modeset && drmmode->atomic_batch) {
+        Bool batched = drmmode_crtc->batched;
+
+        drmmode_crtc->batched = TRUE;
+        if (!test_only)
+            return 0;
+
+        ret = drmmode_atomic_batch_test(drmmode);
+        drmmode_crtc->batched = batched;
+        return ret;
+    }
+
     if (!drmmode_crtc_get_fb_id(crtc, &fb_id, &x, &y))
         return 1;
 
@@ -940,6 +1046,95 @@ drmmode_crtc_set_mode(xf86CrtcPtr crtc, Bool test_only)
     return ret;
 }
 
+static Bool
+drmmode_atomic_batch_end(drmmode_ptr drmmode)
+{
+    ScrnInfoPtr scrn = drmmode->scrn;
+    xf86CrtcConfigPtr xf86_config = XF86_CRTC_CONFIG_PTR(scrn);
+    modesettingPtr ms = modesettingPTR(scrn);
+    uint32_t flags = DRM_MODE_ATOMIC_ALLOW_MODESET;
+    drmModeAtomicReq *req;
+    int c, o, num_batched = 0, ret = 1;
+    Bool success = TRUE;
+
+    if (!ms->atomic_modeset || --drmmode->atomic_batch)
+        return TRUE;
+
+    for (c = 0; c < xf86_config->num_crtc; c++) {
+        drmmode_crtc_private_ptr drmmode_crtc = xf86_config->crtc[c]->driver_private;
+
+        if (drmmode_crtc->batched)
+            num_batched++;
+    }
+
+    if (!num_batched)
+        return TRUE;
+
+#ifdef GLAMOR_HAS_GBM
+    /* Make sure any pending drawing will be visible in a new scanout buffer */
+    if (drmmode->glamor)
+        glamor_finish(scrn->pScreen);
+#endif
+
+    req = drmModeAtomicAlloc();
+    if (req) {
+        ret = drmmode_atomic_batch_add_props(drmmode, req);
+        if (ret == 0)
+            ret = drmModeAtomicCommit(ms->fd, req,
+                                      flags | DRM_MODE_ATOMIC_TEST_ONLY, NULL);
+        if (ret == 0)
+            ret = drmModeAtomicCommit(ms->fd, req, flags, NULL);
+        drmModeAtomicFree(req);
+    }
+
+    if (ret == 0) {
+        for (o = 0; o < xf86_config->num_output; o++) {
+            xf86OutputPtr output = xf86_config->output[o];
+            drmmode_output_private_ptr drmmode_output = output->driver_private;
+            drmmode_crtc_private_ptr drmmode_crtc;
+
+            if (output->crtc) {
+                drmmode_crtc = output->crtc->driver_private;
+                if (drmmode_crtc->batched) {
+                    drmmode_output->current_crtc = output->crtc;
+                    continue;
+                }
+            }
+
+            /* Outputs taken off a batched CRTC */
+            if (drmmode_output->current_crtc) {
+                drmmode_crtc = drmmode_output->current_crtc->driver_private;
+                if (drmmode_crtc->batched)
+                    drmmode_output->current_crtc = NULL;
+            }
+        }
+
+        xf86DrvMsgVerb(scrn->scrnIndex, X_INFO, MS_LOGLEVEL_DEBUG,
+                       "Set the modes of %d CRTCs in one atomic commit\n",
+                       num_batched);
+    }
+
+    for (c = 0; c < xf86_config->num_crtc; c++) {
+        xf86CrtcPtr crtc = xf86_config->crtc[c];
+        drmmode_crtc_private_ptr drmmode_crtc = crtc->driver_private;
+
+        if (!drmmode_crtc->batched)
+            continue;
+
+        drmmode_crtc->batched = FALSE;
+
+        /* The combined commit failed, set the modes one by one instead */
+        if (ret && drmmode_crtc_set_mode(crtc, FALSE)) {
+            xf86DrvMsg(scrn->scrnIndex, X_ERROR,
+                       "failed to set mode: %s\n", strerror(errno));
+            crtc->active = FALSE;
+            success = FALSE;
+        }
+    }
+
+    return success;
+}
+
 int
 drmmode_crtc_flip(xf86CrtcPtr crtc, uint32_t fb_id, int x, int y,
                   uint32_t flags, void *data)
@@ -1642,6 +1837,28 @@ drmmode_create_tearfree_shadow(xf86CrtcPtr crtc)
     if (!drmmode->tearfree_enable)
         return TRUE;
 
+    /* Keep the buffers if the mode size didn't change.  Their damage
+     * still says what changed since each was last updated, unless they
+     * now show another part of the screen.
+     */
+    if (trf->buf[0].px && trf->buf[0].px->drawable.width == w &&
+        trf->buf[0].px->drawable.height == h) {
+        if (trf->flip_seq)
+            ms_drm_abort_seq(crtc->scrn, trf->flip_seq);
+
+        if (crtc->transformPresent || trf->rotation != crtc->rotation ||
+            memcmp(&trf->bounds, &crtc->bounds, sizeof(BoxRec))) {
+            for (i = 0; i < ARRAY_SIZE(trf->buf); i++)
+                RegionReset(&trf->buf[i].dmg, &crtc->bounds);
+        }
+        trf->bounds = crtc->bounds;
+        trf->rotation = crtc->rotation;
+
+        drmmode_copy_damage(crtc, trf->buf[trf->back_idx ^ 1].px,
+                            &trf->buf[trf->back_idx ^ 1].dmg, TRUE);
+        return TRUE;
+    }
+
     /* Destroy the old mode's buffers and make new ones */
     drmmode_destroy_tearfree_shadow(crtc);
     for (i = 0; i < ARRAY_SIZE(trf->buf); i++) {
@@ -1656,6 +1873,8 @@ drmmode_create_tearfree_shadow(xf86CrtcPtr crtc)
         }
         RegionInit(&trf->buf[i].dmg, &crtc->bounds, 0);
     }
+    trf->bounds = crtc->bounds;
+    trf->rotation = crtc->rotation;
 
     /* Initialize the front buffer with the current scanout */
     drmmode_copy_damage(crtc, trf->buf[trf->back_idx ^ 1].px,
@@ -2106,6 +2325,35 @@ drmmode_clear_pixmap(PixmapPtr pixmap)
     }
 }
 
+/*
+ * Shadow buffers come and go with every mode set, rotation change and
+ * TearFree resize, so their dumb buffers are recycled through a pool
+ * instead of being created and mapped again each time.
+ */
+static Bool
+drmmode_create_shadow_bo(drmmode_ptr drmmode, drmmode_bo *bo,
+                         unsigned width, unsigned height)
+{
+    if (drmmode->glamor)
+        return drmmode_create_bo(drmmode, bo, width, height, drmmode->kbpp);
+
+    bo->width = width;
+    bo->height = height;
+    bo->dumb = dumb_bo_pool_get(drmmode->fd, &drmmode->shadow_pool,
+                                width, height, drmmode->kbpp);
+    return bo->dumb != NULL;
+}
+
+static void
+drmmode_destroy_shadow_bo(drmmode_ptr drmmode, drmmode_bo *bo)
+{
+    if (bo->dumb) {
+        dumb_bo_pool_put(drmmode->fd, &drmmode->shadow_pool, bo->dumb);
+        bo->dumb = NULL;
+    }
+    drmmode_bo_destroy(drmmode, bo);
+}
+
 static void *
 drmmode_shadow_fb_allocate(xf86CrtcPtr crtc, int width, int height,
                            drmmode_bo *bo, uint32_t *fb_id)
@@ -2114,7 +2362,7 @@ drmmode_shadow_fb_allocate(xf86CrtcPtr crtc, int width, int height,
     drmmode_ptr drmmode = drmmode_crtc->drmmode;
     int ret;
 
-    if (!drmmode_create_bo(drmmode, bo, width, height, drmmode->kbpp)) {
+    if (!drmmode_create_shadow_bo(drmmode, bo, width, height)) {
         xf86DrvMsg(crtc->scrn->scrnIndex, X_ERROR,
                "Couldn't allocate shadow memory for rotated CRTC\n");
         return NULL;
@@ -2124,7 +2372,7 @@ drmmode_shadow_fb_allocate(xf86CrtcPtr crtc, int width, int height,
 
     if (ret) {
         ErrorF("failed to add rotate fb\n");
-        drmmode_bo_destroy(drmmode, bo);
+        drmmode_destroy_shadow_bo(drmmode, bo);
         return NULL;
     }
 
@@ -2237,7 +2485,7 @@ drmmode_shadow_fb_destroy(xf86CrtcPtr crtc, PixmapPtr pixmap,
         drmModeRmFB(drmmode->fd, *fb_id);
         *fb_id = 0;
 
-        drmmode_bo_destroy(drmmode, bo);
+        drmmode_destroy_shadow_bo(drmmode, bo);
         memset(bo, 0, sizeof(*bo));
     }
 }
@@ -2258,6 +2506,8 @@ drmmode_crtc_destroy(xf86CrtcPtr crtc)
     drmmode_crtc_private_ptr drmmode_crtc = crtc->driver_private;
     modesettingPtr ms = modesettingPTR(crtc->scrn);
 
+    ms_drm_queue_crtc_fini(crtc);
+
     if (!ms->atomic_modeset)
         return;
 
@@ -2586,6 +2836,7 @@ drmmode_crtc_init(ScrnInfoPtr pScrn, drmmode_ptr drmmode, drmModeResPtr mode_res
     xorg_list_init(&drmmode_crtc->mode_list);
     xorg_list_init(&drmmode_crtc->tearfree.dri_flip_list);
     drmmode_crtc->next_msc = UINT64_MAX;
+    xorg_list_init(&drmmode_crtc->drm_queue);
 
     props = drmModeObjectGetProperties(drmmode->fd, mode_res->crtcs[num],
                                        DRM_MODE_OBJECT_CRTC);
@@ -3700,6 +3951,7 @@ drmmode_xf86crtc_resize(ScrnInfoPtr scrn, int width, int height)
 
     drmmode_clear_pixmap(ppix);
 
+    drmmode_atomic_batch_begin(drmmode);
     for (i = 0; i < xf86_config->num_crtc; i++) {
         xf86CrtcPtr crtc = xf86_config->crtc[i];
 
@@ -3709,6 +3961,7 @@ drmmode_xf86crtc_resize(ScrnInfoPtr scrn, int width, int height)
         drmmode_set_mode_major(crtc, &crtc->mode,
                                crtc->rotation, crtc->x, crtc->y);
     }
+    drmmode_atomic_batch_end(drmmode);
 
     if (old_fb_id)
         drmModeRmFB(drmmode->fd, old_fb_id);
@@ -3967,10 +4220,12 @@ drmmode_set_desired_modes(ScrnInfoPtr pScrn, drmmode_ptr drmmode, Bool set_hw,
 {
     xf86CrtcConfigPtr config = XF86_CRTC_CONFIG_PTR(pScrn);
     Bool success = TRUE;
+    uint32_t mode_set = 0;      /* CRTCs set, as DRM's possible_crtcs */
     int c;
 
     drmmmode_prepare_modeset(pScrn);
 
+    drmmode_atomic_batch_begin(drmmode);
     for (c = 0; c < config->num_crtc; c++) {
         xf86CrtcPtr crtc = config->crtc[c];
         drmmode_crtc_private_ptr drmmode_crtc = crtc->driver_private;
@@ -4005,8 +4260,10 @@ drmmode_set_desired_modes(ScrnInfoPtr pScrn, drmmode_ptr drmmode, Bool set_hw,
             DisplayModePtr mode =
                 xf86OutputFindClosestMode(output, pScrn->currentMode);
 
-            if (!mode)
+            if (!mode) {
+                drmmode_atomic_batch_end(drmmode);
                 return FALSE;
+            }
             crtc->desiredMode = *mode;
             crtc->desiredRotation = RR_Rotate_0;
             crtc->desiredX = 0;
@@ -4017,8 +4274,10 @@ drmmode_set_desired_modes(ScrnInfoPtr pScrn, drmmode_ptr drmmode, Bool set_hw,
             if (!crtc->funcs->
                 set_mode_major(crtc, &crtc->desiredMode, crtc->desiredRotation,
                                crtc->desiredX, crtc->desiredY)) {
-                if (!ign_err)
+                if (!ign_err) {
+                    drmmode_atomic_batch_end(drmmode);
                     return FALSE;
+                }
                 else {
                     success = FALSE;
                     crtc->enabled = FALSE;
@@ -4026,14 +4285,34 @@ drmmode_set_desired_modes(ScrnInfoPtr pScrn, drmmode_ptr drmmode, Bool set_hw,
                                "Failed to set the desired mode on connector %s\n",
                                output->name);
                 }
-            }
+            } else
+                mode_set |= 1U << c;
         } else {
             crtc->mode = crtc->desiredMode;
             crtc->rotation = crtc->desiredRotation;
             crtc->x = crtc->desiredX;
             crtc->y = crtc->desiredY;
-            if (!xf86CrtcRotate(crtc))
+            if (!xf86CrtcRotate(crtc)) {
+                drmmode_atomic_batch_end(drmmode);
                 return FALSE;
+            }
+        }
+    }
+
+    if (!drmmode_atomic_batch_end(drmmode)) {
+        if (!ign_err)
+            return FALSE;
+
+        success = FALSE;
+        for (c = 0; c < config->num_crtc; c++) {
+            xf86CrtcPtr crtc = config->crtc[c];
+
+            if (!(mode_set & (1U << c)) || crtc->active)
+                continue;
+
+            crtc->enabled = FALSE;
+            xf86DrvMsg(pScrn->scrnIndex, X_WARNING,
+                       "Failed to set the desired mode on CRTC %d\n", c);
         }
     }
 
@@ -4525,6 +4804,8 @@ drmmode_free_bos(ScrnInfoPtr pScrn, drmmode_ptr drmmode)
         dumb_bo_destroy(drmmode->fd, drmmode_crtc->cursor_bo);
         drmmode_destroy_tearfree_shadow(crtc);
     }
+
+    dumb_bo_pool_fini(drmmode->fd, &drmmode->shadow_pool);
 }
 
 /* ugly workaround to see if we can create 32bpp */
@@ -101,6 +101,8 @@ typedef struct {
 #endif
     drmEventContext event_context;
     drmmode_bo front_bo;
+    /** Dumb buffers of destroyed rotation and TearFree shadows */
+    struct dumb_bo_pool shadow_pool;
     Bool sw_cursor;
 
     /* Broken-out options. */
@@ -141,6 +143,8 @@ typedef struct {
     Bool use_ctm;
 
     Bool pending_modeset;
+    /** Nesting depth of drmmode_atomic_batch_begin() */
+    int atomic_batch;
 } drmmode_rec, *drmmode_ptr;
 
 typedef struct {
@@ -181,6 +185,9 @@ typedef struct {
     struct xorg_list dri_flip_list;
     uint32_t back_idx;
     uint32_t flip_seq;
+    /* what the buffers hold, so a mode set can keep their contents */
+    BoxRec bounds;
+    Rotation rotation;
 } drmmode_tearfree_rec, *drmmode_tearfree_ptr;
 
 typedef struct {
@@ -221,10 +228,14 @@ typedef struct {
     /** @} */
 
     uint64_t next_msc;
+    /** Pending struct ms_drm_queue entries, in ascending MSC order */
+    struct xorg_list drm_queue;
 
     int cursor_width, cursor_height;
 
     Bool need_modeset;
+    /** Mode set deferred to the end of the current atomic batch */
+    Bool batched;
     struct xorg_list mode_list;
 
     Bool enable_flipping;
@@ -279,6 +290,11 @@ typedef struct _msPixmapPriv {
     PixmapDirtyUpdatePtr dirty; /* cached dirty ent to avoid searching list */
     DrawablePtr secondary_src; /* if we exported shared pixmap, dirty tracking src */
     Bool notify_on_damage; /* if sink has requested damage notification */
+
+    /** Copy statistics when this pixmap is a secondary output's destination */
+    uint32_t dirty_updates;
+    uint64_t dirty_bytes;
+    CARD64 dirty_usec;
 } msPixmapPrivRec, *msPixmapPrivPtr;
 
 #define msGetPixmapPriv(drmmode, p) ((msPixmapPrivPtr)dixGetPrivateAddr(&(p)->devPrivates, &(drmmode)->pixmapPrivateKeyRec))
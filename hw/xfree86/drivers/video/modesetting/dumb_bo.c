@@ -61,6 +61,9 @@ dumb_bo_create(int fd,
     bo->handle = arg.handle;
     bo->size = arg.size;
     bo->pitch = arg.pitch;
+    bo->width = width;
+    bo->height = height;
+    bo->bpp = bpp;
 
     return bo;
  err_free:
@@ -134,3 +137,57 @@ dumb_get_bo_from_fd(int fd, int handle, int pitch, int size)
     bo->size = size;
     return bo;
 }
+
+/*
+ * Take a buffer of the given size from the pool, keeping its mapping, or
+ * create a new one.  The contents of a reused buffer are whatever its
+ * last user left in it.
+ */
+struct dumb_bo *
+dumb_bo_pool_get(int fd, struct dumb_bo_pool *pool,
+                 const unsigned width, const unsigned height, const unsigned bpp)
+{
+    int i;
+
+    for (i = 0; i < pool->num_bos; i++) {
+        struct dumb_bo *bo = pool->bos[i];
+
+        if (bo->width == width && bo->height == height && bo->bpp == bpp) {
+            pool->num_bos--;
+            memmove(&pool->bos[i], &pool->bos[i + 1],
+                    (pool->num_bos - i) * sizeof(pool->bos[0]));
+            return bo;
+        }
+    }
+
+    return dumb_bo_create(fd, width, height, bpp);
+}
+
+/*
+ * Give a buffer back to the pool, destroying the least recently released
+ * one if the pool is full.  The buffer must not be referenced by a
+ * framebuffer anymore.
+ */
+void
+dumb_bo_pool_put(int fd, struct dumb_bo_pool *pool, struct dumb_bo *bo)
+{
+    if (!bo->width) {
+        dumb_bo_destroy(fd, bo);
+        return;
+    }
+
+    if (pool->num_bos == DUMB_BO_POOL_SIZE)
+        dumb_bo_destroy(fd, pool->bos[--pool->num_bos]);
+
+    memmove(&pool->bos[1], &pool->bos[0],
+            pool->num_bos * sizeof(pool->bos[0]));
+    pool->bos[0] = bo;
+    pool->num_bos++;
+}
+
+void
+dumb_bo_pool_fini(int fd, struct dumb_bo_pool *pool)
+{
+    while (pool->num_bos)
+        dumb_bo_destroy(fd, pool->bos[--pool->num_bos]);
+}
@@ -34,6 +34,19 @@ struct dumb_bo {
     uint32_t size;
     void *ptr;
     uint32_t pitch;
+    /* as created, zero for buffers imported with dumb_get_bo_from_fd */
+    unsigned width, height, bpp;
+};
+
+#define DUMB_BO_POOL_SIZE 4
+
+/*
+ * Released buffers kept, still mapped, for reuse by a later buffer of the
+ * same size; most recently released first.
+ */
+struct dumb_bo_pool {
+    struct dumb_bo *bos[DUMB_BO_POOL_SIZE];
+    int num_bos;
 };
 
 struct dumb_bo *dumb_bo_create(int fd, const unsigned width,
@@ -42,4 +55,10 @@ int dumb_bo_map(int fd, struct dumb_bo *bo);
 int dumb_bo_destroy(int fd, struct dumb_bo *bo);
 struct dumb_bo *dumb_get_bo_from_fd(int fd, int handle, int pitch, int size);
 
+struct dumb_bo *dumb_bo_pool_get(int fd, struct dumb_bo_pool *pool,
+                                 const unsigned width, const unsigned height,
+                                 const unsigned bpp);
+void dumb_bo_pool_put(int fd, struct dumb_bo_pool *pool, struct dumb_bo *bo);
+void dumb_bo_pool_fini(int fd, struct dumb_bo_pool *pool);
+
 #endif
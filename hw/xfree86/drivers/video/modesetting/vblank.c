@@ -34,6 +34,7 @@
 #include <xf86Crtc.h>
 #include "driver.h"
 #include "drmmode_display.h"
+#include "misync.h"
 
 /**
  * Tracking for outstanding events queued to the kernel.
@@ -45,8 +46,21 @@
  * to drain the list of event handlers that should be called at server
  * regen time, even though we don't close the drm fd and have no way
  * to actually drain the kernel events.
+ *
+ * Besides the global list, which is kept in the order the entries were
+ * allocated, every entry is hashed by its sequence number and linked
+ * into its CRTC's queue, which is sorted by target MSC.  That keeps the
+ * event handler from walking the events of all CRTCs on every vblank.
+ * Freed entries are kept in a small pool for reuse.
  */
+#define MS_DRM_QUEUE_HASH_SIZE 256 /* power of two */
+#define MS_DRM_QUEUE_POOL_MAX 64
+
 static struct xorg_list ms_drm_queue;
+static struct xorg_list ms_drm_queue_hash[MS_DRM_QUEUE_HASH_SIZE];
+static struct xorg_list ms_drm_queue_pool;
+static int ms_drm_queue_pool_size;
+static Bool ms_drm_queue_initialized;
 static uint32_t ms_drm_seq;
 
 static void box_intersect(BoxPtr dest, BoxPtr a, BoxPtr b)
@@ -260,34 +274,90 @@ ms_get_kernel_ust_msc(xf86CrtcPtr crtc,
     }
 }
 
-static void
-ms_drm_set_seq_msc(uint32_t seq, uint64_t msc)
+static struct ms_drm_queue *
+ms_drm_queue_lookup(uint32_t seq)
 {
+    struct xorg_list *bucket =
+        &ms_drm_queue_hash[seq & (MS_DRM_QUEUE_HASH_SIZE - 1)];
     struct ms_drm_queue *q;
 
-    xorg_list_for_each_entry(q, &ms_drm_queue, list) {
-        if (q->seq == seq) {
-            q->msc = msc;
+    xorg_list_for_each_entry(q, bucket, hash) {
+        if (q->seq == seq)
+            return q;
+    }
+
+    return NULL;
+}
+
+/**
+ * Link an entry into its CRTC's queue, after all entries with a target
+ * MSC not later than its own.  New entries mostly target the latest MSC,
+ * so the queue is searched from its tail.
+ */
+static void
+ms_drm_queue_link_crtc(struct ms_drm_queue *q)
+{
+    drmmode_crtc_private_ptr drmmode_crtc = q->crtc->driver_private;
+    struct xorg_list *pos;
+
+    for (pos = drmmode_crtc->drm_queue.prev; pos != &drmmode_crtc->drm_queue;
+         pos = pos->prev) {
+        struct ms_drm_queue *prev =
+            xorg_list_entry(pos, struct ms_drm_queue, crtc_list);
+
+        if (prev->msc <= q->msc)
             break;
-        }
     }
+
+    xorg_list_add(&q->crtc_list, pos);
+}
+
+static void
+ms_drm_queue_set_msc(struct ms_drm_queue *q, uint64_t msc)
+{
+    if (q->msc == msc)
+        return;
+
+    xorg_list_del(&q->crtc_list);
+    q->msc = msc;
+    ms_drm_queue_link_crtc(q);
+}
+
+static void
+ms_drm_queue_free(struct ms_drm_queue *q)
+{
+    xorg_list_del(&q->list);
+    xorg_list_del(&q->hash);
+    xorg_list_del(&q->crtc_list);
+
+    if (ms_drm_queue_pool_size < MS_DRM_QUEUE_POOL_MAX) {
+        xorg_list_add(&q->list, &ms_drm_queue_pool);
+        ms_drm_queue_pool_size++;
+    } else
+        free(q);
+}
+
+static void
+ms_drm_set_seq_msc(uint32_t seq, uint64_t msc)
+{
+    struct ms_drm_queue *q = ms_drm_queue_lookup(seq);
+
+    if (q)
+        ms_drm_queue_set_msc(q, msc);
 }
 
 static void
 ms_drm_set_seq_queued(uint32_t seq, uint64_t msc)
 {
     drmmode_crtc_private_ptr drmmode_crtc;
-    struct ms_drm_queue *q;
-
-    xorg_list_for_each_entry(q, &ms_drm_queue, list) {
-        if (q->seq == seq) {
-            drmmode_crtc = q->crtc->driver_private;
-            if (msc < drmmode_crtc->next_msc)
-                drmmode_crtc->next_msc = msc;
-            q->msc = msc;
-            q->kernel_queued = TRUE;
-            break;
-        }
+    struct ms_drm_queue *q = ms_drm_queue_lookup(seq);
+
+    if (q) {
+        drmmode_crtc = q->crtc->driver_private;
+        if (msc < drmmode_crtc->next_msc)
+            drmmode_crtc->next_msc = msc;
+        ms_drm_queue_set_msc(q, msc);
+        q->kernel_queued = TRUE;
     }
 }
 
@@ -435,7 +505,8 @@ ms_get_crtc_ust_msc(xf86CrtcPtr crtc, CARD64 *ust, CARD64 *msc)
 }
 
 /**
- * Check for pending DRM events and process them.
+ * Check for pending DRM events and process them.  Fences triggered by the
+ * events read in one go wake up their waiters together afterwards.
  */
 static void
 ms_drm_socket_handler(int fd, int ready, void *data)
@@ -447,7 +518,9 @@ ms_drm_socket_handler(int fd, int ready, void *data)
     if (data == NULL)
         return;
 
+    miSyncBeginFenceBatch();
     drmHandleEvent(fd, &ms->event_context);
+    miSyncEndFenceBatch();
 }
 
 /*
@@ -464,7 +537,13 @@ ms_drm_queue_alloc(xf86CrtcPtr crtc,
     ScrnInfoPtr scrn = xf86ScreenToScrn(screen);
     struct ms_drm_queue *q;
 
-    q = calloc(1, sizeof(struct ms_drm_queue));
+    if (!xorg_list_is_empty(&ms_drm_queue_pool)) {
+        q = xorg_list_first_entry(&ms_drm_queue_pool, struct ms_drm_queue, list);
+        xorg_list_del(&q->list);
+        ms_drm_queue_pool_size--;
+        memset(q, 0, sizeof(*q));
+    } else
+        q = calloc(1, sizeof(struct ms_drm_queue));
 
     if (!q)
         return 0;
@@ -480,6 +559,9 @@ ms_drm_queue_alloc(xf86CrtcPtr crtc,
 
     /* Keep the list formatted in ascending order of sequence number */
     xorg_list_append(&q->list, &ms_drm_queue);
+    xorg_list_add(&q->hash,
+                  &ms_drm_queue_hash[q->seq & (MS_DRM_QUEUE_HASH_SIZE - 1)]);
+    ms_drm_queue_link_crtc(q);
 
     return q->seq;
 }
@@ -501,8 +583,10 @@ ms_drm_abort_one(struct ms_drm_queue *q)
         q->aborted = TRUE;
     } else {
         xorg_list_del(&q->list);
+        xorg_list_del(&q->hash);
+        xorg_list_del(&q->crtc_list);
         q->abort(q->data);
-        free(q);
+        ms_drm_queue_free(q);
     }
 }
 
@@ -527,14 +611,10 @@ ms_drm_abort_scrn(ScrnInfoPtr scrn)
 void
 ms_drm_abort_seq(ScrnInfoPtr scrn, uint32_t seq)
 {
-    struct ms_drm_queue *q, *tmp;
+    struct ms_drm_queue *q = ms_drm_queue_lookup(seq);
 
-    xorg_list_for_each_entry_safe(q, tmp, &ms_drm_queue, list) {
-        if (q->seq == seq) {
-            ms_drm_abort_one(q);
-            break;
-        }
-    }
+    if (q)
+        ms_drm_abort_one(q);
 }
 
 /*
@@ -564,64 +644,78 @@ ms_drm_sequence_handler(int fd, uint64_t frame, uint64_t ns, Bool is64bit, uint6
 {
     struct ms_drm_queue *q, *tmp;
     uint32_t seq = (uint32_t) user_data;
-    xf86CrtcPtr crtc = NULL;
+    xf86CrtcPtr crtc;
     drmmode_crtc_private_ptr drmmode_crtc;
     uint64_t msc, next_msc = UINT64_MAX;
 
     /* Handle the seq for this event first in order to get the CRTC */
-    xorg_list_for_each_entry(q, &ms_drm_queue, list) {
-        if (q->seq == seq) {
-            crtc = q->crtc;
-            msc = ms_kernel_msc_to_crtc_msc(crtc, frame, is64bit);
-
-            /* Write the current MSC to this event to ensure its handler runs in
-             * the loop below. This is done because we don't want to run the
-             * handler right now, since we need to ensure all events are handled
-             * in FIFO order with respect to one another. Otherwise, if this
-             * event were handled first just because it was queued to the
-             * kernel, it could run before older events expiring at this MSC.
-             */
-            q->msc = msc;
-            break;
-        }
-    }
-
-    if (!crtc)
+    q = ms_drm_queue_lookup(seq);
+    if (!q)
         return;
 
-    /* Now run all of the vblank events for this CRTC with an expired MSC */
-    xorg_list_for_each_entry_safe(q, tmp, &ms_drm_queue, list) {
-        if (q->crtc == crtc && q->msc <= msc) {
-            xorg_list_del(&q->list);
-            if (!q->aborted)
-                q->handler(msc, ns / 1000, q->data);
-            free(q);
+    crtc = q->crtc;
+    drmmode_crtc = crtc->driver_private;
+    msc = ms_kernel_msc_to_crtc_msc(crtc, frame, is64bit);
+
+    /* Write the current MSC to this event to ensure its handler runs in
+     * the loop below. This is done because we don't want to run the
+     * handler right now, since we need to ensure all events are handled
+     * in FIFO order with respect to one another. Otherwise, if this
+     * event were handled first just because it was queued to the
+     * kernel, it could run before older events expiring at this MSC.
+     */
+    ms_drm_queue_set_msc(q, msc);
+
+    /* Now run all of the vblank events for this CRTC with an expired MSC,
+     * oldest first.  The expired events are the head of the CRTC's queue;
+     * look the oldest of them up again after every handler, since
+     * handlers may queue or abort other events.
+     */
+    for (;;) {
+        struct ms_drm_queue *oldest = NULL;
+
+        xorg_list_for_each_entry(q, &drmmode_crtc->drm_queue, crtc_list) {
+            if (q->msc > msc)
+                break;
+            if (!oldest || (int32_t) (q->seq - oldest->seq) < 0)
+                oldest = q;
         }
+
+        if (!oldest)
+            break;
+
+        xorg_list_del(&oldest->list);
+        xorg_list_del(&oldest->hash);
+        xorg_list_del(&oldest->crtc_list);
+        if (!oldest->aborted)
+            oldest->handler(msc, ns / 1000, oldest->data);
+        ms_drm_queue_free(oldest);
     }
 
     /* Find this CRTC's next queued MSC and next non-queued MSC to be handled */
     msc = UINT64_MAX;
-    xorg_list_for_each_entry(q, &ms_drm_queue, list) {
-        if (q->crtc == crtc) {
-            if (q->kernel_queued) {
-                if (q->msc < next_msc)
-                    next_msc = q->msc;
-            } else if (q->msc < msc) {
-                msc = q->msc;
-                seq = q->seq;
-            }
+    xorg_list_for_each_entry(q, &drmmode_crtc->drm_queue, crtc_list) {
+        if (q->kernel_queued) {
+            if (next_msc == UINT64_MAX)
+                next_msc = q->msc;
+        } else if (msc == UINT64_MAX) {
+            msc = q->msc;
+            seq = q->seq;
         }
+
+        if (next_msc != UINT64_MAX && msc != UINT64_MAX)
+            break;
     }
 
     /* Queue an event if the next queued MSC isn't soon enough */
-    drmmode_crtc = crtc->driver_private;
     drmmode_crtc->next_msc = next_msc;
     if (msc < next_msc && !ms_queue_vblank(crtc, MS_QUEUE_ABSOLUTE, msc, NULL, seq)) {
         xf86DrvMsg(crtc->scrn->scrnIndex, X_WARNING,
                    "failed to queue next vblank event, aborting lost events\n");
-        xorg_list_for_each_entry_safe(q, tmp, &ms_drm_queue, list) {
-            if (q->crtc == crtc && q->msc < next_msc)
-                ms_drm_abort_one(q);
+        xorg_list_for_each_entry_safe(q, tmp, &drmmode_crtc->drm_queue, crtc_list) {
+            if (q->msc >= next_msc)
+                break;
+            ms_drm_abort_one(q);
         }
     }
 }
@@ -654,7 +748,15 @@ ms_vblank_screen_init(ScreenPtr screen)
     ScrnInfoPtr scrn = xf86ScreenToScrn(screen);
     modesettingPtr ms = modesettingPTR(scrn);
     modesettingEntPtr ms_ent = ms_ent_priv(scrn);
-    xorg_list_init(&ms_drm_queue);
+
+    /* Kept across server generations, see ms_drm_queue above */
+    if (!ms_drm_queue_initialized) {
+        xorg_list_init(&ms_drm_queue);
+        for (int i = 0; i < MS_DRM_QUEUE_HASH_SIZE; i++)
+            xorg_list_init(&ms_drm_queue_hash[i]);
+        xorg_list_init(&ms_drm_queue_pool);
+        ms_drm_queue_initialized = TRUE;
+    }
 
     ms->event_context.version = 4;
     ms->event_context.vblank_handler = ms_drm_handler;
@@ -688,4 +790,33 @@ ms_vblank_close_screen(ScreenPtr screen)
         !--ms_ent->fd_wakeup_ref) {
         RemoveNotifyFd(ms->fd);
     }
+
+    if (xorg_list_is_empty(&ms_drm_queue)) {
+        struct ms_drm_queue *q, *tmp;
+
+        xorg_list_for_each_entry_safe(q, tmp, &ms_drm_queue_pool, list) {
+            xorg_list_del(&q->list);
+            free(q);
+        }
+        ms_drm_queue_pool_size = 0;
+    }
+}
+
+/**
+ * Drop the events still queued on a CRTC that is going away.  They have
+ * all been aborted by ms_vblank_close_screen() already, but may still
+ * be waiting for their kernel event.
+ */
+void
+ms_drm_queue_crtc_fini(xf86CrtcPtr crtc)
+{
+    drmmode_crtc_private_ptr drmmode_crtc = crtc->driver_private;
+    struct ms_drm_queue *q, *tmp;
+
+    xorg_list_for_each_entry_safe(q, tmp, &drmmode_crtc->drm_queue, crtc_list) {
+        xorg_list_del(&q->list);
+        xorg_list_del(&q->hash);
+        xorg_list_del(&q->crtc_list);
+        free(q);
+    }
 }
@@ -828,6 +828,14 @@ typedef struct _xf86CrtcConfig {
 #else
     void *randr_provider;
 #endif
+
+    /**
+     * Set by drivers whose pixmaps, including the screen pixmap and the
+     * rotation shadows, are plain CPU memory at devPrivate.ptr that needs
+     * no acceleration architecture access hooks or synchronization.  Lets
+     * rotation update shadows with pixman directly.
+     */
+    Bool cpu_pixmap_access;
 } xf86CrtcConfigRec, *xf86CrtcConfigPtr;
 
 extern _X_EXPORT int xf86CrtcConfigPrivateIndex;
@@ -110,6 +110,212 @@ xf86RotateCrtcRedisplay(xf86CrtcPtr crtc, PixmapPtr dst_pixmap,
     FreePicture(dst, None);
 }
 
+/*
+ * Software rotation.
+ *
+ * When both the screen pixmap and a CRTC's shadow are in system memory,
+ * the shadow is updated with pixman directly instead of going through
+ * Render, which lets pixman use its rotation fast paths.  The damaged
+ * area is split into bands of ROTATE_BAND_HEIGHT rows, and the bands of
+ * all CRTCs are spread over several cores with xf86ParallelRun().
+ */
+#define ROTATE_BAND_HEIGHT 64
+
+/* Each band has pixman images of its own: pixman validates images lazily
+ * on first use, which is not safe to do from several threads at once. */
+typedef struct {
+    pixman_image_t *src;
+    pixman_image_t *dst;
+    BoxRec box;                 /* in shadow coordinates */
+} xf86RotateBandRec;
+
+typedef struct {
+    PixmapPtr src_pixmap;
+    PixmapPtr dst_pixmap;
+    pixman_format_code_t format;
+    const struct pixman_transform *transform;
+    RegionRec damage;           /* shadow area being updated */
+} xf86RotateTargetRec;
+
+static struct {
+    xf86RotateBandRec *bands;
+    int num_bands;
+    int size_bands;
+    xf86RotateTargetRec *targets;
+    int num_targets;
+    int size_targets;
+} rotateWork;
+
+static void
+xf86RotateRunBand(void *data, int index)
+{
+    const xf86RotateBandRec *band = (xf86RotateBandRec *) data + index;
+
+    pixman_image_composite32(PIXMAN_OP_SRC, band->src, NULL, band->dst,
+                             band->box.x1, band->box.y1, 0, 0,
+                             band->box.x1, band->box.y1,
+                             band->box.x2 - band->box.x1,
+                             band->box.y2 - band->box.y1);
+}
+
+static pixman_image_t *
+xf86RotatePixmapImage(PixmapPtr pixmap, pixman_format_code_t format)
+{
+    return pixman_image_create_bits(format,
+                                    pixmap->drawable.width,
+                                    pixmap->drawable.height,
+                                    pixmap->devPrivate.ptr,
+                                    pixmap->devKind);
+}
+
+static Bool
+xf86RotateAddBand(xf86RotateTargetRec *target, const BoxRec *box)
+{
+    pixman_image_t *src, *dst;
+
+    if (rotateWork.num_bands == rotateWork.size_bands) {
+        int size = rotateWork.size_bands ? rotateWork.size_bands * 2 : 64;
+        xf86RotateBandRec *bands = reallocarray(rotateWork.bands, size,
+                                                sizeof(*bands));
+
+        if (!bands)
+            return FALSE;
+        rotateWork.bands = bands;
+        rotateWork.size_bands = size;
+    }
+
+    src = xf86RotatePixmapImage(target->src_pixmap, target->format);
+    dst = xf86RotatePixmapImage(target->dst_pixmap, target->format);
+    if (!src || !dst || !pixman_image_set_transform(src, target->transform)) {
+        if (src)
+            pixman_image_unref(src);
+        if (dst)
+            pixman_image_unref(dst);
+        return FALSE;
+    }
+
+    rotateWork.bands[rotateWork.num_bands++] = (xf86RotateBandRec) {
+        .src = src, .dst = dst, .box = *box,
+    };
+    return TRUE;
+}
+
+/* Clip a box to the shadow and queue it as bands */
+static Bool
+xf86RotateAddBox(xf86RotateTargetRec *target, BoxRec box)
+{
+    PixmapPtr dst = target->dst_pixmap;
+    RegionRec region;
+
+    box.x1 = max(box.x1, 0);
+    box.y1 = max(box.y1, 0);
+    box.x2 = min(box.x2, dst->drawable.width);
+    box.y2 = min(box.y2, dst->drawable.height);
+    if (box.x1 >= box.x2 || box.y1 >= box.y2)
+        return TRUE;
+
+    RegionInit(&region, &box, 1);
+    RegionUnion(&target->damage, &target->damage, &region);
+    RegionUninit(&region);
+
+    for (int y = box.y1; y < box.y2; y += ROTATE_BAND_HEIGHT) {
+        BoxRec band = box;
+
+        band.y1 = y;
+        band.y2 = min(y + ROTATE_BAND_HEIGHT, box.y2);
+        if (!xf86RotateAddBand(target, &band))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * Queue the update of a CRTC's shadow with pixman, if it can be done
+ * without Render: the driver has to promise that its pixmaps are plain CPU
+ * memory (cpu_pixmap_access), and filtered transforms are left to Render.
+ *
+ * @return FALSE if the caller has to use xf86RotateCrtcRedisplay()
+ */
+static Bool
+xf86RotateQueueCrtc(xf86CrtcPtr crtc, PixmapPtr dst_pixmap,
+                    PixmapPtr src_pixmap, RegionPtr region)
+{
+    ScreenPtr screen = crtc->scrn->pScreen;
+    xf86CrtcConfigPtr config = XF86_CRTC_CONFIG_PTR(crtc->scrn);
+    PictFormatPtr format = PictureWindowFormat(screen->root);
+    xf86RotateTargetRec *target;
+    int n = RegionNumRects(region);
+    BoxPtr b = RegionRects(region);
+
+    if (crtc->driverIsPerformingTransform & XF86DriverTransformOutput)
+        return TRUE;
+
+    if (!config->cpu_pixmap_access || !format || crtc->filter ||
+        !src_pixmap->devPrivate.ptr || !dst_pixmap->devPrivate.ptr ||
+        PIXMAN_FORMAT_BPP(format->format) != src_pixmap->drawable.bitsPerPixel ||
+        PIXMAN_FORMAT_BPP(format->format) != dst_pixmap->drawable.bitsPerPixel)
+        return FALSE;
+
+    if (rotateWork.num_targets == rotateWork.size_targets) {
+        int size = rotateWork.size_targets + 4;
+        xf86RotateTargetRec *targets = reallocarray(rotateWork.targets, size,
+                                                    sizeof(*targets));
+
+        if (!targets)
+            return FALSE;
+        rotateWork.targets = targets;
+        rotateWork.size_targets = size;
+    }
+
+    target = &rotateWork.targets[rotateWork.num_targets];
+    target->src_pixmap = src_pixmap;
+    target->dst_pixmap = dst_pixmap;
+    target->format = format->format;
+    target->transform = &crtc->crtc_to_framebuffer;
+    RegionNull(&target->damage);
+    rotateWork.num_targets++;
+
+    if (crtc->shadowClear) {
+        BoxRec box = { 0, 0, crtc->mode.HDisplay, crtc->mode.VDisplay };
+
+        if (xf86RotateAddBox(target, box))
+            crtc->shadowClear = FALSE;
+        return TRUE;
+    }
+
+    while (n--) {
+        BoxRec dst_box = *b++;
+
+        pixman_f_transform_bounds(&crtc->f_framebuffer_to_crtc, &dst_box);
+        if (!xf86RotateAddBox(target, dst_box)) {
+            /* repaint all of it next time */
+            crtc->shadowClear = TRUE;
+            break;
+        }
+    }
+    return TRUE;
+}
+
+/* Run the queued shadow updates and tell damage about them */
+static void
+xf86RotateFinish(void)
+{
+    xf86ParallelRun(xf86RotateRunBand, rotateWork.bands, rotateWork.num_bands);
+    for (int i = 0; i < rotateWork.num_bands; i++) {
+        pixman_image_unref(rotateWork.bands[i].src);
+        pixman_image_unref(rotateWork.bands[i].dst);
+    }
+    rotateWork.num_bands = 0;
+
+    for (int i = 0; i < rotateWork.num_targets; i++) {
+        xf86RotateTargetRec *target = &rotateWork.targets[i];
+
+        DamageDamageRegion(&target->dst_pixmap->drawable, &target->damage);
+        RegionUninit(&target->damage);
+    }
+    rotateWork.num_targets = 0;
+}
+
 static void
 xf86CrtcDamageShadow(xf86CrtcPtr crtc)
 {
@@ -188,6 +394,7 @@ xf86RotateRedisplay(ScreenPtr pScreen)
     if (RegionNotEmpty(region)) {
         int c;
         SourceValidateProcPtr SourceValidate;
+        PixmapPtr src_pixmap = (*pScreen->GetWindowPixmap) (pScreen->root);
 
         /*
          * SourceValidate is used by the software cursor code
@@ -209,7 +416,9 @@ xf86RotateRedisplay(ScreenPtr pScreen)
                 RegionIntersect(&crtc_damage, &crtc_damage, region);
 
                 /* update damaged region */
-                if (RegionNotEmpty(&crtc_damage))
+                if (RegionNotEmpty(&crtc_damage) &&
+                    !xf86RotateQueueCrtc(crtc, crtc->rotatedPixmap,
+                                         src_pixmap, &crtc_damage))
                     xf86RotateCrtcRedisplay(crtc, crtc->rotatedPixmap,
                                             &pScreen->root->drawable,
                                             &crtc_damage, TRUE);
@@ -217,6 +426,7 @@ xf86RotateRedisplay(ScreenPtr pScreen)
                 RegionUninit(&crtc_damage);
             }
         }
+        xf86RotateFinish();
         pScreen->SourceValidate = SourceValidate;
         DamageEmpty(damage);
     }
@@ -309,6 +519,13 @@ xf86RotateCloseScreen(ScreenPtr screen)
     xf86_config->rotation_damage = NULL;
     for (c = 0; c < xf86_config->num_crtc; c++)
         xf86RotateDestroy(xf86_config->crtc[c]);
+
+    free(rotateWork.bands);
+    rotateWork.bands = NULL;
+    rotateWork.size_bands = 0;
+    free(rotateWork.targets);
+    rotateWork.targets = NULL;
+    rotateWork.size_targets = 0;
 }
 
 static Bool
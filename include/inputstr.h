@@ -316,6 +316,9 @@ typedef struct _TouchPointInfo {
     DeviceEvent *history;       /* History of events on this touchpoint */
     size_t history_elements;    /* Number of current elements in history */
     size_t history_size;        /* Size of history in elements */
+    size_t history_start;       /* ring position of the oldest TouchUpdate */
+    DeviceEvent *history_buffer; /* storage for history, part of the touch
+                                  * class' history_pool if there is room */
 } TouchPointInfoRec;
 
 typedef struct _TouchClassRec {
@@ -323,6 +326,9 @@ typedef struct _TouchClassRec {
     TouchPointInfoPtr touches;
     unsigned short num_touches; /* number of allocated touches */
     unsigned short max_touches; /* maximum number of touches, may be 0 */
+    DeviceEvent *history_pool;  /* event history storage for the first
+                                 * history_pool_touches touches */
+    unsigned short history_pool_touches;
     CARD8 mode;                 /* ::XIDirectTouch, XIDependentTouch */
     /* for pointer-emulation */
     CARD8 buttonsDown;          /* number of buttons down */
@@ -512,6 +518,7 @@ typedef struct _SpriteInfoRec {
         CursorPtr pCursor;
         ScreenPtr pScreen;
         int elt;
+        CARD32 time;            /* when the next frame is due */
     } anim;
 } SpriteInfoRec, *SpriteInfoPtr;
 
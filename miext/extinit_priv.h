@@ -29,6 +29,9 @@ extern Bool noNamespaceExtension;
 
 extern char *namespaceConfigFile;
 
+/* batch interval for DAMAGE rectangle events in ms, -1 to not batch */
+extern int damageBatchInterval;
+
 void CompositeExtensionInit(void);
 void DamageExtensionInit(void);
 void DbeExtensionInit(void);
@@ -29,6 +29,10 @@
 
 DevPrivateKeyRec miSyncScreenPrivateKey;
 
+CallbackListPtr miSyncFenceBatchCallback;
+
+static int fenceBatchDepth;
+
 /* Default implementations of the sync screen functions */
 void
 miSyncScreenCreateFence(ScreenPtr pScreen, SyncFence * pFence,
@@ -141,6 +145,31 @@ miSyncTriggerFence(SyncFence * pFence)
     }
 }
 
+/*
+ * Fences triggered between miSyncBeginFenceBatch and miSyncEndFenceBatch
+ * are triggered as far as the server is concerned right away, but their
+ * implementation may put off waking up other processes waiting for them
+ * until the batch ends, to wake them all at once.  Batches nest.
+ */
+void
+miSyncBeginFenceBatch(void)
+{
+    fenceBatchDepth++;
+}
+
+void
+miSyncEndFenceBatch(void)
+{
+    if (fenceBatchDepth > 0 && !--fenceBatchDepth)
+        CallCallbacks(&miSyncFenceBatchCallback, NULL);
+}
+
+Bool
+miSyncFenceBatchOpen(void)
+{
+    return fenceBatchDepth > 0;
+}
+
 SyncScreenFuncsPtr
 miSyncGetScreenFuncs(ScreenPtr pScreen)
 {
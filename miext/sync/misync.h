@@ -73,6 +73,12 @@ extern _X_EXPORT void
 extern _X_EXPORT void
  miSyncTriggerFence(SyncFence * pFence);
 
+extern _X_EXPORT void
+ miSyncBeginFenceBatch(void);
+
+extern _X_EXPORT void
+ miSyncEndFenceBatch(void);
+
 extern _X_EXPORT SyncScreenFuncsPtr miSyncGetScreenFuncs(ScreenPtr pScreen);
 extern _X_EXPORT Bool
  miSyncSetup(ScreenPtr pScreen);
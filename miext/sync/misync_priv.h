@@ -24,6 +24,10 @@ void miSyncFenceSetTriggered(SyncFence * pFence);
 void miSyncFenceReset(SyncFence * pFence);
 void miSyncFenceAddTrigger(SyncTrigger * pTrigger);
 void miSyncFenceDeleteTrigger(SyncTrigger * pTrigger);
+/* called when the outermost fence batch ends */
+extern CallbackListPtr miSyncFenceBatchCallback;
+
+Bool miSyncFenceBatchOpen(void);
 int miSyncInitFenceFromFD(DrawablePtr pDraw, SyncFence *pFence, int fd, BOOL initially_triggered);
 int miSyncFDFromFence(DrawablePtr pDraw, SyncFence *pFence);
 
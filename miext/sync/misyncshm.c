@@ -35,14 +35,20 @@
 #include "misyncshm.h"
 #include "misyncfd.h"
 #include "pixmapstr.h"
+#include "list.h"
 
 static DevPrivateKeyRec syncShmFencePrivateKey;
 
 typedef struct _SyncShmFencePrivate {
     struct xshmfence    *fence;
     int                 fd;
+    struct xorg_list    pending;        /* in pendingTriggers */
 } SyncShmFencePrivateRec, *SyncShmFencePrivatePtr;
 
+/* fences triggered in the current fence batch, whose waiters have not been
+ * woken up yet */
+static struct xorg_list pendingTriggers;
+
 #define SYNC_FENCE_PRIV(pFence) \
     (SyncShmFencePrivatePtr) dixLookupPrivate(&pFence->devPrivates, &syncShmFencePrivateKey)
 
@@ -51,16 +57,32 @@ miSyncShmFenceSetTriggered(SyncFence * pFence)
 {
     SyncShmFencePrivatePtr      pPriv = SYNC_FENCE_PRIV(pFence);
 
-    if (pPriv->fence)
-        xshmfence_trigger(pPriv->fence);
+    if (pPriv->fence) {
+        if (!miSyncFenceBatchOpen())
+            xshmfence_trigger(pPriv->fence);
+        else if (xorg_list_is_empty(&pPriv->pending))
+            xorg_list_append(&pPriv->pending, &pendingTriggers);
+    }
     miSyncFenceSetTriggered(pFence);
 }
 
+static void
+miSyncShmFlushTriggers(CallbackListPtr *pcbl, void *unused, void *calldata)
+{
+    SyncShmFencePrivatePtr pPriv, tmp;
+
+    xorg_list_for_each_entry_safe(pPriv, tmp, &pendingTriggers, pending) {
+        xorg_list_del(&pPriv->pending);
+        xshmfence_trigger(pPriv->fence);
+    }
+}
+
 static void
 miSyncShmFenceReset(SyncFence * pFence)
 {
     SyncShmFencePrivatePtr      pPriv = SYNC_FENCE_PRIV(pFence);
 
+    xorg_list_del(&pPriv->pending);
     if (pPriv->fence)
         xshmfence_reset(pPriv->fence);
     miSyncFenceReset(pFence);
@@ -72,7 +94,8 @@ miSyncShmFenceCheckTriggered(SyncFence * pFence)
     SyncShmFencePrivatePtr      pPriv = SYNC_FENCE_PRIV(pFence);
 
     if (pPriv->fence)
-        return xshmfence_query(pPriv->fence);
+        return !xorg_list_is_empty(&pPriv->pending) ||
+            xshmfence_query(pPriv->fence);
     else
         return miSyncFenceCheckTriggered(pFence);
 }
@@ -104,6 +127,7 @@ miSyncShmScreenCreateFence(ScreenPtr pScreen, SyncFence * pFence,
     SyncShmFencePrivatePtr      pPriv = SYNC_FENCE_PRIV(pFence);
 
     pPriv->fence = NULL;
+    xorg_list_init(&pPriv->pending);
     miSyncScreenCreateFence(pScreen, pFence, initially_triggered);
     pFence->funcs = miSyncShmFenceFuncs;
 }
@@ -113,6 +137,7 @@ miSyncShmScreenDestroyFence(ScreenPtr pScreen, SyncFence * pFence)
 {
     SyncShmFencePrivatePtr      pPriv = SYNC_FENCE_PRIV(pFence);
 
+    xorg_list_del(&pPriv->pending);
     if (pPriv->fence) {
         xshmfence_trigger(pPriv->fence);
         xshmfence_unmap_shm(pPriv->fence);
@@ -175,6 +200,10 @@ Bool miSyncShmScreenInit(ScreenPtr pScreen)
         if (!dixRegisterPrivateKey(&syncShmFencePrivateKey, PRIVATE_SYNC_FENCE,
                                    sizeof(SyncShmFencePrivateRec)))
             return FALSE;
+        xorg_list_init(&pendingTriggers);
+        if (!AddCallback(&miSyncFenceBatchCallback, miSyncShmFlushTriggers,
+                         NULL))
+            return FALSE;
     }
 
     funcs = miSyncGetScreenFuncs(pScreen);
@@ -1063,14 +1063,20 @@ xtransLocalClient(ClientPtr client)
     return FALSE;
 }
 
-/* Is client on the local host */
+/* Is client on the local host, as far as the transport can tell */
 Bool
 ComputeLocalClient(ClientPtr client)
 {
-    const char *cmdname = GetClientCmdName(client);
+    return xtransLocalClient(client);
+}
 
-    if (!xtransLocalClient(client))
-        return FALSE;
+/* Is a local connection really forwarded from another host?  Needs the
+ * client's command line, so it is only asked at connection setup, by
+ * which time the lookup started on connect has usually finished. */
+Bool
+ClientIsForwarded(ClientPtr client)
+{
+    const char *cmdname = GetClientCmdName(client);
 
     /* If the executable name is "ssh", assume that this client connection
      * is forwarded from another host via SSH
@@ -1085,9 +1091,9 @@ ComputeLocalClient(ClientPtr client)
         char *tok = strtok(cmd, ":");
 
 #if !defined(WIN32)
-        ret = strcmp(basename(tok), "ssh") != 0;
+        ret = strcmp(basename(tok), "ssh") == 0;
 #else
-        ret = strcmp(tok, "ssh") != 0;
+        ret = strcmp(tok, "ssh") == 0;
 #endif
 
         free(cmd);
@@ -1095,7 +1101,7 @@ ComputeLocalClient(ClientPtr client)
         return ret;
     }
 
-    return TRUE;
+    return FALSE;
 }
 
 /*
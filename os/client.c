@@ -48,12 +48,20 @@
  * released after ClientStateCallback is called with ClientStateGone
  * state.
  *
+ * The PID comes from the connection's peer credentials when the client
+ * connects. The command line costs a file read or sysctl, so it is only
+ * looked up on demand. If the server has an input thread, a separate
+ * lookup thread also starts fetching it as soon as the client connects,
+ * so by the time someone asks (usually during connection setup, see
+ * ClientAuthorized) the answer is normally there already.
+ *
  * Author: Rami Ylimäki <rami.ylimaki@vincit.fi>
  */
 #include <dix-config.h>
 
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <signal.h>
 #include <unistd.h>
 
 #include "os/client_priv.h"
@@ -89,6 +97,42 @@
 #include "os/auth.h"
 #include "os/log_priv.h"
 
+#include "list.h"
+
+/* DetermineClientCmd() logs its errors on these OSes, which is only safe
+ * on the main thread, so they keep looking command lines up there */
+#if defined(CLIENTIDS) && INPUTTHREAD && !defined(__APPLE__) && \
+    !defined(__DragonFly__) && !defined(__FreeBSD__) && !defined(__sun)
+#include <pthread.h>
+#define CLIENT_CMD_THREAD 1
+#endif
+
+#ifdef CLIENTIDS
+enum ClientCmdState {
+    CLIENT_CMD_PENDING,         /* not looked up yet */
+    CLIENT_CMD_QUEUED,          /* waiting for the lookup thread */
+    CLIENT_CMD_RUNNING,         /* being looked up */
+    CLIENT_CMD_DONE,
+};
+
+/* what client->clientIds really points to */
+typedef struct _ClientIdLookup {
+    struct _ClientId ids;       /* must be first */
+    enum ClientCmdState state;
+    Bool orphaned;              /* client gone while the thread was busy */
+    struct xorg_list entry;     /* in cmd_queue while queued */
+} ClientIdLookupRec, *ClientIdLookupPtr;
+
+#ifdef CLIENT_CMD_THREAD
+static pthread_mutex_t cmd_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cmd_queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t cmd_done = PTHREAD_COND_INITIALIZER;
+static struct xorg_list cmd_queue = { &cmd_queue, &cmd_queue };
+static Bool cmd_thread_started;
+static Bool cmd_thread_failed;
+#endif
+#endif                          /* CLIENTIDS */
+
 /**
  * Try to determine a PID for a client from its connection
  * information. This should be called only once when new client has
@@ -442,8 +486,131 @@ DetermineClientCmd(pid_t pid, const char **cmdname, const char **cmdargs)
 #endif
 }
 
+#ifdef CLIENT_CMD_THREAD
+/**
+ * Looks up the command lines of newly connected clients, so the
+ * dispatch thread does not have to.
+ */
+static void *
+ClientCmdThread(void *arg)
+{
+    sigset_t set;
+
+    /* Don't handle any signals on this thread */
+    sigfillset(&set);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+#if defined(HAVE_PTHREAD_SETNAME_NP_WITH_TID)
+    pthread_setname_np (pthread_self(), "ClientIdThread");
+#elif defined(HAVE_PTHREAD_SETNAME_NP_WITHOUT_TID)
+    pthread_setname_np ("ClientIdThread");
+#endif
+
+    pthread_mutex_lock(&cmd_mutex);
+    for (;;) {
+        ClientIdLookupPtr lookup;
+        const char *cmdname, *cmdargs;
+
+        while (xorg_list_is_empty(&cmd_queue))
+            pthread_cond_wait(&cmd_queued, &cmd_mutex);
+
+        lookup = xorg_list_first_entry(&cmd_queue, ClientIdLookupRec, entry);
+        xorg_list_del(&lookup->entry);
+        lookup->state = CLIENT_CMD_RUNNING;
+        pthread_mutex_unlock(&cmd_mutex);
+
+        DetermineClientCmd(lookup->ids.pid, &cmdname, &cmdargs);
+
+        pthread_mutex_lock(&cmd_mutex);
+        if (lookup->orphaned) {
+            free((void *) cmdname);     /* const char * */
+            free((void *) cmdargs);     /* const char * */
+            free(lookup);
+            continue;
+        }
+        lookup->ids.cmdname = cmdname;
+        lookup->ids.cmdargs = cmdargs;
+        lookup->state = CLIENT_CMD_DONE;
+        pthread_cond_broadcast(&cmd_done);
+    }
+    return NULL;
+}
+
+/* hand a lookup to the thread, starting it first if needed */
+static void
+ClientCmdQueue(ClientIdLookupPtr lookup)
+{
+    pthread_mutex_lock(&cmd_mutex);
+    if (!cmd_thread_started && !cmd_thread_failed) {
+        pthread_t thread;
+        pthread_attr_t attr;
+
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        if (pthread_create(&thread, &attr, ClientCmdThread, NULL) == 0)
+            cmd_thread_started = TRUE;
+        else
+            cmd_thread_failed = TRUE;
+        pthread_attr_destroy(&attr);
+    }
+    if (cmd_thread_started) {
+        xorg_list_append(&lookup->entry, &cmd_queue);
+        lookup->state = CLIENT_CMD_QUEUED;
+        pthread_cond_signal(&cmd_queued);
+    }
+    pthread_mutex_unlock(&cmd_mutex);
+}
+#endif                          /* CLIENT_CMD_THREAD */
+
+#ifdef CLIENTIDS
+/**
+ * Make sure the command line of a client has been looked up, doing it
+ * right here unless the lookup thread is already busy with it.
+ */
+static void
+ClientCmdLookup(ClientIdLookupPtr lookup)
+{
+    const char *cmdname, *cmdargs;
+
+#ifdef CLIENT_CMD_THREAD
+    pthread_mutex_lock(&cmd_mutex);
+    while (lookup->state == CLIENT_CMD_RUNNING)
+        pthread_cond_wait(&cmd_done, &cmd_mutex);
+    if (lookup->state == CLIENT_CMD_DONE) {
+        pthread_mutex_unlock(&cmd_mutex);
+        return;
+    }
+    /* still queued, the thread has fallen behind */
+    xorg_list_del(&lookup->entry);
+    lookup->state = CLIENT_CMD_RUNNING;
+    pthread_mutex_unlock(&cmd_mutex);
+#else
+    if (lookup->state == CLIENT_CMD_DONE)
+        return;
+#endif
+
+    DetermineClientCmd(lookup->ids.pid, &cmdname, &cmdargs);
+
+#ifdef CLIENT_CMD_THREAD
+    pthread_mutex_lock(&cmd_mutex);
+#endif
+    lookup->ids.cmdname = cmdname;
+    lookup->ids.cmdargs = cmdargs;
+    lookup->state = CLIENT_CMD_DONE;
+#ifdef CLIENT_CMD_THREAD
+    pthread_mutex_unlock(&cmd_mutex);
+#endif
+
+    DebugF("client pid(%d): Looked up cmdname(%s) and cmdargs(%s).\n",
+           lookup->ids.pid, cmdname ? cmdname : "NULL",
+           cmdargs ? cmdargs : "NULL");
+}
+#endif                          /* CLIENTIDS */
+
 /**
  * Called when a new client connects. Allocates client ID information.
+ * The PID is determined right away, the command line later, see
+ * GetClientCmdName.
  *
  * @param[in] client Recently connected client.
  */
@@ -451,25 +618,28 @@ void
 ReserveClientIds(struct _Client *client)
 {
 #ifdef CLIENTIDS
+    ClientIdLookupPtr lookup;
+
     if (client == NULL)
         return;
 
     assert(!client->clientIds);
-    client->clientIds = calloc(1, sizeof(struct _ClientId));
-    if (!client->clientIds)
+    lookup = calloc(1, sizeof(ClientIdLookupRec));
+    if (!lookup)
         return;
-
-    client->clientIds->pid = DetermineClientPid(client);
-    if (client->clientIds->pid != -1)
-        DetermineClientCmd(client->clientIds->pid, &client->clientIds->cmdname,
-                           &client->clientIds->cmdargs);
+    xorg_list_init(&lookup->entry);
+    client->clientIds = &lookup->ids;
+
+    lookup->ids.pid = DetermineClientPid(client);
+    if (lookup->ids.pid == -1)
+        lookup->state = CLIENT_CMD_DONE;
+#ifdef CLIENT_CMD_THREAD
+    else if (client != serverClient)
+        ClientCmdQueue(lookup);
+#endif
 
     DebugF("client(%lx): Reserved pid(%d).\n",
            (unsigned long) client->clientAsMask, client->clientIds->pid);
-    DebugF("client(%lx): Reserved cmdname(%s) and cmdargs(%s).\n",
-           (unsigned long) client->clientAsMask,
-           client->clientIds->cmdname ? client->clientIds->cmdname : "NULL",
-           client->clientIds->cmdargs ? client->clientIds->cmdargs : "NULL");
 #endif                          /* CLIENTIDS */
 }
 
@@ -489,17 +659,27 @@ ReleaseClientIds(struct _Client *client)
     if (!client->clientIds)
         return;
 
-    DebugF("client(%lx): Released pid(%d).\n",
-           (unsigned long) client->clientAsMask, client->clientIds->pid);
-    DebugF("client(%lx): Released cmdline(%s) and cmdargs(%s).\n",
-           (unsigned long) client->clientAsMask,
-           client->clientIds->cmdname ? client->clientIds->cmdname : "NULL",
-           client->clientIds->cmdargs ? client->clientIds->cmdargs : "NULL");
-
-    free((void *) client->clientIds->cmdname);  /* const char * */
-    free((void *) client->clientIds->cmdargs);  /* const char * */
-    free(client->clientIds);
+    ClientIdLookupPtr lookup = (ClientIdLookupPtr) client->clientIds;
+
     client->clientIds = NULL;
+    DebugF("client(%lx): Released pid(%d).\n",
+           (unsigned long) client->clientAsMask, lookup->ids.pid);
+
+#ifdef CLIENT_CMD_THREAD
+    pthread_mutex_lock(&cmd_mutex);
+    if (lookup->state == CLIENT_CMD_RUNNING) {
+        /* the lookup thread frees it when done */
+        lookup->orphaned = TRUE;
+        pthread_mutex_unlock(&cmd_mutex);
+        return;
+    }
+    xorg_list_del(&lookup->entry);
+    pthread_mutex_unlock(&cmd_mutex);
+#endif
+
+    free((void *) lookup->ids.cmdname);  /* const char * */
+    free((void *) lookup->ids.cmdargs);  /* const char * */
+    free(lookup);
 #endif                          /* CLIENTIDS */
 }
 
@@ -528,10 +708,10 @@ GetClientPid(struct _Client *client)
 }
 
 /**
- * Get cached command name string of a client.
+ * Get cached command name string of a client. The command line is
+ * looked up on first use.
  *
- * param[in] client Client whose command line string has been already
- *                  cached.
+ * param[in] client Client whose command line string is wanted.
  *
  * @return Cached client command name. Error (NULL) if called:
  *         - before ClientStateInitial client state notification
@@ -550,14 +730,55 @@ GetClientCmdName(struct _Client *client)
     if (!client->clientIds)
         return NULL;
 
+#ifdef CLIENTIDS
+    ClientCmdLookup((ClientIdLookupPtr) client->clientIds);
+#endif
     return client->clientIds->cmdname;
 }
 
 /**
- * Get cached command arguments string of a client.
+ * Get the command name string of a client only if it has already been
+ * looked up. Unlike GetClientCmdName, this never reads it from the OS
+ * nor waits for the lookup thread.
+ *
+ * param[in] client Client whose command name string is wanted.
  *
- * param[in] client Client whose command line string has been already
- *                  cached.
+ * @return Cached client command name, or NULL if it isn't known yet or
+ *         can't be determined.
+ *
+ * @see GetClientCmdName
+ */
+const char *
+GetCachedClientCmdName(struct _Client *client)
+{
+    const char *cmdname = NULL;
+
+    if (client == NULL)
+        return NULL;
+
+    if (!client->clientIds)
+        return NULL;
+
+#ifdef CLIENTIDS
+    ClientIdLookupPtr lookup = (ClientIdLookupPtr) client->clientIds;
+
+#ifdef CLIENT_CMD_THREAD
+    pthread_mutex_lock(&cmd_mutex);
+#endif
+    if (lookup->state == CLIENT_CMD_DONE)
+        cmdname = lookup->ids.cmdname;
+#ifdef CLIENT_CMD_THREAD
+    pthread_mutex_unlock(&cmd_mutex);
+#endif
+#endif
+    return cmdname;
+}
+
+/**
+ * Get cached command arguments string of a client. The command line is
+ * looked up on first use.
+ *
+ * param[in] client Client whose command line string is wanted.
  *
  * @return Cached client command arguments. Error (NULL) if called:
  *         - before ClientStateInitial client state notification
@@ -576,5 +797,8 @@ GetClientCmdArgs(struct _Client *client)
     if (!client->clientIds)
         return NULL;
 
+#ifdef CLIENTIDS
+    ClientCmdLookup((ClientIdLookupPtr) client->clientIds);
+#endif
     return client->clientIds->cmdargs;
 }
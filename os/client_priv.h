@@ -34,6 +34,9 @@ pid_t GetClientPid(struct _Client *client);
 const char *GetClientCmdName(struct _Client *client);
 const char *GetClientCmdArgs(struct _Client *client);
 
+/* Command name if already looked up, NULL otherwise. Never blocks. */
+const char *GetCachedClientCmdName(struct _Client *client);
+
 Bool ClientIsLocal(struct _Client *client);
 XID AuthorizationIDOfClient(struct _Client *client);
 const char *ClientAuthorized(struct _Client *client,
@@ -45,6 +48,8 @@ Bool AddClientOnOpenFD(int fd);
 void ListenOnOpenFD(int fd, int noxauth);
 int ReadRequestFromClient(struct _Client *client);
 int WriteFdToClient(struct _Client *client, int fd, Bool do_close);
+void *ReserveClientOutput(struct _Client *client, int count);
+int CommitClientOutput(struct _Client *client, int count);
 Bool InsertFakeRequest(struct _Client *client, char *data, int count);
 void FlushAllOutput(void);
 void FlushIfCriticalOutputPending(void);
@@ -529,6 +529,11 @@ ClientAuthorized(ClientPtr client,
     priv = (OsCommPtr) client->osPrivate;
     trans_conn = priv->trans_conn;
 
+    /* Done here rather than on accept, so the command line lookup for the
+     * ssh check does not hold up the dispatch loop. */
+    if (client->local && ClientIsForwarded(client))
+        client->local = FALSE;
+
     /* Allow any client to connect without authorization on a launchd socket,
        because it is securely created -- this prevents a race condition on launch */
     if (trans_conn->flags & TRANS_NOXAUTH) {
@@ -93,6 +93,9 @@ typedef struct _connectionInput {
     int lenLastReq;
     int size;
     unsigned int ignoreBytes;   /* bytes to ignore before the next request */
+    CARD32 largeRequestTime;    /* when the buffer last held a large request */
+    struct xorg_list retained;  /* in RetainedInputs while kept drained */
+    OsCommPtr owner;            /* whose it is, while retained */
 } ConnectionInput;
 
 typedef struct _connectionOutput {
@@ -110,6 +113,9 @@ static int timesThisConnection = 0;
 static ConnectionInputPtr FreeInputs = (ConnectionInputPtr) NULL;
 static ConnectionOutputPtr FreeOutputs = (ConnectionOutputPtr) NULL;
 static OsCommPtr AvailableInput = (OsCommPtr) NULL;
+static struct xorg_list RetainedInputs = { &RetainedInputs, &RetainedInputs };
+static OsTimerPtr RetainTimer;
+static CARD32 RetainExpiry;     /* when RetainTimer fires, if it is set */
 
 #define get_req_len(req,cli) ((cli)->swapped ? \
 			      bswap_16((req)->length) : (req)->length)
@@ -123,6 +129,11 @@ static OsCommPtr AvailableInput = (OsCommPtr) NULL;
 #define BUFSIZE 16384
 #define BUFWATERMARK 32768
 
+/* Clients sending large requests back to back (e.g. PutImage video frames
+ * without MIT-SHM) keep their grown input buffer for this long after the
+ * last one, instead of freeing and reallocating it for every request. */
+#define LARGE_INPUT_RETAIN_MS 2000
+
 /*
  *   A lot of the code in this file manipulates a ConnectionInputPtr:
  *
@@ -201,27 +212,87 @@ YieldControlDeath(void)
     timesThisConnection = 0;
 }
 
+static Bool
+KeepLargeInputBuffer(ConnectionInputPtr oci)
+{
+    return (oci->size > BUFWATERMARK) &&
+        (GetTimeInMillis() - oci->largeRequestTime) < LARGE_INPUT_RETAIN_MS;
+}
+
+/* Free the retained buffers that have expired, and come back when the next
+ * one does. */
+static CARD32
+ExpireRetainedInputs(OsTimerPtr timer, CARD32 now, void *arg)
+{
+    ConnectionInputPtr oci, tmp;
+    CARD32 next = 0;
+
+    xorg_list_for_each_entry_safe(oci, tmp, &RetainedInputs, retained) {
+        CARD32 age = now - oci->largeRequestTime;
+
+        if (age < LARGE_INPUT_RETAIN_MS) {
+            if (!next || LARGE_INPUT_RETAIN_MS - age < next)
+                next = LARGE_INPUT_RETAIN_MS - age;
+            continue;
+        }
+        xorg_list_del(&oci->retained);
+        oci->owner->input = NULL;
+        free(oci->buffer);
+        free(oci);
+    }
+    RetainExpiry = now + next;
+    return next;
+}
+
+/* Leave a drained big buffer with its client until it expires. */
+static void
+RetainInputBuffer(OsCommPtr oc)
+{
+    ConnectionInputPtr oci = oc->input;
+    CARD32 expiry = oci->largeRequestTime + LARGE_INPUT_RETAIN_MS;
+    Bool first = xorg_list_is_empty(&RetainedInputs);
+
+    if (!xorg_list_is_empty(&oci->retained))
+        return;
+    oci->owner = oc;
+    xorg_list_append(&oci->retained, &RetainedInputs);
+    if (first || (int) (expiry - RetainExpiry) < 0) {
+        RetainExpiry = expiry;
+        RetainTimer = TimerSet(RetainTimer, TimerAbsolute, expiry,
+                               ExpireRetainedInputs, NULL);
+    }
+}
+
 /* If an input buffer was empty, either free it if it is too big or link it
  * into our list of free input buffers.  This means that different clients can
  * share the same input buffer (at different times).  This was done to save
- * memory.
+ * memory.  Big buffers that were recently needed stay with their client
+ * until ExpireRetainedInputs frees them.
  */
 static void
 NextAvailableInput(OsCommPtr oc)
 {
+    /* oc's own buffer is about to be used again */
+    if (oc->input)
+        xorg_list_del(&oc->input->retained);
+
     if (AvailableInput) {
         if (AvailableInput != oc) {
             ConnectionInputPtr aci = AvailableInput->input;
 
-            if (aci->size > BUFWATERMARK) {
-                free(aci->buffer);
-                free(aci);
-            }
+            if (KeepLargeInputBuffer(aci))
+                RetainInputBuffer(AvailableInput);
             else {
-                aci->next = FreeInputs;
-                FreeInputs = aci;
+                if (aci->size > BUFWATERMARK) {
+                    free(aci->buffer);
+                    free(aci);
+                }
+                else {
+                    aci->next = FreeInputs;
+                    FreeInputs = aci;
+                }
+                AvailableInput->input = NULL;
             }
-            AvailableInput->input = NULL;
         }
         AvailableInput = NULL;
     }
@@ -327,21 +398,25 @@ ReadRequestFromClient(ClientPtr client)
         if ((gotnow == 0) || ((oci->bufptr - oci->buffer + needed) > oci->size)) {
             /* no data, or the request is too big to fit in the buffer */
 
-            if ((gotnow > 0) && (oci->bufptr != oci->buffer))
-                /* save the data we've already read */
-                memmove(oci->buffer, oci->bufptr, gotnow);
             if (needed > oci->size) {
-                /* make buffer bigger to accommodate request */
+                /* make buffer bigger to accommodate request, carrying over
+                 * only the part of it that we've already read */
                 char *ibuf;
 
-                ibuf = (char *) realloc(oci->buffer, needed);
+                ibuf = (char *) malloc(needed);
                 if (!ibuf) {
                     YieldControlDeath();
                     return -1;
                 }
+                if (gotnow > 0)
+                    memcpy(ibuf, oci->bufptr, gotnow);
+                free(oci->buffer);
                 oci->size = needed;
                 oci->buffer = ibuf;
             }
+            else if ((gotnow > 0) && (oci->bufptr != oci->buffer))
+                /* save the data we've already read */
+                memmove(oci->buffer, oci->bufptr, gotnow);
             oci->bufptr = oci->buffer;
             oci->bufcnt = gotnow;
         }
@@ -372,7 +447,8 @@ ReadRequestFromClient(ClientPtr client)
         gotnow += result;
         /* free up some space after huge requests */
         if ((oci->size > BUFWATERMARK) &&
-            (oci->bufcnt < BUFSIZE) && (needed < BUFSIZE)) {
+            (oci->bufcnt < BUFSIZE) && (needed < BUFSIZE) &&
+            !KeepLargeInputBuffer(oci)) {
             char *ibuf;
 
             ibuf = (char *) realloc(oci->buffer, BUFSIZE);
@@ -433,6 +509,8 @@ ReadRequestFromClient(ClientPtr client)
     }
 
     oci->lenLastReq = needed;
+    if (needed > BUFWATERMARK)
+        oci->largeRequestTime = GetTimeInMillis();
 
     /*
      *  Check to see if client has at least one whole request in the
@@ -757,6 +835,39 @@ OutputBufferMakeRoomAndFlush(ClientPtr who, OsCommPtr oc, const void* extra_buf,
     return memcpy_and_flush(who, oc, extra_buf, extra_size, padsize);
 }
 
+/*
+ * Tell the ReplyCallback (e.g. RECORD) about count bytes of reply data at
+ * buf, which are about to be queued for the client.
+ */
+static void
+CallReplyCallback(ClientPtr who, const char *buf, int count, int padBytes)
+{
+    ReplyInfoRec replyinfo;
+
+    replyinfo.client = who;
+    replyinfo.replyData = buf;
+    replyinfo.dataLenBytes = count + padBytes;
+    replyinfo.padBytes = padBytes;
+    if (who->replyBytesRemaining) { /* still sending data of an earlier reply */
+        who->replyBytesRemaining -= count + padBytes;
+        replyinfo.startOfReply = FALSE;
+        replyinfo.bytesRemaining = who->replyBytesRemaining;
+        CallCallbacks((&ReplyCallback), (void *) &replyinfo);
+    }
+    else if (who->clientState == ClientStateRunning && buf[0] == X_Reply) { /* start of new reply */
+        CARD32 replylen;
+        unsigned long bytesleft;
+
+        replylen = ((const xGenericReply *) buf)->length;
+        if (who->swapped)
+            swapl(&replylen);
+        bytesleft = (replylen * 4) + SIZEOF(xReply) - count - padBytes;
+        replyinfo.startOfReply = TRUE;
+        replyinfo.bytesRemaining = who->replyBytesRemaining = bytesleft;
+        CallCallbacks((&ReplyCallback), (void *) &replyinfo);
+    }
+}
+
 /*****************
  * WriteToClient
  *    Copies buf into ClientPtr.buf if it fits (with padding), else
@@ -827,32 +938,8 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
 
     padBytes = padding_for_int32(count);
 
-    if (ReplyCallback) {
-        ReplyInfoRec replyinfo;
-
-        replyinfo.client = who;
-        replyinfo.replyData = buf;
-        replyinfo.dataLenBytes = count + padBytes;
-        replyinfo.padBytes = padBytes;
-        if (who->replyBytesRemaining) { /* still sending data of an earlier reply */
-            who->replyBytesRemaining -= count + padBytes;
-            replyinfo.startOfReply = FALSE;
-            replyinfo.bytesRemaining = who->replyBytesRemaining;
-            CallCallbacks((&ReplyCallback), (void *) &replyinfo);
-        }
-        else if (who->clientState == ClientStateRunning && buf[0] == X_Reply) { /* start of new reply */
-            CARD32 replylen;
-            unsigned long bytesleft;
-
-            replylen = ((const xGenericReply *) buf)->length;
-            if (who->swapped)
-                swapl(&replylen);
-            bytesleft = (replylen * 4) + SIZEOF(xReply) - count - padBytes;
-            replyinfo.startOfReply = TRUE;
-            replyinfo.bytesRemaining = who->replyBytesRemaining = bytesleft;
-            CallCallbacks((&ReplyCallback), (void *) &replyinfo);
-        }
-    }
+    if (ReplyCallback)
+        CallReplyCallback(who, buf, count, padBytes);
 #ifdef DEBUG_COMMUNICATION
     else if (multicount) {
         if (who->replyBytesRemaining) {
@@ -893,6 +980,95 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
     return count;
 }
 
+/*****************
+ * ReserveClientOutput / CommitClientOutput
+ *    Let a request handler produce bulk reply data (e.g. GetImage) directly
+ *    in the client's output buffer, instead of filling a scratch buffer and
+ *    having WriteToClient copy it.  ReserveClientOutput returns room for
+ *    count bytes plus padding, valid until the next call into the output
+ *    layer; CommitClientOutput then queues exactly those count bytes.
+ *    Returns NULL if the client is gone or can't get the memory, in which
+ *    case the client has been aborted, just like with WriteToClient.
+ *****************/
+
+void *
+ReserveClientOutput(ClientPtr who, int count)
+{
+    OsCommPtr oc;
+
+    BUG_RETURN_VAL_MSG(in_input_thread(), NULL,
+                       "******** %s called from input thread *********\n", __func__);
+
+    if (count <= 0 || !who || who == serverClient || who->clientGone)
+        return NULL;
+    oc = who->osPrivate;
+
+    const size_t needed = count + padding_for_int32(count);
+
+    if (oc->output && oc->output->count + needed > oc->output->size) {
+        if (FlushClient(who, oc) == -1)
+            return NULL;
+    }
+
+    if (!OutputEnsureBuffer(who, oc))
+        return NULL;
+
+    ConnectionOutputPtr oco = oc->output;
+
+    if (oco->count + needed > oco->size) {
+        const int newsize = oco->count + (((needed / BUFSIZE)+1)*BUFSIZE);
+        void *newbuf = realloc(oco->buf, newsize);
+
+        if (!newbuf) {
+            AbortClient(who);
+            dixMarkClientException(who);
+            oco->count = 0;
+            return NULL;
+        }
+        oco->buf = newbuf;
+        oco->size = newsize;
+    }
+
+    return oco->buf + oco->count;
+}
+
+int
+CommitClientOutput(ClientPtr who, int count)
+{
+    OsCommPtr oc = who->osPrivate;
+    ConnectionOutputPtr oco = oc->output;
+    const int padBytes = padding_for_int32(count);
+
+    if (who->clientGone || !oco)
+        return -1;
+
+    if (ReplyCallback)
+        CallReplyCallback(who, (const char *) oco->buf + oco->count,
+                          count, padBytes);
+
+    Bool flush = (oco->count == 0 && who->local);
+
+    oco->count += count;
+    if (padBytes) {
+        memset(oco->buf + oco->count, '\0', padBytes);
+        oco->count += padBytes;
+    }
+
+    /* bulk data goes out right away, no point in holding it */
+    if (flush || oco->count >= BUFSIZE) {
+        output_pending_clear(who);
+        if (!any_output_pending()) {
+            CriticalOutputPending = FALSE;
+            NewOutputPending = FALSE;
+        }
+        return (FlushClient(who, oc) == -1) ? -1 : count;
+    }
+
+    NewOutputPending = TRUE;
+    output_pending_mark(who);
+    return count;
+}
+
  /********************
  * FlushClient()
  *    If the client isn't keeping up with us, then we try to continue
@@ -1009,6 +1185,7 @@ AllocateInputBuffer(void)
     oci->bufcnt = 0;
     oci->lenLastReq = 0;
     oci->ignoreBytes = 0;
+    xorg_list_init(&oci->retained);
     return oci;
 }
 
@@ -1037,7 +1214,8 @@ FreeOsBuffers(OsCommPtr oc)
     if (AvailableInput == oc)
         AvailableInput = (OsCommPtr) NULL;
     if ((oci = oc->input)) {
-        if (FreeInputs) {
+        xorg_list_del(&oci->retained);
+        if (FreeInputs || oci->size > BUFWATERMARK) {
             free(oci->buffer);
             free(oci);
         }
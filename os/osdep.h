@@ -115,6 +115,7 @@ extern Bool NewOutputPending;
 
 /* in access.c */
 extern Bool ComputeLocalClient(ClientPtr client);
+extern Bool ClientIsForwarded(ClientPtr client);
 
 /* OsTimer functions */
 void TimerInit(void);
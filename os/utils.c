@@ -92,6 +92,7 @@ OR PERFORMANCE OF THIS SOFTWARE.
 
 #include "dix/dix_priv.h"
 #include "dix/input_priv.h"
+#include "dix/snapshot_priv.h"
 #include "miext/extinit_priv.h"
 #include "os/audit.h"
 #include "os/auth.h"
@@ -278,6 +279,8 @@ UseMsg(void)
     ErrorF("-cc int                default color visual class\n");
     ErrorF("-nocursor              disable the cursor\n");
     ErrorF("-core                  generate core dump on fatal error\n");
+    ErrorF("-damagebatch ms        batch DAMAGE rectangle events, at most one batch per ms\n");
+    ErrorF("-debugsocket path      serve server state snapshots on a local socket\n");
     ErrorF("-displayfd fd          file descriptor to write display number to when ready to connect\n");
     ErrorF("-dpi int               screen resolution in dots per inch\n");
 #ifdef DPMSExtension
@@ -510,6 +513,24 @@ ProcessCommandLine(int argc, char *argv[])
             else
                 UseMsg();
         }
+        else if (strcmp(argv[i], "-damagebatch") == 0) {
+            if (++i < argc && atoi(argv[i]) >= 0)
+                damageBatchInterval = atoi(argv[i]);
+            else
+                UseMsg();
+        }
+        else if (strcmp(argv[i], "-debugsocket") == 0) {
+            if (++i < argc) {
+                /* binds and chmods a path of the user's choice, and tells
+                 * about every client */
+                if (PrivsElevated())
+                    FatalError("\nInvalid argument -debugsocket "
+                               "with elevated privileges\n");
+                debugSocketPath = argv[i];
+            }
+            else
+                UseMsg();
+        }
         else if (strcmp(argv[i], "-displayfd") == 0) {
             if (++i < argc) {
                 displayfd = atoi(argv[i]);
@@ -23,14 +23,23 @@
 
 #include "present_priv.h"
 #include "list.h"
+#include "misync.h"
 
-static struct xorg_list fake_vblank_queue;
+static struct xorg_list fake_frame_queue;
 
-typedef struct present_fake_vblank {
+/* the vblank events of a screen that are due at the same msc, which share
+ * one timer */
+typedef struct present_fake_frame {
     struct xorg_list            list;
-    uint64_t                    event_id;
+    struct xorg_list            vblanks;
+    uint64_t                    msc;
     OsTimerPtr                  timer;
     ScreenPtr                   screen;
+} present_fake_frame_rec, *present_fake_frame_ptr;
+
+typedef struct present_fake_vblank {
+    struct xorg_list            list;
+    uint64_t                    event_id;
 } present_fake_vblank_rec, *present_fake_vblank_ptr;
 
 int
@@ -52,31 +61,50 @@ present_fake_notify(ScreenPtr screen, uint64_t event_id)
     present_event_notify(event_id, ust, msc);
 }
 
+/*
+ * Notify all of the frame's events in one go, and have the fences they
+ * trigger wake up their waiters together once all are done.  Events queued
+ * meanwhile start a new frame, as this one is off the queue already.
+ */
 static CARD32
 present_fake_do_timer(OsTimerPtr timer,
                       CARD32 time,
                       void *arg)
 {
-    present_fake_vblank_ptr     fake_vblank = arg;
+    present_fake_frame_ptr      fake_frame = arg;
+    present_fake_vblank_ptr     fake_vblank, tmp;
 
-    present_fake_notify(fake_vblank->screen, fake_vblank->event_id);
-    xorg_list_del(&fake_vblank->list);
-    TimerFree(fake_vblank->timer);
-    free(fake_vblank);
+    xorg_list_del(&fake_frame->list);
+    miSyncBeginFenceBatch();
+    xorg_list_for_each_entry_safe(fake_vblank, tmp, &fake_frame->vblanks, list) {
+        xorg_list_del(&fake_vblank->list);
+        present_fake_notify(fake_frame->screen, fake_vblank->event_id);
+        free(fake_vblank);
+    }
+    miSyncEndFenceBatch();
+    TimerFree(fake_frame->timer);
+    free(fake_frame);
     return 0;
 }
 
 void
 present_fake_abort_vblank(ScreenPtr screen, uint64_t event_id, uint64_t msc)
 {
-    present_fake_vblank_ptr     fake_vblank, tmp;
+    present_fake_frame_ptr      fake_frame;
+    present_fake_vblank_ptr     fake_vblank;
 
-    xorg_list_for_each_entry_safe(fake_vblank, tmp, &fake_vblank_queue, list) {
-        if (fake_vblank->event_id == event_id) {
-            TimerFree(fake_vblank->timer); /* TimerFree will call TimerCancel() */
-            xorg_list_del(&fake_vblank->list);
-            free (fake_vblank);
-            break;
+    xorg_list_for_each_entry(fake_frame, &fake_frame_queue, list) {
+        xorg_list_for_each_entry(fake_vblank, &fake_frame->vblanks, list) {
+            if (fake_vblank->event_id == event_id) {
+                xorg_list_del(&fake_vblank->list);
+                free(fake_vblank);
+                if (xorg_list_is_empty(&fake_frame->vblanks)) {
+                    TimerFree(fake_frame->timer); /* TimerFree will call TimerCancel() */
+                    xorg_list_del(&fake_frame->list);
+                    free(fake_frame);
+                }
+                return;
+            }
         }
     }
 }
@@ -90,6 +118,7 @@ present_fake_queue_vblank(ScreenPtr     screen,
     uint64_t                    ust = msc * screen_priv->fake_interval;
     uint64_t                    now = GetTimeInMicros();
     INT32                       delay = ((int64_t) (ust - now)) / 1000;
+    present_fake_frame_ptr      fake_frame;
     present_fake_vblank_ptr     fake_vblank;
 
     if (delay <= 0) {
@@ -100,16 +129,33 @@ present_fake_queue_vblank(ScreenPtr     screen,
     fake_vblank = calloc (1, sizeof (present_fake_vblank_rec));
     if (!fake_vblank)
         return BadAlloc;
-
-    fake_vblank->screen = screen;
     fake_vblank->event_id = event_id;
-    fake_vblank->timer = TimerSet(NULL, 0, delay, present_fake_do_timer, fake_vblank);
-    if (!fake_vblank->timer) {
+
+    xorg_list_for_each_entry(fake_frame, &fake_frame_queue, list) {
+        if (fake_frame->screen == screen && fake_frame->msc == msc) {
+            xorg_list_append(&fake_vblank->list, &fake_frame->vblanks);
+            return Success;
+        }
+    }
+
+    fake_frame = calloc (1, sizeof (present_fake_frame_rec));
+    if (!fake_frame) {
+        free(fake_vblank);
+        return BadAlloc;
+    }
+
+    fake_frame->screen = screen;
+    fake_frame->msc = msc;
+    xorg_list_init(&fake_frame->vblanks);
+    fake_frame->timer = TimerSet(NULL, 0, delay, present_fake_do_timer, fake_frame);
+    if (!fake_frame->timer) {
+        free(fake_frame);
         free(fake_vblank);
         return BadAlloc;
     }
 
-    xorg_list_add(&fake_vblank->list, &fake_vblank_queue);
+    xorg_list_append(&fake_vblank->list, &fake_frame->vblanks);
+    xorg_list_add(&fake_frame->list, &fake_frame_queue);
 
     return Success;
 }
@@ -142,5 +188,5 @@ present_fake_screen_init(ScreenPtr screen)
 void
 present_fake_queue_init(void)
 {
-    xorg_list_init(&fake_vblank_queue);
+    xorg_list_init(&fake_frame_queue);
 }
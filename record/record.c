@@ -174,6 +174,36 @@ static DevPrivateKeyRec RecordClientPrivateKeyRec;
  */
 #define RecordClientPrivate(_pClient) (RecordClientPrivatePtr) \
     dixLookupPrivate(&(_pClient)->devPrivates, RecordClientPrivateKey)
+
+/* Record interest summary.  Every client has one of these.  It is the
+ * union, over all enabled contexts that this client is registered on, of
+ * the reply major opcodes, delivered event types and error codes being
+ * recorded.  It lets RecordAReply and RecordADeliveredEventOrError reject
+ * traffic nobody records with a single bit test instead of searching
+ * every enabled context's client lists.  A set bit only means "maybe";
+ * the slow path still makes the real decision (minor opcodes, which
+ * context, etc.).
+ *
+ * The summary is rebuilt lazily: whenever the set of enabled RCAPs or
+ * their clients changes, recordInterestSerial is bumped, and a client
+ * whose summary carries an older serial recomputes it on next use.
+ */
+typedef struct {
+    unsigned int serial;        /* recordInterestSerial at last compute */
+    Bool events;                /* any eventTypes or errorCodes bit set */
+    unsigned char replyMajors[256 / 8];
+    unsigned char eventTypes[128 / 8];
+    unsigned char errorCodes[256 / 8];
+} RecordClientInterestRec, *RecordClientInterestPtr;
+
+static DevPrivateKeyRec RecordClientInterestKeyRec;
+
+#define RecordClientInterestKey (&RecordClientInterestKeyRec)
+
+/* starts at 1 so that zeroed per-client storage is always stale */
+static unsigned int recordInterestSerial = 1;
+
+#define RecordInterestBit(_bits, _n) ((_bits)[(_n) >> 3] & (1 << ((_n) & 7)))
 
 /***************************************************************************/
 
@@ -435,6 +465,79 @@ RecordFindClientOnContext(RecordContextPtr pContext,
     return NULL;
 }                               /* RecordFindClientOnContext */
 
+/* RecordAddSetToInterest
+ *
+ * Arguments:
+ *	pSet is a set of protocol numbers.
+ *	bits is a bit array with room for nbits members.
+ *
+ * Returns: nothing.
+ *
+ * Side Effects:
+ *	The bit of every member of pSet below nbits is set in bits.
+ */
+static void
+RecordAddSetToInterest(RecordSetPtr pSet, unsigned char *bits, int nbits)
+{
+    RecordSetIteratePtr pIter = NULL;
+    RecordSetInterval interval;
+
+    while ((pIter = RecordIterateSet(pSet, pIter, &interval))) {
+        unsigned int j;
+
+        for (j = interval.first; j <= interval.last && j < nbits; j++)
+            bits[j >> 3] |= 1 << (j & 7);
+    }
+}                               /* RecordAddSetToInterest */
+
+/* RecordClientInterest
+ *
+ * Arguments:
+ *	pClient is the client whose interest summary is wanted.
+ *
+ * Returns:
+ *	The client's RecordClientInterestRec, recomputed from the enabled
+ *	contexts first if it is out of date.
+ */
+static RecordClientInterestPtr
+RecordClientInterest(ClientPtr pClient)
+{
+    RecordClientInterestPtr pInterest =
+        dixLookupPrivate(&pClient->devPrivates, RecordClientInterestKey);
+    int eci;
+
+    if (pInterest->serial == recordInterestSerial)
+        return pInterest;
+
+    memset(pInterest, 0, sizeof(*pInterest));
+    for (eci = 0; eci < numEnabledContexts; eci++) {
+        RecordClientsAndProtocolPtr pRCAP =
+            RecordFindClientOnContext(ppAllContexts[eci],
+                                      pClient->clientAsMask, NULL);
+
+        if (!pRCAP)
+            continue;
+        if (pRCAP->pReplyMajorOpSet)
+            RecordAddSetToInterest(pRCAP->pReplyMajorOpSet,
+                                   pInterest->replyMajors, 256);
+        /* RecordADeliveredEventOrError only looks at the event set
+         * when no error set is present
+         */
+        if (pRCAP->pErrorSet) {
+            RecordAddSetToInterest(pRCAP->pErrorSet,
+                                   pInterest->errorCodes, 256);
+            pInterest->events = TRUE;
+        }
+        else if (pRCAP->pDeliveredEventSet) {
+            RecordAddSetToInterest(pRCAP->pDeliveredEventSet,
+                                   pInterest->eventTypes, 128);
+            pInterest->events = TRUE;
+        }
+    }
+    pInterest->serial = recordInterestSerial;
+    return pInterest;
+}                               /* RecordClientInterest */
+
 /* RecordABigRequest
  *
  * Arguments:
@@ -586,6 +689,16 @@ RecordAReply(CallbackListPtr *pcbl, void *nulldata, void *calldata)
     ReplyInfoRec *pri = (ReplyInfoRec *) calldata;
     ClientPtr client = pri->client;
 
+    /* continuation chunks always take the slow path; they are only seen
+     * for large replies and depend on per-context continuedReply state
+     */
+    if (pri->startOfReply) {
+        RecordClientInterestPtr pInterest = RecordClientInterest(client);
+
+        if (!RecordInterestBit(pInterest->replyMajors, client->majorOp))
+            return;
+    }
+
     for (eci = 0; eci < numEnabledContexts; eci++) {
         pContext = ppAllContexts[eci];
         pRCAP = RecordFindClientOnContext(pContext, client->clientAsMask, NULL);
@@ -665,6 +778,21 @@ RecordADeliveredEventOrError(CallbackListPtr *pcbl, void *nulldata,
     RecordClientsAndProtocolPtr pRCAP;
     int eci;                    /* enabled context index */
     ClientPtr pClient = pei->client;
+    RecordClientInterestPtr pInterest = RecordClientInterest(pClient);
+    int i;
+
+    if (!pInterest->events)
+        return;
+    for (i = 0; i < pei->count; i++) {
+        xEvent *pev = &pei->events[i];
+
+        if (RecordInterestBit(pInterest->eventTypes, pev->u.u.type & 0177) ||
+            RecordInterestBit(pInterest->errorCodes,
+                              ((xError *) pev)->errorCode))
+            break;
+    }
+    if (i == pei->count)       /* nobody records any of these */
+        return;
 
     for (eci = 0; eci < numEnabledContexts; eci++) {
         pContext = ppAllContexts[eci];
@@ -861,6 +989,8 @@ RecordInstallHooks(RecordClientsAndProtocolPtr pRCAP, XID oneclient)
     else
         client = pRCAP->numClients ? pRCAP->pClientIDs[i++] : 0;
 
+    recordInterestSerial++;
+
     while (client) {
         if (client != XRecordFutureClients) {
             if (pRCAP->pRequestMajorOpSet) {
@@ -946,6 +1076,8 @@ RecordUninstallHooks(RecordClientsAndProtocolPtr pRCAP, XID oneclient)
     else
         client = pRCAP->numClients ? pRCAP->pClientIDs[i++] : 0;
 
+    recordInterestSerial++;
+
     while (client) {
         if (client != XRecordFutureClients) {
             if (pRCAP->pRequestMajorOpSet) {
@@ -2331,6 +2463,7 @@ ProcRecordEnableContext(ClientPtr client)
 
     ++numEnabledContexts;
     assert(numEnabledContexts > 0);
+    recordInterestSerial++;
 
     /* send StartOfData */
     RecordAProtocolElement(pContext, NULL, XRecordStartOfData, NULL, 0, 0, 0);
@@ -2387,6 +2520,7 @@ RecordDisableContext(RecordContextPtr pContext)
     }
     --numEnabledContexts;
     assert(numEnabledContexts >= 0);
+    recordInterestSerial++;
 }                               /* RecordDisableContext */
 
 static int
@@ -2788,6 +2922,9 @@ RecordExtensionInit(void)
 
     if (!dixRegisterPrivateKey(RecordClientPrivateKey, PRIVATE_CLIENT, 0))
         return;
+    if (!dixRegisterPrivateKey(RecordClientInterestKey, PRIVATE_CLIENT,
+                               sizeof(RecordClientInterestRec)))
+        return;
 
     ppAllContexts = NULL;
     numContexts = numEnabledContexts = numEnabledRCAPs = 0;
@@ -58,7 +58,6 @@ typedef struct _AnimCurElt {
 typedef struct _AnimCur {
     int nelt;                   /* number of elements in the elts array */
     AnimCurElt *elts;           /* actually allocated right after the structure */
-    OsTimerPtr timer;
 } AnimCurRec, *AnimCurPtr;
 
 typedef struct _AnimScrPriv {
@@ -68,6 +67,10 @@ typedef struct _AnimScrPriv {
     RealizeCursorProcPtr RealizeCursor;
     UnrealizeCursorProcPtr UnrealizeCursor;
     RecolorCursorProcPtr RecolorCursor;
+    OsTimerPtr timer;           /* frame clock shared by all devices on the screen */
+    CARD32 wakeups;             /* times the frame clock fired */
+    CARD32 frames;              /* frames shown */
+    CARD32 skipped;             /* frame changes that didn't change the image */
 } AnimCurScreenRec, *AnimCurScreenPtr;
 
 static unsigned char empty[4];
@@ -82,6 +85,13 @@ static DevPrivateKeyRec AnimCurScreenPrivateKeyRec;
 #define GetAnimCur(c)	    ((AnimCurPtr) ((((char *)(c) + CURSOR_REC_SIZE))))
 #define GetAnimCurScreen(s) ((AnimCurScreenPtr)dixLookupPrivate(&(s)->devPrivates, &AnimCurScreenPrivateKeyRec))
 
+/*
+ * Devices whose next frame is due within this many ms are advanced on the
+ * same wakeup, so several pointers animating on one screen don't each get
+ * their own timer expiry.
+ */
+#define ANIMCUR_SLACK_MS    4
+
 #define Wrap(as,s,elt,func) (((as)->elt = (s)->elt), (s)->elt = func)
 #define Unwrap(as,s,elt)    ((s)->elt = (as)->elt)
 
@@ -91,6 +101,14 @@ static void AnimCurScreenClose(CallbackListPtr *pcbl, ScreenPtr pScreen, void *u
 
     dixScreenUnhookClose(pScreen, AnimCurScreenClose);
 
+    if (as->wakeups)
+        LogMessageVerb(X_INFO, 5, "animcur: screen %d: %u wakeups, "
+                       "%u frames shown, %u unchanged frames skipped\n",
+                       pScreen->myNum, (unsigned) as->wakeups,
+                       (unsigned) as->frames, (unsigned) as->skipped);
+    TimerFree(as->timer);
+    as->timer = NULL;
+
     Unwrap(as, pScreen, CursorLimits);
     Unwrap(as, pScreen, DisplayCursor);
     Unwrap(as, pScreen, SetCursorPosition);
@@ -119,45 +137,108 @@ AnimCurCursorLimits(DeviceIntPtr pDev,
     Wrap(as, pScreen, CursorLimits, AnimCurCursorLimits);
 }
 
+static AnimCurPtr
+AnimCurDeviceAnimation(DeviceIntPtr dev, ScreenPtr pScreen)
+{
+    CursorPtr cur;
+
+    if (!IsPointerDevice(dev) || dev->spriteInfo->anim.pScreen != pScreen ||
+        !dev->spriteInfo->anim.pCursor || !dev->spriteInfo->sprite)
+        return NULL;
+
+    cur = dev->spriteInfo->sprite->current;
+    return IsAnimCur(cur) ? GetAnimCur(cur) : NULL;
+}
+
 /*
- * The cursor animation timer has expired, go display any relevant cursor changes
- * and compute a new timeout value
+ * Time until the earliest pending frame of any device animating on
+ * pScreen, 0 if there is none.
+ */
+static CARD32
+AnimCurNextFrame(ScreenPtr pScreen, CARD32 now)
+{
+    DeviceIntPtr dev;
+    CARD32 soonest = 0;
+
+    for (dev = inputInfo.devices; dev; dev = dev->next) {
+        AnimCurPtr ac = AnimCurDeviceAnimation(dev, pScreen);
+        INT32 wait;
+
+        if (!ac || !ac->elts[dev->spriteInfo->anim.elt].delay)
+            continue;
+
+        wait = (INT32) (dev->spriteInfo->anim.time - now);
+        if (wait < 1)
+            wait = 1;
+        if (!soonest || (CARD32) wait < soonest)
+            soonest = wait;
+    }
+    return soonest;
+}
+
+/*
+ * The screen's frame clock has expired, go display any relevant cursor
+ * changes and compute a new timeout value
  */
 
 static CARD32
 AnimCurTimerNotify(OsTimerPtr timer, CARD32 now, void *arg)
 {
-    DeviceIntPtr dev = arg;
-    ScreenPtr pScreen = dev->spriteInfo->anim.pScreen;
+    ScreenPtr pScreen = arg;
     AnimCurScreenPtr as = GetAnimCurScreen(pScreen);
+    DeviceIntPtr dev;
+
+    as->wakeups++;
+
+    for (dev = inputInfo.devices; dev; dev = dev->next) {
+        AnimCurPtr ac = AnimCurDeviceAnimation(dev, pScreen);
+
+        if (!ac || !ac->elts[dev->spriteInfo->anim.elt].delay)
+            continue;
+        if ((INT32) (dev->spriteInfo->anim.time - now) > ANIMCUR_SLACK_MS)
+            continue;
+
+        int elt = (dev->spriteInfo->anim.elt + 1) % ac->nelt;
+        CursorPtr pCursor = ac->elts[elt].pCursor;
+
+        /* consecutive elements often repeat an image to hold it longer */
+        if (pCursor != dev->spriteInfo->anim.pCursor) {
+            DisplayCursorProcPtr DisplayCursor = pScreen->DisplayCursor;
+
+            /*
+             * Not a simple Unwrap/Wrap as this isn't called along the
+             * DisplayCursor wrapper chain.
+             */
+            pScreen->DisplayCursor = as->DisplayCursor;
+            (void) (*pScreen->DisplayCursor) (dev, pScreen, pCursor);
+            as->DisplayCursor = pScreen->DisplayCursor;
+            pScreen->DisplayCursor = DisplayCursor;
+            as->frames++;
+        }
+        else
+            as->skipped++;
 
-    AnimCurPtr ac = GetAnimCur(dev->spriteInfo->sprite->current);
-    int elt = (dev->spriteInfo->anim.elt + 1) % ac->nelt;
-    DisplayCursorProcPtr DisplayCursor = pScreen->DisplayCursor;
-
-    /*
-     * Not a simple Unwrap/Wrap as this isn't called along the DisplayCursor
-     * wrapper chain.
-     */
-    pScreen->DisplayCursor = as->DisplayCursor;
-    (void) (*pScreen->DisplayCursor) (dev, pScreen, ac->elts[elt].pCursor);
-    as->DisplayCursor = pScreen->DisplayCursor;
-    pScreen->DisplayCursor = DisplayCursor;
-
-    dev->spriteInfo->anim.elt = elt;
-    dev->spriteInfo->anim.pCursor = ac->elts[elt].pCursor;
+        dev->spriteInfo->anim.elt = elt;
+        dev->spriteInfo->anim.pCursor = pCursor;
+        dev->spriteInfo->anim.time = now + ac->elts[elt].delay;
+    }
 
-    return ac->elts[elt].delay;
+    return AnimCurNextFrame(pScreen, now);
 }
 
+/*
+ * (Re)arm the frame clock of pScreen for the earliest pending frame.
+ */
 static void
-AnimCurCancelTimer(DeviceIntPtr pDev)
+AnimCurScheduleScreen(ScreenPtr pScreen)
 {
-    CursorPtr cur = pDev->spriteInfo->sprite ?
-                    pDev->spriteInfo->sprite->current : NULL;
+    AnimCurScreenPtr as = GetAnimCurScreen(pScreen);
+    CARD32 wait = AnimCurNextFrame(pScreen, GetTimeInMillis());
 
-    if (IsAnimCur(cur))
-        TimerCancel(GetAnimCur(cur)->timer);
+    if (wait)
+        as->timer = TimerSet(as->timer, 0, wait, AnimCurTimerNotify, pScreen);
+    else
+        TimerCancel(as->timer);
 }
 
 static Bool
@@ -174,7 +255,6 @@ AnimCurDisplayCursor(DeviceIntPtr pDev, ScreenPtr pScreen, CursorPtr pCursor)
         if (pCursor != pDev->spriteInfo->sprite->current) {
             AnimCurPtr ac = GetAnimCur(pCursor);
 
-            AnimCurCancelTimer(pDev);
             ret = (*pScreen->DisplayCursor) (pDev, pScreen,
                                              ac->elts[0].pCursor);
 
@@ -182,14 +262,15 @@ AnimCurDisplayCursor(DeviceIntPtr pDev, ScreenPtr pScreen, CursorPtr pCursor)
                 pDev->spriteInfo->anim.elt = 0;
                 pDev->spriteInfo->anim.pCursor = pCursor;
                 pDev->spriteInfo->anim.pScreen = pScreen;
+                pDev->spriteInfo->anim.time =
+                    GetTimeInMillis() + ac->elts[0].delay;
 
-                ac->timer = TimerSet(ac->timer, 0, ac->elts[0].delay,
-                                     AnimCurTimerNotify, pDev);
+                AnimCurScheduleScreen(pScreen);
             }
         }
     }
     else {
-        AnimCurCancelTimer(pDev);
+        /* the frame clock notices by itself that this device stopped */
         pDev->spriteInfo->anim.pCursor = 0;
         pDev->spriteInfo->anim.pScreen = 0;
         ret = (*pScreen->DisplayCursor) (pDev, pScreen, pCursor);
@@ -206,8 +287,10 @@ AnimCurSetCursorPosition(DeviceIntPtr pDev,
     Bool ret;
 
     Unwrap(as, pScreen, SetCursorPosition);
-    if (pDev->spriteInfo->anim.pCursor) {
+    if (pDev->spriteInfo->anim.pCursor &&
+        pDev->spriteInfo->anim.pScreen != pScreen) {
         pDev->spriteInfo->anim.pScreen = pScreen;
+        AnimCurScheduleScreen(pScreen);
     }
     ret = (*pScreen->SetCursorPosition) (pDev, pScreen, x, y, generateEvent);
     Wrap(as, pScreen, SetCursorPosition, AnimCurSetCursorPosition);
@@ -302,7 +385,7 @@ AnimCursorCreate(CursorPtr *cursors, CARD32 *deltas, int ncursor,
         return BadValue;
 
     CursorPtr pCursor;
-    int rc = BadAlloc, i;
+    int rc, i;
     AnimCurPtr ac;
 
     for (i = 0; i < screenInfo.numScreens; i++) {
@@ -335,15 +418,12 @@ AnimCursorCreate(CursorPtr *cursors, CARD32 *deltas, int ncursor,
     pCursor->id = cid;
 
     ac = GetAnimCur(pCursor);
-    ac->timer = TimerSet(NULL, 0, 0, AnimCurTimerNotify, NULL);
 
     /* security creation/labeling check */
-    if (ac->timer)
-        rc = XaceHookResourceAccess(client, cid, X11_RESTYPE_CURSOR, pCursor,
-                      X11_RESTYPE_NONE, NULL, DixCreateAccess);
+    rc = XaceHookResourceAccess(client, cid, X11_RESTYPE_CURSOR, pCursor,
+                  X11_RESTYPE_NONE, NULL, DixCreateAccess);
 
     if (rc != Success) {
-        TimerFree(ac->timer);
         dixFiniPrivates(pCursor, PRIVATE_CURSOR);
         free(pCursor);
         return rc;
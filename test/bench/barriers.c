@@ -0,0 +1,178 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ *
+ * @brief pointer motion cost with many pointer barriers
+ *
+ * Sets up thousands of short pointer barriers, the way a shell with many
+ * panels and per-monitor edges plus some applications might, and moves
+ * the pointer around through XTEST, so every motion goes through the
+ * barrier checks.  Most barriers are away from the pointer's path, so
+ * the result is the cost of ruling them out.
+ *
+ * The XFIXES and XTEST requests are built by hand, to not depend on the
+ * xcb-xfixes and xcb-xtest libraries.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/uio.h>
+#include <xcb/xcbext.h>
+
+#include "bench.h"
+
+#define MOTIONS 20000
+
+#define XFIXES_QUERY_VERSION 0
+#define XFIXES_CREATE_POINTER_BARRIER 31
+#define XFIXES_DESTROY_POINTER_BARRIER 32
+#define XTEST_FAKE_INPUT 2
+
+static xcb_extension_t xfixes_id = { "XFIXES", 0 };
+static xcb_extension_t xtest_id = { "XTEST", 0 };
+
+static int
+xfixes_query_version(xcb_connection_t *c)
+{
+    static const xcb_protocol_request_t req = {
+        .count = 1, .ext = &xfixes_id,
+        .opcode = XFIXES_QUERY_VERSION, .isvoid = 0,
+    };
+    struct {
+        uint8_t major, minor;
+        uint16_t length;
+        uint32_t client_major, client_minor;
+    } out = { .client_major = 5, .client_minor = 0 };
+    struct iovec parts[3] = { [2] = { &out, sizeof(out) } };
+    unsigned int seq = xcb_send_request(c, 0, parts + 2, &req);
+    struct {
+        uint8_t response_type, pad0;
+        uint16_t sequence;
+        uint32_t length;
+        uint32_t major, minor;
+    } *reply = xcb_wait_for_reply(c, seq, NULL);
+    int major = reply ? reply->major : 0;
+
+    free(reply);
+    return major;
+}
+
+static void
+xfixes_barrier(xcb_connection_t *c, int opcode, uint32_t barrier,
+               xcb_window_t window, int16_t x1, int16_t y1,
+               int16_t x2, int16_t y2)
+{
+    xcb_protocol_request_t req = {
+        .count = 1, .ext = &xfixes_id, .opcode = opcode, .isvoid = 1,
+    };
+    struct {
+        uint8_t major, minor;
+        uint16_t length;
+        uint32_t barrier;
+        uint32_t window;
+        int16_t x1, y1, x2, y2;
+        uint32_t directions;
+        uint16_t pad, num_devices;
+    } out = {
+        .barrier = barrier, .window = window,
+        .x1 = x1, .y1 = y1, .x2 = x2, .y2 = y2,
+    };
+    struct iovec parts[3] = { [2] = { &out, sizeof(out) } };
+
+    /* DestroyPointerBarrier only has the barrier */
+    if (opcode == XFIXES_DESTROY_POINTER_BARRIER)
+        parts[2].iov_len = 8;
+    xcb_send_request(c, 0, parts + 2, &req);
+}
+
+static void
+xtest_motion(xcb_connection_t *c, xcb_window_t root, int16_t dx, int16_t dy)
+{
+    static const xcb_protocol_request_t req = {
+        .count = 1, .ext = &xtest_id,
+        .opcode = XTEST_FAKE_INPUT, .isvoid = 1,
+    };
+    struct {
+        uint8_t major, minor;
+        uint16_t length;
+        uint8_t type, detail, pad0[2];
+        uint32_t time;
+        uint32_t root;
+        uint8_t pad1[8];
+        int16_t root_x, root_y;
+        uint8_t pad2[7];
+        uint8_t deviceid;
+    } out = {
+        .type = XCB_MOTION_NOTIFY, .detail = 1, /* relative */
+        .root = root, .root_x = dx, .root_y = dy,
+    };
+    struct iovec parts[3] = { [2] = { &out, sizeof(out) } };
+
+    xcb_send_request(c, 0, parts + 2, &req);
+}
+
+static void
+bench_motion(xcb_connection_t *c, xcb_screen_t *screen, int nbarriers)
+{
+    uint16_t width = screen->width_in_pixels;
+    uint16_t height = screen->height_in_pixels;
+    uint32_t *barriers = calloc(nbarriers, sizeof(*barriers));
+    char name[64];
+
+    /* short barriers along the top and left edges, off the pointer's path
+     * through the middle of the screen */
+    for (int i = 0; i < nbarriers; i++) {
+        barriers[i] = xcb_generate_id(c);
+        if (i & 1) {
+            int16_t x = (i * 7) % width;
+            xfixes_barrier(c, XFIXES_CREATE_POINTER_BARRIER, barriers[i],
+                           screen->root, x, 0, x, 20);
+        }
+        else {
+            int16_t y = (i * 7) % height;
+            xfixes_barrier(c, XFIXES_CREATE_POINTER_BARRIER, barriers[i],
+                           screen->root, 0, y, 20, y);
+        }
+    }
+
+    xcb_warp_pointer(c, XCB_NONE, screen->root, 0, 0, 0, 0,
+                     width / 2, height / 2);
+    bench_sync(c);
+
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < MOTIONS; i++) {
+        int16_t d = (i & 1) ? 5 : -5;
+
+        xtest_motion(c, screen->root, d, d);
+    }
+    bench_sync(c);
+    snprintf(name, sizeof(name), "barriers-%d-motion", nbarriers);
+    bench_report(name, MOTIONS, bench_now_ns() - start);
+
+    for (int i = 0; i < nbarriers; i++)
+        xfixes_barrier(c, XFIXES_DESTROY_POINTER_BARRIER, barriers[i],
+                       XCB_NONE, 0, 0, 0, 0);
+    bench_sync(c);
+    free(barriers);
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+    const xcb_query_extension_reply_t *ext;
+
+    ext = xcb_get_extension_data(c, &xtest_id);
+    if (!ext || !ext->present || xfixes_query_version(c) < 5) {
+        printf("needs XTEST and XFIXES 5\n");
+        exit(77);
+    }
+
+    bench_motion(c, screen, 0);
+    bench_motion(c, screen, 100);
+    bench_motion(c, screen, 1000);
+    bench_motion(c, screen, 5000);
+
+    xcb_disconnect(c);
+    return 0;
+}
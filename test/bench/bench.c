@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "bench.h"
+
+xcb_connection_t *
+bench_connect(xcb_screen_t **screen_out)
+{
+    int screen;
+    xcb_connection_t *c = xcb_connect(NULL, &screen);
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "cannot connect to the X server\n");
+        exit(1);
+    }
+
+    xcb_screen_iterator_t iter = xcb_setup_roots_iterator(xcb_get_setup(c));
+    for (; iter.rem && screen > 0; screen--)
+        xcb_screen_next(&iter);
+    *screen_out = iter.data;
+    return c;
+}
+
+void
+bench_sync(xcb_connection_t *c)
+{
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+}
+
+uint64_t
+bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void
+bench_report(const char *name, uint64_t iterations, uint64_t elapsed_ns)
+{
+    double per_op = iterations ? (double) elapsed_ns / iterations : 0;
+    const char *results = getenv("XSERVER_BENCH_RESULTS");
+
+    printf("%-32s %10" PRIu64 " ops %10.3f ms %12.1f ns/op\n",
+           name, iterations, elapsed_ns / 1e6, per_op);
+    fflush(stdout);
+
+    if (results && *results) {
+        FILE *f = fopen(results, "a");
+
+        if (!f) {
+            perror(results);
+            return;
+        }
+        fprintf(f, "%s\t%" PRIu64 "\t%" PRIu64 "\t%.1f\n",
+                name, iterations, elapsed_ns, per_op);
+        fclose(f);
+    }
+}
+
+xcb_window_t
+bench_create_window(xcb_connection_t *c, xcb_screen_t *screen,
+                    int16_t x, int16_t y, uint16_t width, uint16_t height)
+{
+    xcb_window_t window = xcb_generate_id(c);
+    uint32_t values[] = { screen->black_pixel, 1 };
+
+    xcb_create_window(c, XCB_COPY_FROM_PARENT, window, screen->root,
+                      x, y, width, height, 0,
+                      XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual,
+                      XCB_CW_BACK_PIXEL | XCB_CW_OVERRIDE_REDIRECT, values);
+    xcb_map_window(c, window);
+    return window;
+}
@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ *
+ * @brief small helpers shared by the xcb based benchmarks
+ *
+ * The benchmarks are plain X clients started against Xvfb through
+ * simple-xinit.  They are registered with meson's benchmark() rather than
+ * test(), so they only run on `meson test --benchmark`.
+ */
+#ifndef XSERVER_TEST_BENCH_H
+#define XSERVER_TEST_BENCH_H
+
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+
+/**
+ * @brief connect to $DISPLAY or exit the benchmark
+ *
+ * @param screen_out returns the default screen of the connection
+ * @return the new connection
+ */
+xcb_connection_t *bench_connect(xcb_screen_t **screen_out);
+
+/**
+ * @brief make sure the server has processed everything sent so far
+ *
+ * Does a GetInputFocus round trip, so any time the server spent on
+ * earlier requests is accounted to the caller.
+ */
+void bench_sync(xcb_connection_t *c);
+
+/**
+ * @brief current CLOCK_MONOTONIC time in nanoseconds
+ */
+uint64_t bench_now_ns(void);
+
+/**
+ * @brief print the result of one workload
+ *
+ * If $XSERVER_BENCH_RESULTS names a file, the result is also appended to
+ * it as a tab separated "name iterations elapsed_ns ns_per_op" line.
+ * Repeated runs (`meson test --benchmark --repeat N`) add one line each,
+ * which compare.py uses as samples.
+ *
+ * @param name name of the workload, e.g. "shape-mask-cycle"
+ * @param iterations number of operations done
+ * @param elapsed_ns wall clock time they took
+ */
+void bench_report(const char *name, uint64_t iterations, uint64_t elapsed_ns);
+
+/**
+ * @brief create and map an override-redirect window on the root
+ */
+xcb_window_t bench_create_window(xcb_connection_t *c, xcb_screen_t *screen,
+                                 int16_t x, int16_t y,
+                                 uint16_t width, uint16_t height);
+
+#endif /* XSERVER_TEST_BENCH_H */
@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT OR X11
+#
+# Copyright © 2026 XLibre contributors
+#
+# Compare two benchmark result files written via $XSERVER_BENCH_RESULTS.
+#
+# Each line is "name<TAB>iterations<TAB>elapsed_ns<TAB>ns_per_op"; every
+# line for the same name is one sample. A workload is reported as changed
+# when Welch's t statistic exceeds 2 and the mean moved by more than the
+# threshold. Without at least MIN_SAMPLES samples on both sides there is
+# no variance to test against, so t is shown as "n/a" and the workload is
+# never reported as changed.
+
+import argparse
+import math
+import sys
+from collections import OrderedDict
+
+MIN_SAMPLES = 2
+
+
+def load(path):
+    samples = OrderedDict()
+    with open(path) as f:
+        for lineno, line in enumerate(f, 1):
+            line = line.strip()
+            if not line or line.startswith('#'):
+                continue
+            fields = line.split('\t')
+            if len(fields) < 3:
+                sys.exit(f'{path}:{lineno}: malformed line')
+            iterations, elapsed = int(fields[1]), int(fields[2])
+            if iterations == 0:
+                continue
+            samples.setdefault(fields[0], []).append(elapsed / iterations)
+    return samples
+
+
+def stats(values):
+    n = len(values)
+    mean = sum(values) / n
+    var = sum((v - mean) ** 2 for v in values) / (n - 1) if n > 1 else 0.0
+    return n, mean, var
+
+
+def welch_t(a, b):
+    na, ma, va = a
+    nb, mb, vb = b
+    if na < MIN_SAMPLES or nb < MIN_SAMPLES:
+        return None
+    se = math.sqrt(va / na + vb / nb)
+    if se == 0:
+        return math.inf if ma != mb else 0.0
+    return (mb - ma) / se
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('baseline')
+    parser.add_argument('current')
+    parser.add_argument('--threshold', type=float, default=5.0,
+                        help='minimum change in percent to report (default 5)')
+    parser.add_argument('--fail-on-regression', action='store_true',
+                        help='exit with status 1 if anything got slower')
+    args = parser.parse_args()
+
+    base = load(args.baseline)
+    cur = load(args.current)
+    regressions = 0
+
+    print(f'{"workload":32} {"base ns/op":>12} {"new ns/op":>12} '
+          f'{"change":>8} {"t":>7}')
+    for name, values in cur.items():
+        if name not in base:
+            print(f'{name:32} {"-":>12} {stats(values)[1]:12.1f}   (new)')
+            continue
+        a = stats(base[name])
+        b = stats(values)
+        change = (b[1] - a[1]) / a[1] * 100 if a[1] else 0.0
+        t = welch_t(a, b)
+        mark = ''
+        if t is not None and abs(t) > 2 and abs(change) > args.threshold:
+            mark = 'slower' if change > 0 else 'faster'
+            if change > 0:
+                regressions += 1
+        t_str = f'{t:7.2f}' if t is not None else f'{"n/a":>7}'
+        print(f'{name:32} {a[1]:12.1f} {b[1]:12.1f} {change:+7.1f}% '
+              f'{t_str} {mark}')
+    for name in base:
+        if name not in cur:
+            print(f'{name:32} {stats(base[name])[1]:12.1f} {"-":>12}   (gone)')
+
+    if args.fail_on_regression and regressions:
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,34 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ *
+ * @brief connection setup and teardown rate
+ *
+ * Connects, does one round trip and disconnects again, in a loop, like
+ * the many short-lived clients of a CI job or a shell script calling
+ * xprop and xdotool.  Covers accept, client ID setup, authorization and
+ * the connection setup reply.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+#define CONNECTIONS 2000
+
+int
+main(int argc, char **argv)
+{
+    uint64_t start = bench_now_ns();
+
+    for (int i = 0; i < CONNECTIONS; i++) {
+        xcb_screen_t *screen;
+        xcb_connection_t *c = bench_connect(&screen);
+
+        bench_sync(c);
+        xcb_disconnect(c);
+    }
+    bench_report("connect-roundtrip-disconnect", CONNECTIONS,
+                 bench_now_ns() - start);
+    return 0;
+}
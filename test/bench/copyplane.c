@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ *
+ * @brief CopyPlane and XYBitmap PutImage benchmark
+ *
+ * Expands 1 bit images onto 8, 16 and 24 bit pixmaps, both from a bitmap
+ * pixmap through CopyPlane and from the client through PutImage with
+ * XYBitmap format.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+#define ITERATIONS 200
+
+static const uint16_t sizes[] = { 64, 256, 1024 };
+static const uint8_t depths[] = { 8, 16, 24 };
+
+static void
+bench_depth(xcb_connection_t *c, xcb_screen_t *screen, uint8_t depth)
+{
+    xcb_pixmap_t bitmap = xcb_generate_id(c);
+    xcb_pixmap_t target = xcb_generate_id(c);
+    xcb_gcontext_t bitmap_gc = xcb_generate_id(c);
+    xcb_gcontext_t gc = xcb_generate_id(c);
+    uint32_t values[] = { 0x123456, 0xabcdef };
+    uint32_t one = 1;
+    int max = sizes[ARRAY_SIZE(sizes) - 1];
+    int stride = (max + 31) / 32 * 4;
+    uint8_t *bits = malloc(stride * max);
+    char name[64];
+
+    for (int i = 0; i < stride * max; i++)
+        bits[i] = rand();
+
+    xcb_create_pixmap(c, 1, bitmap, screen->root, max, max);
+    xcb_create_pixmap(c, depth, target, screen->root, max, max);
+    xcb_create_gc(c, bitmap_gc, bitmap, XCB_GC_FOREGROUND, &one);
+    xcb_create_gc(c, gc, target, XCB_GC_FOREGROUND | XCB_GC_BACKGROUND,
+                  values);
+    xcb_put_image(c, XCB_IMAGE_FORMAT_XY_PIXMAP, bitmap, bitmap_gc,
+                  max, max, 0, 0, 0, 1, stride * max, bits);
+    bench_sync(c);
+
+    for (int s = 0; s < ARRAY_SIZE(sizes); s++) {
+        uint16_t size = sizes[s];
+        uint64_t start;
+
+        start = bench_now_ns();
+        for (int i = 0; i < ITERATIONS; i++)
+            xcb_copy_plane(c, bitmap, target, gc, i & 7, 0, 0, 0,
+                           size, size, 1);
+        bench_sync(c);
+        snprintf(name, sizeof(name), "copyplane-%dx%d-depth%d",
+                 size, size, depth);
+        bench_report(name, ITERATIONS, bench_now_ns() - start);
+
+        start = bench_now_ns();
+        for (int i = 0; i < ITERATIONS; i++)
+            xcb_put_image(c, XCB_IMAGE_FORMAT_XY_BITMAP, target, gc,
+                          size, size, i & 7, 0, 0, 1,
+                          (size + 31) / 32 * 4 * size, bits);
+        bench_sync(c);
+        snprintf(name, sizeof(name), "putimage-xybitmap-%dx%d-depth%d",
+                 size, size, depth);
+        bench_report(name, ITERATIONS, bench_now_ns() - start);
+    }
+
+    xcb_free_gc(c, gc);
+    xcb_free_gc(c, bitmap_gc);
+    xcb_free_pixmap(c, target);
+    xcb_free_pixmap(c, bitmap);
+    free(bits);
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+
+    for (int i = 0; i < ARRAY_SIZE(depths); i++)
+        bench_depth(c, screen, depths[i]);
+
+    xcb_disconnect(c);
+    return 0;
+}
@@ -0,0 +1,133 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ *
+ * @brief cost of DAMAGE rectangle reporting to root window watchers
+ *
+ * One connection watches the root window with a RawRectangles damage
+ * object, like a compositor or screen sharing server does, while another
+ * one draws: repeated fills of the same area (video-like) and small fills
+ * scattered over a window.  Reports the drawing time and how many
+ * DamageNotify events the watcher got for it; run the server with
+ * -damagebatch to compare.
+ *
+ * The DAMAGE requests are built by hand, to not depend on xcb-damage.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <xcb/xcbext.h>
+
+#include "bench.h"
+
+#define FILLS 20000
+
+#define DAMAGE_CREATE 1
+#define DAMAGE_REPORT_RAW_RECTANGLES 0
+
+static xcb_extension_t damage_id = { "DAMAGE", 0 };
+
+static void
+damage_create(xcb_connection_t *c, uint32_t damage, xcb_drawable_t drawable)
+{
+    static const xcb_protocol_request_t req = {
+        .count = 1, .ext = &damage_id, .opcode = DAMAGE_CREATE, .isvoid = 1,
+    };
+    struct {
+        uint8_t major, minor;
+        uint16_t length;
+        uint32_t damage;
+        uint32_t drawable;
+        uint8_t level, pad[3];
+    } out = {
+        .damage = damage, .drawable = drawable,
+        .level = DAMAGE_REPORT_RAW_RECTANGLES,
+    };
+    struct iovec parts[3] = { [2] = { &out, sizeof(out) } };
+
+    xcb_send_request(c, 0, parts + 2, &req);
+}
+
+/* count the DamageNotify events that have arrived, waiting a bit for any
+ * the server still holds back in a batch */
+static int
+drain_events(xcb_connection_t *c, uint8_t notify_type)
+{
+    xcb_generic_event_t *ev;
+    int count = 0;
+
+    bench_sync(c);
+    usleep(50 * 1000);
+    bench_sync(c);
+    while ((ev = xcb_poll_for_event(c))) {
+        if ((ev->response_type & 0x7f) == notify_type)
+            count++;
+        free(ev);
+    }
+    return count;
+}
+
+static void
+bench_fills(xcb_connection_t *c, xcb_connection_t *watcher,
+            uint8_t notify_type, xcb_window_t window, xcb_gcontext_t gc,
+            const char *name, int scatter)
+{
+    uint64_t start;
+    int events;
+
+    drain_events(watcher, notify_type);
+
+    start = bench_now_ns();
+    for (int i = 0; i < FILLS; i++) {
+        xcb_rectangle_t rect = { 0, 0, 128, 128 };
+
+        if (scatter) {
+            rect.x = (i * 37) % 252;
+            rect.y = (i * 91) % 252;
+            rect.width = rect.height = 4;
+        }
+        xcb_poly_fill_rectangle(c, window, gc, 1, &rect);
+    }
+    bench_sync(c);
+    bench_report(name, FILLS, bench_now_ns() - start);
+
+    events = drain_events(watcher, notify_type);
+    printf("%-32s %10d events\n", name, events);
+    fflush(stdout);
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_screen_t *screen, *watcher_screen;
+    xcb_connection_t *c = bench_connect(&screen);
+    xcb_connection_t *watcher = bench_connect(&watcher_screen);
+    const xcb_query_extension_reply_t *ext;
+    xcb_window_t window;
+    xcb_gcontext_t gc;
+
+    ext = xcb_get_extension_data(watcher, &damage_id);
+    if (!ext || !ext->present) {
+        printf("DAMAGE not available\n");
+        exit(77);
+    }
+
+    damage_create(watcher, xcb_generate_id(watcher), watcher_screen->root);
+    bench_sync(watcher);
+
+    window = bench_create_window(c, screen, 0, 0, 256, 256);
+    gc = xcb_generate_id(c);
+    xcb_create_gc(c, gc, window, XCB_GC_FOREGROUND,
+                  (uint32_t[]) { screen->white_pixel });
+    bench_sync(c);
+
+    bench_fills(c, watcher, ext->first_event, window, gc,
+                "damage-raw-frames", 0);
+    bench_fills(c, watcher, ext->first_event, window, gc,
+                "damage-raw-scatter", 1);
+
+    xcb_disconnect(watcher);
+    xcb_disconnect(c);
+    return 0;
+}
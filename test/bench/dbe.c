@@ -0,0 +1,157 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ *
+ * @brief DBE swap cost on large windows
+ *
+ * Swaps the back buffer of a screen sized window after redrawing either a small
+ * part of it or all of it, first with the window drawn straight to the
+ * screen and then with it redirected by Composite.  libxcb has no DBE
+ * binding and Composite may not be available as xcb-composite, so the few
+ * requests needed are built by hand.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/uio.h>
+#include <xcb/xcbext.h>
+
+#include "bench.h"
+
+#define SWAPS 200
+
+#define DBE_ALLOCATE_BACK_BUFFER_NAME 1
+#define DBE_SWAP_BUFFERS 3
+
+#define DBE_UNDEFINED 0
+#define DBE_UNTOUCHED 2
+#define DBE_COPIED 3
+
+#define COMPOSITE_REDIRECT_SUBWINDOWS 2
+#define COMPOSITE_REDIRECT_AUTOMATIC 0
+
+static xcb_extension_t dbe_id = { "DOUBLE-BUFFER", 0 };
+static xcb_extension_t composite_id = { "Composite", 0 };
+
+static void
+dbe_allocate_back_buffer(xcb_connection_t *c, xcb_window_t window,
+                         uint32_t buffer, uint8_t swap_action)
+{
+    static const xcb_protocol_request_t req = {
+        .count = 1, .ext = &dbe_id,
+        .opcode = DBE_ALLOCATE_BACK_BUFFER_NAME, .isvoid = 1,
+    };
+    struct {
+        uint8_t major, minor;
+        uint16_t length;
+        uint32_t window, buffer;
+        uint8_t swap_action, pad[3];
+    } out = { .window = window, .buffer = buffer, .swap_action = swap_action };
+    struct iovec parts[3] = { [2] = { &out, sizeof(out) } };
+
+    xcb_send_request(c, 0, parts + 2, &req);
+}
+
+static void
+dbe_swap(xcb_connection_t *c, xcb_window_t window, uint8_t swap_action)
+{
+    static const xcb_protocol_request_t req = {
+        .count = 1, .ext = &dbe_id,
+        .opcode = DBE_SWAP_BUFFERS, .isvoid = 1,
+    };
+    struct {
+        uint8_t major, minor;
+        uint16_t length;
+        uint32_t n;
+        uint32_t window;
+        uint8_t swap_action, pad[3];
+    } out = { .n = 1, .window = window, .swap_action = swap_action };
+    struct iovec parts[3] = { [2] = { &out, sizeof(out) } };
+
+    xcb_send_request(c, 0, parts + 2, &req);
+}
+
+static void
+composite_redirect_subwindows(xcb_connection_t *c, xcb_window_t window)
+{
+    static const xcb_protocol_request_t req = {
+        .count = 1, .ext = &composite_id,
+        .opcode = COMPOSITE_REDIRECT_SUBWINDOWS, .isvoid = 1,
+    };
+    struct {
+        uint8_t major, minor;
+        uint16_t length;
+        uint32_t window;
+        uint8_t update, pad[3];
+    } out = { .window = window, .update = COMPOSITE_REDIRECT_AUTOMATIC };
+    struct iovec parts[3] = { [2] = { &out, sizeof(out) } };
+
+    xcb_send_request(c, 0, parts + 2, &req);
+}
+
+static void
+bench_swaps(xcb_connection_t *c, xcb_screen_t *screen, uint8_t swap_action,
+            const char *action_name, int full_redraw, const char *mode)
+{
+    const uint16_t width = screen->width_in_pixels;
+    const uint16_t height = screen->height_in_pixels;
+    xcb_window_t window = bench_create_window(c, screen, 0, 0, width, height);
+    uint32_t buffer = xcb_generate_id(c);
+    xcb_gcontext_t gc = xcb_generate_id(c);
+    char name[64];
+
+    dbe_allocate_back_buffer(c, window, buffer, swap_action);
+    xcb_create_gc(c, gc, buffer, 0, NULL);
+    bench_sync(c);
+
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < SWAPS; i++) {
+        uint32_t fg = i & 1 ? screen->white_pixel : screen->black_pixel;
+        xcb_rectangle_t rect = { (i * 7) % (width - 64), (i * 5) % (height - 32),
+                                 64, 32 };
+
+        if (full_redraw) {
+            rect.x = rect.y = 0;
+            rect.width = width;
+            rect.height = height;
+        }
+        xcb_change_gc(c, gc, XCB_GC_FOREGROUND, &fg);
+        xcb_poly_fill_rectangle(c, buffer, gc, 1, &rect);
+        dbe_swap(c, window, swap_action);
+    }
+    bench_sync(c);
+    snprintf(name, sizeof(name), "dbe-swap-%s-%s-%s", mode, action_name,
+             full_redraw ? "full" : "small");
+    bench_report(name, SWAPS, bench_now_ns() - start);
+
+    xcb_free_gc(c, gc);
+    xcb_destroy_window(c, window);
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+    const xcb_query_extension_reply_t *ext = xcb_get_extension_data(c, &dbe_id);
+
+    if (!ext || !ext->present) {
+        printf("DOUBLE-BUFFER not available\n");
+        exit(77);
+    }
+
+    bench_swaps(c, screen, DBE_COPIED, "copied", 0, "direct");
+    bench_swaps(c, screen, DBE_COPIED, "copied", 1, "direct");
+    bench_swaps(c, screen, DBE_UNDEFINED, "undefined", 0, "direct");
+    bench_swaps(c, screen, DBE_UNTOUCHED, "untouched", 1, "direct");
+
+    ext = xcb_get_extension_data(c, &composite_id);
+    if (ext && ext->present) {
+        composite_redirect_subwindows(c, screen->root);
+        bench_swaps(c, screen, DBE_COPIED, "copied", 1, "redirected");
+        bench_swaps(c, screen, DBE_UNDEFINED, "undefined", 1, "redirected");
+        bench_swaps(c, screen, DBE_UNTOUCHED, "untouched", 1, "redirected");
+    }
+
+    xcb_disconnect(c);
+    return 0;
+}
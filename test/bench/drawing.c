@@ -0,0 +1,459 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ *
+ * @brief x11perf style rendering throughput
+ *
+ * Times core drawing, CopyArea, PutImage/GetImage, MIT-SHM and Render
+ * composite, trapezoid and glyph requests at several sizes.  Each workload
+ * is repeated, doubling the count, until one run takes long enough to
+ * time reliably, so the results are comparable between builds and can be
+ * fed to compare.py.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include <xcb/render.h>
+#include <xcb/shm.h>
+
+#include "bench.h"
+
+#define MIN_RUN_NS 200000000ULL
+#define MAX_REPS (1 << 20)
+#define TARGET_SIZE 600
+#define GLYPHS 32
+/* larger glyphs mostly end up clipped */
+#define MAX_GLYPH_SIZE 100
+
+static const uint16_t sizes[] = { 10, 100, 500 };
+
+struct ctx {
+    xcb_connection_t *c;
+    xcb_screen_t *screen;
+    xcb_pixmap_t pixmap;
+    xcb_pixmap_t source;
+    xcb_gcontext_t gc;
+    uint8_t *image;
+
+    int has_shm;
+    xcb_shm_seg_t shmseg;
+    int shmid;
+    uint8_t *shm;
+
+    int has_render;
+    xcb_render_picture_t dst;
+    xcb_render_picture_t argb;
+    xcb_render_picture_t solid;
+    xcb_render_pictformat_t a8_format;
+    xcb_render_glyphset_t glyphsets[ARRAY_SIZE(sizes)];
+};
+
+typedef void (*workload_func)(struct ctx *x, uint16_t size, uint32_t count);
+
+static void
+fill_rectangle(struct ctx *x, uint16_t size, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        xcb_rectangle_t rect = { i & 63, 0, size, size };
+
+        xcb_poly_fill_rectangle(x->c, x->pixmap, x->gc, 1, &rect);
+    }
+}
+
+static void
+segment(struct ctx *x, uint16_t size, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        xcb_segment_t seg = { i & 63, 0, (i & 63) + size, size };
+
+        xcb_poly_segment(x->c, x->pixmap, x->gc, 1, &seg);
+    }
+}
+
+static void
+fill_arc(struct ctx *x, uint16_t size, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        xcb_arc_t arc = { i & 63, 0, size, size, 0, 360 * 64 };
+
+        xcb_poly_fill_arc(x->c, x->pixmap, x->gc, 1, &arc);
+    }
+}
+
+static void
+copy_area(struct ctx *x, uint16_t size, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+        xcb_copy_area(x->c, x->source, x->pixmap, x->gc,
+                      0, 0, i & 63, 0, size, size);
+}
+
+static void
+put_image(struct ctx *x, uint16_t size, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+        xcb_put_image(x->c, XCB_IMAGE_FORMAT_Z_PIXMAP, x->pixmap, x->gc,
+                      size, size, i & 63, 0, 0, x->screen->root_depth,
+                      size * size * 4, x->image);
+}
+
+static void
+get_image(struct ctx *x, uint16_t size, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+        free(xcb_get_image_reply(x->c,
+                                 xcb_get_image(x->c, XCB_IMAGE_FORMAT_Z_PIXMAP,
+                                               x->pixmap, i & 63, 0,
+                                               size, size, ~0),
+                                 NULL));
+}
+
+static void
+shm_put_image(struct ctx *x, uint16_t size, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+        xcb_shm_put_image(x->c, x->pixmap, x->gc, size, size, 0, 0,
+                          size, size, i & 63, 0, x->screen->root_depth,
+                          XCB_IMAGE_FORMAT_Z_PIXMAP, 0, x->shmseg, 0);
+}
+
+static void
+shm_get_image(struct ctx *x, uint16_t size, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+        free(xcb_shm_get_image_reply(x->c,
+                                     xcb_shm_get_image(x->c, x->pixmap,
+                                                       i & 63, 0, size, size,
+                                                       ~0,
+                                                       XCB_IMAGE_FORMAT_Z_PIXMAP,
+                                                       x->shmseg, 0),
+                                     NULL));
+}
+
+static void
+composite_over(struct ctx *x, uint16_t size, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+        xcb_render_composite(x->c, XCB_RENDER_PICT_OP_OVER, x->argb,
+                             XCB_NONE, x->dst, 0, 0, 0, 0, i & 63, 0,
+                             size, size);
+}
+
+static void
+composite_src(struct ctx *x, uint16_t size, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+        xcb_render_composite(x->c, XCB_RENDER_PICT_OP_SRC, x->argb,
+                             XCB_NONE, x->dst, 0, 0, 0, 0, i & 63, 0,
+                             size, size);
+}
+
+static xcb_render_fixed_t
+fixed(int v)
+{
+    return v * 65536;
+}
+
+static void
+trapezoids(struct ctx *x, uint16_t size, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        int x0 = i & 63;
+        /* a slanted quad, so the edges need antialiasing */
+        xcb_render_trapezoid_t trap = {
+            .top = fixed(0),
+            .bottom = fixed(size),
+            .left = { { fixed(x0 + size / 4), fixed(0) },
+                      { fixed(x0), fixed(size) } },
+            .right = { { fixed(x0 + size), fixed(0) },
+                       { fixed(x0 + size - size / 4), fixed(size) } },
+        };
+
+        xcb_render_trapezoids(x->c, XCB_RENDER_PICT_OP_OVER, x->solid,
+                              x->dst, x->a8_format, 0, 0, 1, &trap);
+    }
+}
+
+static void
+glyphs(struct ctx *x, uint16_t size, uint32_t count)
+{
+    /* one glyph element: count, pad[3], dx, dy, then the glyph ids */
+    uint8_t cmd[8 + GLYPHS];
+    int16_t origin[2] = { 0, size };
+    int set = 0;
+
+    while (sizes[set] != size)
+        set++;
+
+    memset(cmd, 0, sizeof(cmd));
+    cmd[0] = GLYPHS;
+    memcpy(cmd + 4, origin, sizeof(origin));
+    for (int g = 0; g < GLYPHS; g++)
+        cmd[8 + g] = g;
+
+    for (uint32_t i = 0; i < count; i++)
+        xcb_render_composite_glyphs_8(x->c, XCB_RENDER_PICT_OP_OVER,
+                                      x->solid, x->dst, x->a8_format,
+                                      x->glyphsets[set], 0, 0,
+                                      sizeof(cmd), cmd);
+}
+
+/* Double the repetitions until a run takes long enough to time reliably */
+static void
+run(struct ctx *x, const char *name, workload_func func, uint16_t size)
+{
+    char label[64];
+    uint32_t count = 1;
+    uint64_t elapsed;
+
+    for (;;) {
+        uint64_t start = bench_now_ns();
+
+        func(x, size, count);
+        bench_sync(x->c);
+        elapsed = bench_now_ns() - start;
+        if (elapsed >= MIN_RUN_NS || count >= MAX_REPS)
+            break;
+        count *= 2;
+    }
+
+    snprintf(label, sizeof(label), "%s-%dx%d", name, size, size);
+    bench_report(label, count, elapsed);
+}
+
+static void
+setup_shm(struct ctx *x)
+{
+    xcb_shm_query_version_reply_t *version;
+    size_t bytes = (size_t) TARGET_SIZE * TARGET_SIZE * 4;
+
+    version = xcb_shm_query_version_reply(x->c, xcb_shm_query_version(x->c),
+                                          NULL);
+    if (!version)
+        return;
+    free(version);
+
+    x->shmid = shmget(IPC_PRIVATE, bytes, IPC_CREAT | 0600);
+    if (x->shmid < 0)
+        return;
+
+    x->shm = shmat(x->shmid, NULL, 0);
+    if (x->shm == (void *) -1) {
+        shmctl(x->shmid, IPC_RMID, NULL);
+        return;
+    }
+    memcpy(x->shm, x->image, bytes);
+
+    x->shmseg = xcb_generate_id(x->c);
+    if (xcb_request_check(x->c, xcb_shm_attach_checked(x->c, x->shmseg,
+                                                       x->shmid, 0))) {
+        shmdt(x->shm);
+        shmctl(x->shmid, IPC_RMID, NULL);
+        return;
+    }
+    x->has_shm = 1;
+}
+
+static xcb_render_pictformat_t
+find_direct_format(const xcb_render_query_pict_formats_reply_t *formats,
+                   uint8_t depth, uint16_t alpha_mask, uint16_t red_mask)
+{
+    xcb_render_pictforminfo_iterator_t it =
+        xcb_render_query_pict_formats_formats_iterator(formats);
+
+    for (; it.rem; xcb_render_pictforminfo_next(&it)) {
+        if (it.data->type == XCB_RENDER_PICT_TYPE_DIRECT &&
+            it.data->depth == depth &&
+            it.data->direct.alpha_mask == alpha_mask &&
+            it.data->direct.red_mask == red_mask)
+            return it.data->id;
+    }
+    return XCB_NONE;
+}
+
+static xcb_render_pictformat_t
+find_visual_format(const xcb_render_query_pict_formats_reply_t *formats,
+                   xcb_visualid_t visual)
+{
+    xcb_render_pictscreen_iterator_t screens =
+        xcb_render_query_pict_formats_screens_iterator(formats);
+
+    for (; screens.rem; xcb_render_pictscreen_next(&screens)) {
+        xcb_render_pictdepth_iterator_t depths =
+            xcb_render_pictscreen_depths_iterator(screens.data);
+
+        for (; depths.rem; xcb_render_pictdepth_next(&depths)) {
+            xcb_render_pictvisual_iterator_t visuals =
+                xcb_render_pictdepth_visuals_iterator(depths.data);
+
+            for (; visuals.rem; xcb_render_pictvisual_next(&visuals)) {
+                if (visuals.data->visual == visual)
+                    return visuals.data->format;
+            }
+        }
+    }
+    return XCB_NONE;
+}
+
+static void
+setup_glyphs(struct ctx *x)
+{
+    for (int s = 0; s < ARRAY_SIZE(sizes) && sizes[s] <= MAX_GLYPH_SIZE; s++) {
+        uint16_t size = sizes[s];
+        int stride = (size + 3) & ~3;
+        uint32_t ids[GLYPHS];
+        xcb_render_glyphinfo_t info[GLYPHS];
+        uint8_t *data = calloc(GLYPHS, (size_t) stride * size);
+
+        for (int g = 0; g < GLYPHS; g++) {
+            uint8_t *bits = data + (size_t) g * stride * size;
+
+            ids[g] = g;
+            info[g] = (xcb_render_glyphinfo_t) {
+                .width = size, .height = size,
+                .x = 0, .y = size, .x_off = size, .y_off = 0,
+            };
+            /* a filled box with a hole, coverage varying per glyph */
+            for (int y = 0; y < size; y++)
+                for (int i = 0; i < size; i++)
+                    bits[y * stride + i] =
+                        (y > size / 4 && y < size * 3 / 4 &&
+                         i > size / 4 && i < size * 3 / 4) ? 0 : 0x80 + g;
+        }
+
+        x->glyphsets[s] = xcb_generate_id(x->c);
+        xcb_render_create_glyph_set(x->c, x->glyphsets[s], x->a8_format);
+        xcb_render_add_glyphs(x->c, x->glyphsets[s], GLYPHS, ids, info,
+                              (size_t) GLYPHS * stride * size, data);
+        free(data);
+    }
+}
+
+static void
+setup_render(struct ctx *x)
+{
+    xcb_render_query_version_reply_t *version;
+    xcb_render_query_pict_formats_reply_t *formats;
+    xcb_render_pictformat_t root_format, argb_format;
+    xcb_pixmap_t pixmap;
+    uint32_t repeat = XCB_RENDER_REPEAT_NORMAL;
+    xcb_render_color_t color = { 0x8000, 0x4000, 0x2000, 0x8000 };
+    xcb_rectangle_t rect = { 0, 0, TARGET_SIZE, TARGET_SIZE };
+
+    version = xcb_render_query_version_reply(x->c,
+                                             xcb_render_query_version(x->c,
+                                                                      0, 11),
+                                             NULL);
+    if (!version)
+        return;
+    free(version);
+
+    formats = xcb_render_query_pict_formats_reply(x->c,
+                                                  xcb_render_query_pict_formats(x->c),
+                                                  NULL);
+    if (!formats)
+        return;
+
+    root_format = find_visual_format(formats, x->screen->root_visual);
+    argb_format = find_direct_format(formats, 32, 0xff, 0xff);
+    x->a8_format = find_direct_format(formats, 8, 0xff, 0);
+    free(formats);
+    if (!root_format || !argb_format || !x->a8_format)
+        return;
+
+    x->dst = xcb_generate_id(x->c);
+    xcb_render_create_picture(x->c, x->dst, x->pixmap, root_format, 0, NULL);
+
+    pixmap = xcb_generate_id(x->c);
+    xcb_create_pixmap(x->c, 32, pixmap, x->screen->root,
+                      TARGET_SIZE, TARGET_SIZE);
+    x->argb = xcb_generate_id(x->c);
+    xcb_render_create_picture(x->c, x->argb, pixmap, argb_format, 0, NULL);
+    xcb_render_fill_rectangles(x->c, XCB_RENDER_PICT_OP_SRC, x->argb,
+                               color, 1, &rect);
+    xcb_free_pixmap(x->c, pixmap);
+
+    pixmap = xcb_generate_id(x->c);
+    xcb_create_pixmap(x->c, 32, pixmap, x->screen->root, 1, 1);
+    x->solid = xcb_generate_id(x->c);
+    xcb_render_create_picture(x->c, x->solid, pixmap, argb_format,
+                              XCB_RENDER_CP_REPEAT, &repeat);
+    xcb_render_fill_rectangles(x->c, XCB_RENDER_PICT_OP_SRC, x->solid,
+                               color, 1, &rect);
+    xcb_free_pixmap(x->c, pixmap);
+
+    setup_glyphs(x);
+    x->has_render = 1;
+}
+
+int
+main(int argc, char **argv)
+{
+    struct ctx x = { 0 };
+    uint32_t values[] = { 0x336699, 0 };
+    size_t bytes = (size_t) TARGET_SIZE * TARGET_SIZE * 4;
+
+    x.c = bench_connect(&x.screen);
+    if (x.screen->root_depth != 24) {
+        printf("needs a depth 24 screen\n");
+        exit(77);
+    }
+
+    x.pixmap = xcb_generate_id(x.c);
+    xcb_create_pixmap(x.c, x.screen->root_depth, x.pixmap, x.screen->root,
+                      TARGET_SIZE + 64, TARGET_SIZE);
+    x.source = xcb_generate_id(x.c);
+    xcb_create_pixmap(x.c, x.screen->root_depth, x.source, x.screen->root,
+                      TARGET_SIZE, TARGET_SIZE);
+    x.gc = xcb_generate_id(x.c);
+    xcb_create_gc(x.c, x.gc, x.pixmap,
+                  XCB_GC_FOREGROUND | XCB_GC_GRAPHICS_EXPOSURES, values);
+
+    x.image = malloc(bytes);
+    for (size_t i = 0; i < bytes; i++)
+        x.image[i] = i * 7;
+
+    setup_shm(&x);
+    setup_render(&x);
+    bench_sync(x.c);
+
+    for (int s = 0; s < ARRAY_SIZE(sizes); s++) {
+        uint16_t size = sizes[s];
+
+        run(&x, "fillrect", fill_rectangle, size);
+        run(&x, "segment", segment, size);
+        run(&x, "fillarc", fill_arc, size);
+        run(&x, "copyarea", copy_area, size);
+        run(&x, "putimage", put_image, size);
+        run(&x, "getimage", get_image, size);
+        if (x.has_shm) {
+            run(&x, "shmputimage", shm_put_image, size);
+            run(&x, "shmgetimage", shm_get_image, size);
+        }
+        if (x.has_render) {
+            run(&x, "composite-over", composite_over, size);
+            run(&x, "composite-src", composite_src, size);
+            run(&x, "trapezoids", trapezoids, size);
+            if (size <= MAX_GLYPH_SIZE)
+                run(&x, "glyphs", glyphs, size);
+        }
+    }
+
+    if (!x.has_shm)
+        printf("MIT-SHM not available, skipped its workloads\n");
+    if (!x.has_render)
+        printf("RENDER not available, skipped its workloads\n");
+
+    if (x.has_shm) {
+        xcb_shm_detach(x.c, x.shmseg);
+        bench_sync(x.c);
+        shmdt(x.shm);
+        shmctl(x.shmid, IPC_RMID, NULL);
+    }
+    free(x.image);
+    xcb_disconnect(x.c);
+    return 0;
+}
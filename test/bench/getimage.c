@@ -0,0 +1,70 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ *
+ * @brief GetImage capture throughput
+ *
+ * Pulls whole 1080p and 4K frames with plain GetImage requests, the way
+ * screen capture tools without MIT-SHM do, plus a smaller XYPixmap capture
+ * for the per-plane path.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+#define FRAMES 30
+
+static void
+bench_capture(xcb_connection_t *c, xcb_screen_t *screen, uint8_t format,
+              const char *format_name, uint16_t width, uint16_t height)
+{
+    xcb_pixmap_t pixmap = xcb_generate_id(c);
+    xcb_gcontext_t gc = xcb_generate_id(c);
+    uint32_t values[] = { 0x336699 };
+    xcb_rectangle_t rect = { 0, 0, width, height };
+    char name[64];
+
+    xcb_create_pixmap(c, screen->root_depth, pixmap, screen->root,
+                      width, height);
+    xcb_create_gc(c, gc, pixmap, XCB_GC_FOREGROUND, values);
+    xcb_poly_fill_rectangle(c, pixmap, gc, 1, &rect);
+    bench_sync(c);
+
+    uint64_t start = bench_now_ns();
+    for (int f = 0; f < FRAMES; f++) {
+        xcb_get_image_reply_t *reply =
+            xcb_get_image_reply(c, xcb_get_image(c, format, pixmap, 0, 0,
+                                                 width, height, ~0), NULL);
+        if (!reply) {
+            fprintf(stderr, "GetImage %dx%d failed\n", width, height);
+            exit(1);
+        }
+        free(reply);
+    }
+    snprintf(name, sizeof(name), "getimage-%s-%dx%d-frame",
+             format_name, width, height);
+    bench_report(name, FRAMES, bench_now_ns() - start);
+
+    xcb_free_gc(c, gc);
+    xcb_free_pixmap(c, pixmap);
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+
+    if (screen->root_depth != 24) {
+        printf("needs a depth 24 screen\n");
+        exit(77);
+    }
+
+    bench_capture(c, screen, XCB_IMAGE_FORMAT_Z_PIXMAP, "zpixmap", 1920, 1080);
+    bench_capture(c, screen, XCB_IMAGE_FORMAT_Z_PIXMAP, "zpixmap", 3840, 2160);
+    bench_capture(c, screen, XCB_IMAGE_FORMAT_XY_PIXMAP, "xypixmap", 1920, 1080);
+
+    xcb_disconnect(c);
+    return 0;
+}
@@ -0,0 +1,258 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ *
+ * @brief server wakeups caused by SYNC IDLETIME and SERVERTIME_US alarms
+ *
+ * Sets up many IDLETIME alarms, the way a few power management and
+ * presence daemons together do, and reports how often the server wakes up
+ * while idle and what the alarms add to the cost of a round trip.  Then
+ * runs a periodic SERVERTIME_US alarm and reports how many notifies it
+ * delivered and how many wakeups that took.
+ *
+ * Wakeups are the voluntary context switches of the server's main thread,
+ * read from /proc, so they are only reported on Linux.  The SYNC requests
+ * are built by hand, to not depend on xcb-sync.
+ */
+#define _GNU_SOURCE             /* struct ucred */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <xcb/xcbext.h>
+
+#include "bench.h"
+
+#define IDLE_ALARMS 64
+#define IDLE_SECONDS 2
+#define ROUND_TRIPS 20000
+#define PERIOD_US 5000
+#define PERIOD_SECONDS 1
+
+#define SYNC_LIST_SYSTEM_COUNTERS 1
+#define SYNC_QUERY_COUNTER 5
+#define SYNC_CREATE_ALARM 8
+#define SYNC_ALARM_NOTIFY 1
+
+#define CA_COUNTER (1 << 0)
+#define CA_VALUE_TYPE (1 << 1)
+#define CA_VALUE (1 << 2)
+#define CA_TEST_TYPE (1 << 3)
+#define CA_DELTA (1 << 4)
+#define CA_EVENTS (1 << 5)
+
+#define ABSOLUTE 0
+#define POSITIVE_TRANSITION 0
+#define NEGATIVE_TRANSITION 1
+
+static xcb_extension_t sync_id = { "SYNC", 0 };
+
+static uint32_t
+find_counter(xcb_connection_t *c, const char *name)
+{
+    static const xcb_protocol_request_t req = {
+        .count = 1, .ext = &sync_id, .opcode = SYNC_LIST_SYSTEM_COUNTERS,
+    };
+    struct {
+        uint8_t major, minor;
+        uint16_t length;
+    } out = { .length = 1 };
+    struct iovec parts[3] = { [2] = { &out, sizeof(out) } };
+    uint8_t *reply, *p, *end;
+    uint32_t count, id = 0;
+
+    reply = xcb_wait_for_reply(c, xcb_send_request(c, 0, parts + 2, &req),
+                               NULL);
+    if (!reply)
+        return 0;
+
+    memcpy(&count, reply + 8, 4);
+    p = reply + 32;
+    end = p + 4 * ((xcb_generic_reply_t *) reply)->length;
+    /* entries: counter, resolution hi and lo, name length, name, pad */
+    while (count-- && p + 14 <= end) {
+        uint16_t len;
+
+        memcpy(&len, p + 12, 2);
+        if (len == strlen(name) && !memcmp(p + 14, name, len)) {
+            memcpy(&id, p, 4);
+            break;
+        }
+        p += (14 + len + 3) & ~3;
+    }
+    free(reply);
+    return id;
+}
+
+static int64_t
+query_counter(xcb_connection_t *c, uint32_t counter)
+{
+    static const xcb_protocol_request_t req = {
+        .count = 1, .ext = &sync_id, .opcode = SYNC_QUERY_COUNTER,
+    };
+    struct {
+        uint8_t major, minor;
+        uint16_t length;
+        uint32_t counter;
+    } out = { .length = 2, .counter = counter };
+    struct iovec parts[3] = { [2] = { &out, sizeof(out) } };
+    uint8_t *reply;
+    int32_t hi;
+    uint32_t lo;
+
+    reply = xcb_wait_for_reply(c, xcb_send_request(c, 0, parts + 2, &req),
+                               NULL);
+    if (!reply)
+        return 0;
+    memcpy(&hi, reply + 8, 4);
+    memcpy(&lo, reply + 12, 4);
+    free(reply);
+    return (int64_t) hi << 32 | lo;
+}
+
+static void
+create_alarm(xcb_connection_t *c, uint32_t counter, int64_t value,
+             uint32_t test_type, int64_t delta, uint32_t events)
+{
+    static const xcb_protocol_request_t req = {
+        .count = 1, .ext = &sync_id, .opcode = SYNC_CREATE_ALARM,
+        .isvoid = 1,
+    };
+    struct {
+        uint8_t major, minor;
+        uint16_t length;
+        uint32_t id;
+        uint32_t mask;
+        uint32_t counter;
+        uint32_t value_type;
+        int32_t value_hi;
+        uint32_t value_lo;
+        uint32_t test_type;
+        int32_t delta_hi;
+        uint32_t delta_lo;
+        uint32_t events;
+    } out = {
+        .length = 12, .id = xcb_generate_id(c),
+        .mask = CA_COUNTER | CA_VALUE_TYPE | CA_VALUE | CA_TEST_TYPE |
+            CA_DELTA | CA_EVENTS,
+        .counter = counter, .value_type = ABSOLUTE,
+        .value_hi = value >> 32, .value_lo = value,
+        .test_type = test_type,
+        .delta_hi = delta >> 32, .delta_lo = delta,
+        .events = events,
+    };
+    struct iovec parts[3] = { [2] = { &out, sizeof(out) } };
+
+    xcb_send_request(c, 0, parts + 2, &req);
+}
+
+/* voluntary context switches of the server's main thread, or -1 */
+static long
+server_wakeups(xcb_connection_t *c)
+{
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    char path[64], line[128];
+    long switches = -1;
+    FILE *f;
+
+    if (getsockopt(xcb_get_file_descriptor(c), SOL_SOCKET, SO_PEERCRED,
+                   &cred, &len) < 0)
+        return -1;
+    snprintf(path, sizeof(path), "/proc/%d/status", (int) cred.pid);
+    f = fopen(path, "r");
+    if (!f)
+        return -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "voluntary_ctxt_switches: %ld", &switches) == 1)
+            break;
+    }
+    fclose(f);
+    return switches;
+}
+
+static void
+report_wakeups(const char *name, long before, long after, int seconds)
+{
+    if (before < 0 || after < 0)
+        printf("%-32s %10s\n", name, "n/a");
+    else
+        printf("%-32s %10ld wakeups/s\n", name, (after - before) / seconds);
+    fflush(stdout);
+}
+
+static void
+bench_round_trips(xcb_connection_t *c, const char *name)
+{
+    uint64_t start = bench_now_ns();
+
+    for (int i = 0; i < ROUND_TRIPS; i++)
+        bench_sync(c);
+    bench_report(name, ROUND_TRIPS, bench_now_ns() - start);
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+    const xcb_query_extension_reply_t *ext;
+    xcb_generic_event_t *ev;
+    uint32_t idletime, servertime_us;
+    uint64_t start;
+    long before;
+    int notifies = 0;
+
+    ext = xcb_get_extension_data(c, &sync_id);
+    if (!ext || !ext->present) {
+        printf("SYNC not available\n");
+        exit(77);
+    }
+    idletime = find_counter(c, "IDLETIME");
+    servertime_us = find_counter(c, "SERVERTIME_US");
+    if (!idletime || !servertime_us) {
+        printf("IDLETIME or SERVERTIME_US counter not available\n");
+        exit(77);
+    }
+
+    bench_round_trips(c, "idletime-0-alarms");
+
+    /* half wait for the user to go idle, half for the user to return */
+    for (int i = 0; i < IDLE_ALARMS / 2; i++) {
+        create_alarm(c, idletime, 3600 * 1000 + i, POSITIVE_TRANSITION,
+                     0, 0);
+        create_alarm(c, idletime, 1000 + i, NEGATIVE_TRANSITION, 0, 0);
+    }
+    bench_sync(c);
+
+    before = server_wakeups(c);
+    sleep(IDLE_SECONDS);
+    report_wakeups("idletime-idle", before, server_wakeups(c), IDLE_SECONDS);
+
+    bench_round_trips(c, "idletime-64-alarms");
+
+    create_alarm(c, servertime_us, query_counter(c, servertime_us) + PERIOD_US,
+                 POSITIVE_TRANSITION, PERIOD_US, 1);
+    bench_sync(c);
+
+    before = server_wakeups(c);
+    start = bench_now_ns();
+    while (bench_now_ns() - start < PERIOD_SECONDS * 1000000000ull) {
+        ev = xcb_wait_for_event(c);
+        if (!ev)
+            break;
+        if ((ev->response_type & 0x7f) ==
+            ext->first_event + SYNC_ALARM_NOTIFY)
+            notifies++;
+        free(ev);
+    }
+    report_wakeups("servertime-us-alarm", before, server_wakeups(c),
+                   PERIOD_SECONDS);
+    printf("%-32s %10d notifies/s (expected %d)\n", "servertime-us-alarm",
+           notifies / PERIOD_SECONDS, 1000000 / PERIOD_US);
+
+    xcb_disconnect(c);
+    return 0;
+}
@@ -0,0 +1,526 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ *
+ * @brief input latency from device to client through the inputtest driver
+ *
+ * Needs an Xorg started with input-latency.conf (or any config with
+ * inputtest devices on the same socket paths), e.g.
+ *
+ *   simple-xinit bench-input -- Xorg -config input-latency.conf
+ *
+ * Motion, key and touch events are written to the inputtest sockets at a
+ * fixed rate and picked up again as XI2 events by a listener at the bottom
+ * of a stack of full screen windows, with and without an active device
+ * grab.  Each burst is followed by an inputtest WaitForSync, which the
+ * driver answers once the server has processed its input queue, so two
+ * latencies are reported per event: "queue" up to the sync reply (input
+ * thread and mieq) and "delivery" up to the XI2 event at the client.
+ *
+ *   -k/-p/-t PATH  keyboard, absolute pointer and touch socket
+ *   -r HZ          events per second (default 1000)
+ *   -n N           events per workload (default 2000)
+ *   -b N           events per burst between syncs (default 1)
+ *
+ * The requests are built by hand, to not depend on xcb-xinput.
+ */
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <xcb/xcbext.h>
+
+#include "xf86-input-inputtest-protocol.h"
+
+#include "bench.h"
+
+#define XI_QUERY_VERSION 47
+#define XI_SELECT_EVENTS 46
+#define XI_GRAB_DEVICE 51
+#define XI_UNGRAB_DEVICE 52
+
+#define XI_KeyPress 2
+#define XI_KeyRelease 3
+#define XI_Motion 6
+#define XI_TouchBegin 18
+#define XI_TouchUpdate 19
+#define XI_TouchEnd 20
+
+#define XIAllMasterDevices 1
+#define VCP_ID 2
+#define VCK_ID 3
+
+#define KEYCODE 38              /* 'a' with the default keymap */
+#define TOUCH_STROKE 16         /* events per touch, begin to end */
+#define TIMEOUT_NS 1000000000ULL
+
+static xcb_extension_t xinput_id = { "XInputExtension", 0 };
+
+static const int depths[] = { 1, 16, 64 };
+
+struct device {
+    const char *kind;
+    const char *path;
+    int fd;
+    uint16_t deviceid;          /* master device the listener grabs */
+    uint32_t mask;              /* XI2 event mask to select */
+    void (*fill)(xf86ITEventAny *ev, uint32_t i);
+};
+
+struct samples {
+    uint64_t *ns;
+    size_t count;
+};
+
+static void
+fill_motion(xf86ITEventAny *ev, uint32_t i)
+{
+    xf86ITEventMotion *m = &ev->motion;
+
+    m->header.length = sizeof(*m);
+    m->header.type = XF86IT_EVENT_MOTION;
+    m->is_absolute = 1;
+    m->valuators.mask[0] = 0x3;
+    /* alternate between two positions, so every event moves the sprite */
+    m->valuators.valuators[0] = (i & 1) ? 0x4000 : 0x8000;
+    m->valuators.valuators[1] = 0x4000;
+}
+
+static void
+fill_key(xf86ITEventAny *ev, uint32_t i)
+{
+    ev->key.header.length = sizeof(ev->key);
+    ev->key.header.type = XF86IT_EVENT_KEY;
+    ev->key.key_code = KEYCODE;
+    ev->key.is_press = !(i & 1);
+}
+
+static void
+fill_touch(xf86ITEventAny *ev, uint32_t i)
+{
+    xf86ITEventTouch *t = &ev->touch;
+    uint32_t step = i % TOUCH_STROKE;
+
+    t->header.length = sizeof(*t);
+    t->header.type = XF86IT_EVENT_TOUCH;
+    t->touchid = i / TOUCH_STROKE;
+    t->touch_type = step == 0 ? XI_TouchBegin :
+        step == TOUCH_STROKE - 1 ? XI_TouchEnd : XI_TouchUpdate;
+    t->valuators.mask[0] = 0x3;
+    t->valuators.valuators[0] = (i & 1) ? 0x4000 : 0x8000;
+    t->valuators.valuators[1] = 0x4000;
+}
+
+static struct device devices[] = {
+    { "motion", "/tmp/xlibre-bench-pointer", -1, VCP_ID,
+      1 << XI_Motion, fill_motion },
+    { "key", "/tmp/xlibre-bench-keyboard", -1, VCK_ID,
+      (1 << XI_KeyPress) | (1 << XI_KeyRelease), fill_key },
+    { "touch", "/tmp/xlibre-bench-touch", -1, VCP_ID,
+      (1 << XI_TouchBegin) | (1 << XI_TouchUpdate) | (1 << XI_TouchEnd),
+      fill_touch },
+};
+
+static int
+read_response(int fd, enum xf86ITResponseType type)
+{
+    xf86ITResponseAny response;
+
+    if (read(fd, &response.header, sizeof(response.header)) !=
+        sizeof(response.header) ||
+        response.header.length < sizeof(response.header) ||
+        response.header.length > sizeof(response))
+        return -1;
+    if (response.header.length > sizeof(response.header) &&
+        read(fd, (char *) &response + sizeof(response.header),
+             response.header.length - sizeof(response.header)) !=
+        (ssize_t) (response.header.length - sizeof(response.header)))
+        return -1;
+    return response.header.type == type ? 0 : -1;
+}
+
+static int
+device_connect(struct device *dev)
+{
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    xf86ITEventClientVersion version = {
+        .header = { sizeof(version), XF86IT_EVENT_CLIENT_VERSION },
+        .major = XF86IT_PROTOCOL_VERSION_MAJOR,
+        .minor = XF86IT_PROTOCOL_VERSION_MINOR,
+    };
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", dev->path);
+    if (fd < 0 || connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0 ||
+        write(fd, &version, sizeof(version)) != sizeof(version) ||
+        read_response(fd, XF86IT_RESPONSE_SERVER_VERSION) < 0) {
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    dev->fd = fd;
+    return 0;
+}
+
+static uint8_t
+xi_query_version(xcb_connection_t *c)
+{
+    static const xcb_protocol_request_t req = {
+        .count = 1, .ext = &xinput_id, .opcode = XI_QUERY_VERSION,
+    };
+    const xcb_query_extension_reply_t *ext;
+    struct {
+        uint8_t major, minor;
+        uint16_t length;
+        uint16_t major_version, minor_version;
+    } out = { .major_version = 2, .minor_version = 2 };
+    struct iovec parts[3] = { [2] = { &out, sizeof(out) } };
+    unsigned int seq;
+
+    ext = xcb_get_extension_data(c, &xinput_id);
+    if (!ext || !ext->present)
+        return 0;
+    seq = xcb_send_request(c, 0, parts + 2, &req);
+    free(xcb_wait_for_reply(c, seq, NULL));
+    return ext->major_opcode;
+}
+
+/* XI2 event masks are byte arrays, bit n in byte n / 8 */
+static void
+set_mask(uint8_t out[4], uint32_t mask)
+{
+    for (int i = 0; i < 4; i++)
+        out[i] = mask >> (i * 8);
+}
+
+static void
+xi_select_events(xcb_connection_t *c, xcb_window_t window, uint32_t mask)
+{
+    static const xcb_protocol_request_t req = {
+        .count = 1, .ext = &xinput_id, .opcode = XI_SELECT_EVENTS,
+        .isvoid = 1,
+    };
+    struct {
+        uint8_t major, minor;
+        uint16_t length;
+        uint32_t window;
+        uint16_t num_masks, pad;
+        uint16_t deviceid, mask_len;
+        uint8_t mask[4];
+    } out = {
+        .window = window, .num_masks = 1,
+        .deviceid = XIAllMasterDevices, .mask_len = 1,
+    };
+    struct iovec parts[3] = { [2] = { &out, sizeof(out) } };
+
+    set_mask(out.mask, mask);
+
+    xcb_send_request(c, 0, parts + 2, &req);
+}
+
+static void
+xi_grab_device(xcb_connection_t *c, xcb_window_t window, uint16_t deviceid,
+               uint32_t mask)
+{
+    static const xcb_protocol_request_t req = {
+        .count = 1, .ext = &xinput_id, .opcode = XI_GRAB_DEVICE,
+    };
+    struct {
+        uint8_t major, minor;
+        uint16_t length;
+        uint32_t window, time, cursor;
+        uint16_t deviceid;
+        uint8_t grab_mode, paired_device_mode, owner_events, pad;
+        uint16_t mask_len;
+        uint8_t mask[4];
+    } out = {
+        .window = window, .deviceid = deviceid,
+        .grab_mode = 1, .paired_device_mode = 1, /* GrabModeAsync */
+        .mask_len = 1,
+    };
+    struct iovec parts[3] = { [2] = { &out, sizeof(out) } };
+    unsigned int seq;
+
+    set_mask(out.mask, mask);
+    seq = xcb_send_request(c, 0, parts + 2, &req);
+    free(xcb_wait_for_reply(c, seq, NULL));
+}
+
+static void
+xi_ungrab_device(xcb_connection_t *c, uint16_t deviceid)
+{
+    static const xcb_protocol_request_t req = {
+        .count = 1, .ext = &xinput_id, .opcode = XI_UNGRAB_DEVICE,
+        .isvoid = 1,
+    };
+    struct {
+        uint8_t major, minor;
+        uint16_t length;
+        uint32_t time;
+        uint16_t deviceid, pad;
+    } out = { .deviceid = deviceid };
+    struct iovec parts[3] = { [2] = { &out, sizeof(out) } };
+
+    xcb_send_request(c, 0, parts + 2, &req);
+}
+
+/* a chain of depth full screen windows, returns the innermost one */
+static xcb_window_t
+create_stack(xcb_connection_t *c, xcb_screen_t *screen, int depth,
+             xcb_window_t *outermost)
+{
+    xcb_window_t parent = screen->root, window = 0;
+
+    for (int d = 0; d < depth; d++) {
+        window = xcb_generate_id(c);
+        xcb_create_window(c, XCB_COPY_FROM_PARENT, window, parent, 0, 0,
+                          screen->width_in_pixels, screen->height_in_pixels,
+                          0, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                          screen->root_visual, XCB_CW_OVERRIDE_REDIRECT,
+                          (uint32_t[]) { 1 });
+        xcb_map_window(c, window);
+        if (d == 0)
+            *outermost = window;
+        parent = window;
+    }
+    return window;
+}
+
+static void
+sleep_until(uint64_t ns)
+{
+    struct timespec ts = { ns / 1000000000, ns % 1000000000 };
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+        ;
+}
+
+static int
+cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+
+    return x < y ? -1 : x > y;
+}
+
+static void
+report(const char *name, const char *stage, struct samples *s)
+{
+    char label[96];
+    uint64_t total = 0;
+
+    if (!s->count)
+        return;
+    qsort(s->ns, s->count, sizeof(*s->ns), cmp_u64);
+    for (size_t i = 0; i < s->count; i++)
+        total += s->ns[i];
+
+    snprintf(label, sizeof(label), "%s-%s", name, stage);
+    bench_report(label, s->count, total);
+    printf("%-32s p50 %8.1f us  p90 %8.1f us  p99 %8.1f us  max %8.1f us\n",
+           label, s->ns[s->count / 2] / 1e3,
+           s->ns[(s->count - 1) * 90 / 100] / 1e3,
+           s->ns[(s->count - 1) * 99 / 100] / 1e3,
+           s->ns[s->count - 1] / 1e3);
+    fflush(stdout);
+}
+
+/* wait for the sync reply and for every injected event to show up */
+static int
+collect(xcb_connection_t *c, uint8_t xi_opcode, struct device *dev,
+        const uint64_t *sent, uint32_t count, struct samples *queue,
+        struct samples *delivery)
+{
+    uint64_t deadline = bench_now_ns() + TIMEOUT_NS;
+    uint32_t received = 0;
+    int synced = 0;
+
+    while (received < count || !synced) {
+        struct pollfd fds[2] = {
+            { .fd = xcb_get_file_descriptor(c), .events = POLLIN },
+            { .fd = dev->fd, .events = synced ? 0 : POLLIN },
+        };
+        xcb_generic_event_t *ev;
+        uint64_t now;
+
+        while ((ev = xcb_poll_for_event(c))) {
+            xcb_ge_generic_event_t *ge = (xcb_ge_generic_event_t *) ev;
+
+            now = bench_now_ns();
+            if ((ev->response_type & 0x7f) == XCB_GE_GENERIC &&
+                ge->extension == xi_opcode &&
+                (dev->mask & (1u << ge->event_type)) && received < count)
+                delivery->ns[delivery->count++] = now - sent[received++];
+            free(ev);
+        }
+        if (received == count && synced)
+            break;
+
+        now = bench_now_ns();
+        if (now >= deadline)
+            return -1;
+        if (poll(fds, 2, (deadline - now) / 1000000 + 1) < 0 &&
+            errno != EINTR)
+            return -1;
+
+        if (fds[1].revents & POLLIN) {
+            if (read_response(dev->fd, XF86IT_RESPONSE_SYNC_FINISHED) < 0)
+                return -1;
+            queue->ns[queue->count++] = bench_now_ns() - sent[count - 1];
+            synced = 1;
+        }
+    }
+    return 0;
+}
+
+static void
+run(xcb_connection_t *c, xcb_screen_t *screen, uint8_t xi_opcode,
+    struct device *dev, int depth, int grab, uint32_t events, uint32_t rate,
+    uint32_t burst)
+{
+    static const xf86ITEventWaitForSync sync = {
+        .header = { sizeof(sync), XF86IT_EVENT_WAIT_FOR_SYNC },
+    };
+    struct samples queue, delivery;
+    uint64_t *sent = calloc(burst, sizeof(*sent));
+    uint64_t start, period = 1000000000ULL * burst / rate;
+    uint32_t lost = 0;
+    xcb_window_t window, outermost;
+    char name[64];
+
+    queue.ns = calloc(events / burst + 1, sizeof(*queue.ns));
+    delivery.ns = calloc(events, sizeof(*delivery.ns));
+    queue.count = delivery.count = 0;
+
+    window = create_stack(c, screen, depth, &outermost);
+    xi_select_events(c, window, dev->mask);
+    xcb_set_input_focus(c, XCB_INPUT_FOCUS_POINTER_ROOT, window,
+                        XCB_CURRENT_TIME);
+    if (grab)
+        xi_grab_device(c, window, dev->deviceid, dev->mask);
+    bench_sync(c);
+
+    start = bench_now_ns();
+    for (uint32_t i = 0; i < events; i += burst) {
+        for (uint32_t b = 0; b < burst; b++) {
+            xf86ITEventAny ev;
+
+            memset(&ev, 0, sizeof(ev));
+            dev->fill(&ev, i + b);
+            sent[b] = bench_now_ns();
+            if (write(dev->fd, &ev, ev.header.length) != ev.header.length) {
+                perror(dev->kind);
+                exit(1);
+            }
+        }
+        if (write(dev->fd, &sync, sizeof(sync)) != sizeof(sync)) {
+            perror(dev->kind);
+            exit(1);
+        }
+        if (collect(c, xi_opcode, dev, sent, burst, &queue, &delivery) < 0)
+            lost++;
+        sleep_until(start + (i / burst + 1) * period);
+    }
+
+    if (grab)
+        xi_ungrab_device(c, dev->deviceid);
+    xcb_destroy_window(c, outermost);
+    bench_sync(c);
+
+    snprintf(name, sizeof(name), "input-%s-depth%d%s", dev->kind, depth,
+             grab ? "-grab" : "");
+    report(name, "queue", &queue);
+    report(name, "delivery", &delivery);
+    if (lost)
+        printf("%-32s %u bursts timed out\n", name, lost);
+
+    free(queue.ns);
+    free(delivery.ns);
+    free(sent);
+}
+
+int
+main(int argc, char **argv)
+{
+    uint32_t rate = 1000, events = 2000, burst = 1;
+    xcb_screen_t *screen;
+    xcb_connection_t *c;
+    uint8_t xi_opcode;
+    int opt, found = 0;
+
+    while ((opt = getopt(argc, argv, "k:p:t:r:n:b:")) != -1) {
+        switch (opt) {
+        case 'k':
+            devices[1].path = optarg;
+            break;
+        case 'p':
+            devices[0].path = optarg;
+            break;
+        case 't':
+            devices[2].path = optarg;
+            break;
+        case 'r':
+            rate = strtoul(optarg, NULL, 10);
+            break;
+        case 'n':
+            events = strtoul(optarg, NULL, 10);
+            break;
+        case 'b':
+            burst = strtoul(optarg, NULL, 10);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-k socket] [-p socket] [-t socket] "
+                    "[-r hz] [-n events] [-b burst]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!rate || !burst || events < burst) {
+        fprintf(stderr, "invalid rate, event count or burst\n");
+        return 1;
+    }
+    /* whole touch strokes and key press/release pairs */
+    events -= events % TOUCH_STROKE;
+    burst = burst > events ? events : burst;
+    events -= events % burst;
+
+    c = bench_connect(&screen);
+    xi_opcode = xi_query_version(c);
+    if (!xi_opcode) {
+        printf("XInputExtension not available\n");
+        exit(77);
+    }
+    /* autorepeat would add key events nobody injected */
+    xcb_change_keyboard_control(c, XCB_KB_AUTO_REPEAT_MODE,
+                                (uint32_t[]) { XCB_AUTO_REPEAT_MODE_OFF });
+
+    for (size_t d = 0; d < ARRAY_SIZE(devices); d++) {
+        if (device_connect(&devices[d]) < 0)
+            printf("no inputtest %s device at %s\n", devices[d].kind,
+                   devices[d].path);
+        else
+            found++;
+    }
+    if (!found) {
+        printf("needs an Xorg with inputtest devices, see input-latency.conf\n");
+        exit(77);
+    }
+
+    for (size_t d = 0; d < ARRAY_SIZE(devices); d++) {
+        if (devices[d].fd < 0)
+            continue;
+        for (size_t i = 0; i < ARRAY_SIZE(depths); i++)
+            for (int grab = 0; grab <= 1; grab++)
+                run(c, screen, xi_opcode, &devices[d], depths[i], grab,
+                    events, rate, burst);
+        close(devices[d].fd);
+    }
+
+    xcb_disconnect(c);
+    return 0;
+}
@@ -0,0 +1,182 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ *
+ * @brief frame pacing of Present on the fake vblank clock
+ *
+ * Presents to 1, then 16 and then 64 windows every frame, like a desktop
+ * running several video players at once, with every PresentPixmap aimed
+ * at the msc after the one the previous frame completed at.  Xvfb has no
+ * vblank interrupts, so this runs on present_fake.c's timer driven clock.
+ *
+ * Reports the time per frame, which should stay at the fake refresh
+ * interval, how many frames missed their msc, and how far apart the
+ * CompleteNotify events of one frame were in server time.
+ *
+ * The Present requests are built by hand, to not depend on xcb-present.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <xcb/xcbext.h>
+
+#include "bench.h"
+
+#define MAX_WINDOWS 64
+#define FRAMES 60
+
+#define PRESENT_PIXMAP 1
+#define PRESENT_SELECT_INPUT 3
+#define PRESENT_COMPLETE_NOTIFY 1
+#define PRESENT_COMPLETE_NOTIFY_MASK (1 << 1)
+
+static xcb_extension_t present_id = { "Present", 0 };
+
+static void
+select_complete(xcb_connection_t *c, xcb_window_t window)
+{
+    static const xcb_protocol_request_t req = {
+        .count = 1, .ext = &present_id, .opcode = PRESENT_SELECT_INPUT,
+        .isvoid = 1,
+    };
+    struct {
+        uint8_t major, minor;
+        uint16_t length;
+        uint32_t eid;
+        uint32_t window;
+        uint32_t event_mask;
+    } out = {
+        .length = 4, .eid = xcb_generate_id(c), .window = window,
+        .event_mask = PRESENT_COMPLETE_NOTIFY_MASK,
+    };
+    struct iovec parts[3] = { [2] = { &out, sizeof(out) } };
+
+    xcb_send_request(c, 0, parts + 2, &req);
+}
+
+static void
+present_pixmap(xcb_connection_t *c, xcb_window_t window, xcb_pixmap_t pixmap,
+               uint32_t serial, uint64_t target_msc)
+{
+    static const xcb_protocol_request_t req = {
+        .count = 1, .ext = &present_id, .opcode = PRESENT_PIXMAP,
+        .isvoid = 1,
+    };
+    struct {
+        uint8_t major, minor;
+        uint16_t length;
+        uint32_t window;
+        uint32_t pixmap;
+        uint32_t serial;
+        uint32_t valid, update;
+        int16_t x_off, y_off;
+        uint32_t target_crtc;
+        uint32_t wait_fence, idle_fence;
+        uint32_t options;
+        uint32_t pad1;
+        uint64_t target_msc, divisor, remainder;
+    } out = {
+        .length = 18, .window = window, .pixmap = pixmap, .serial = serial,
+        .target_msc = target_msc,
+    };
+    struct iovec parts[3] = { [2] = { &out, sizeof(out) } };
+
+    xcb_send_request(c, 0, parts + 2, &req);
+}
+
+/* waits for the CompleteNotify events of count windows, returns the latest
+ * msc and the spread of their ust */
+static uint64_t
+wait_complete(xcb_connection_t *c, uint8_t major, int count,
+              uint64_t *spread)
+{
+    uint64_t msc = 0, min_ust = UINT64_MAX, max_ust = 0;
+
+    while (count > 0) {
+        xcb_generic_event_t *ev = xcb_wait_for_event(c);
+        uint8_t *data = (uint8_t *) ev;
+        uint16_t evtype;
+        uint64_t ust, ev_msc;
+
+        if (!ev || ev->response_type == 0) {
+            printf("PresentPixmap failed\n");
+            exit(1);
+        }
+        memcpy(&evtype, data + 8, 2);
+        if (ev->response_type == XCB_GE_GENERIC && data[1] == major &&
+            evtype == PRESENT_COMPLETE_NOTIFY) {
+            /* xcb puts full_sequence before the event's last 8 bytes */
+            memcpy(&ust, data + 24, 8);
+            memcpy(&ev_msc, data + 36, 8);
+            if (ust < min_ust)
+                min_ust = ust;
+            if (ust > max_ust)
+                max_ust = ust;
+            if (ev_msc > msc)
+                msc = ev_msc;
+            count--;
+        }
+        free(ev);
+    }
+    *spread = max_ust - min_ust;
+    return msc;
+}
+
+int
+main(int argc, char **argv)
+{
+    static const int levels[] = { 1, 16, MAX_WINDOWS };
+    xcb_window_t windows[MAX_WINDOWS];
+    xcb_pixmap_t pixmaps[MAX_WINDOWS];
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+    const xcb_query_extension_reply_t *ext;
+    uint32_t serial = 0;
+
+    ext = xcb_get_extension_data(c, &present_id);
+    if (!ext || !ext->present) {
+        printf("Present not available\n");
+        exit(77);
+    }
+
+    for (int i = 0; i < MAX_WINDOWS; i++) {
+        windows[i] = bench_create_window(c, screen, (i % 8) * 40,
+                                         (i / 8) * 40, 32, 32);
+        pixmaps[i] = xcb_generate_id(c);
+        xcb_create_pixmap(c, screen->root_depth, pixmaps[i], windows[i],
+                          32, 32);
+        select_complete(c, windows[i]);
+    }
+    bench_sync(c);
+
+    for (int l = 0; l < ARRAY_SIZE(levels); l++) {
+        int count = levels[l], missed = 0;
+        uint64_t msc, spread, total_spread = 0, start;
+        char name[64];
+
+        /* the first present completes right away and tells the msc */
+        present_pixmap(c, windows[0], pixmaps[0], ++serial, 0);
+        msc = wait_complete(c, ext->major_opcode, 1, &spread);
+
+        start = bench_now_ns();
+        for (int f = 0; f < FRAMES; f++) {
+            uint64_t target = msc + 1;
+
+            for (int i = 0; i < count; i++)
+                present_pixmap(c, windows[i], pixmaps[i], ++serial, target);
+            xcb_flush(c);
+            msc = wait_complete(c, ext->major_opcode, count, &spread);
+            if (msc > target)
+                missed++;
+            total_spread += spread;
+        }
+        snprintf(name, sizeof(name), "present-%d-windows", count);
+        bench_report(name, FRAMES, bench_now_ns() - start);
+        printf("%-32s %10d missed, %6.1f us spread\n", name, missed,
+               (double) total_spread / FRAMES);
+    }
+
+    xcb_disconnect(c);
+    return 0;
+}
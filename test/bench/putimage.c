@@ -0,0 +1,75 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ *
+ * @brief large ZPixmap PutImage throughput
+ *
+ * Uploads whole 1080p and 4K frames with plain PutImage requests, the way
+ * video players without MIT-SHM do.  Frames are split into as few bands as
+ * the maximum (BIG-REQUESTS) request length allows.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+#define FRAMES 30
+
+static void
+bench_frames(xcb_connection_t *c, xcb_screen_t *screen,
+             uint16_t width, uint16_t height)
+{
+    xcb_pixmap_t pixmap = xcb_generate_id(c);
+    xcb_gcontext_t gc = xcb_generate_id(c);
+    uint32_t stride = width * 4;
+    /* request header plus some slack, in bytes */
+    uint32_t max_bytes = xcb_get_maximum_request_length(c) * 4 - 64;
+    uint16_t band = max_bytes / stride < height ? max_bytes / stride : height;
+    uint8_t *frame = malloc((size_t) stride * height);
+    char name[64];
+
+    for (size_t i = 0; i < (size_t) stride * height; i++)
+        frame[i] = i * 7;
+
+    xcb_create_pixmap(c, screen->root_depth, pixmap, screen->root,
+                      width, height);
+    xcb_create_gc(c, gc, pixmap, 0, NULL);
+    bench_sync(c);
+
+    uint64_t start = bench_now_ns();
+    for (int f = 0; f < FRAMES; f++) {
+        for (uint16_t y = 0; y < height; y += band) {
+            uint16_t h = height - y < band ? height - y : band;
+
+            xcb_put_image(c, XCB_IMAGE_FORMAT_Z_PIXMAP, pixmap, gc,
+                          width, h, 0, y, 0, screen->root_depth,
+                          stride * h, frame + (size_t) stride * y);
+        }
+    }
+    bench_sync(c);
+    snprintf(name, sizeof(name), "putimage-zpixmap-%dx%d-frame",
+             width, height);
+    bench_report(name, FRAMES, bench_now_ns() - start);
+
+    xcb_free_gc(c, gc);
+    xcb_free_pixmap(c, pixmap);
+    free(frame);
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+
+    if (screen->root_depth != 24) {
+        printf("needs a depth 24 screen\n");
+        exit(77);
+    }
+
+    bench_frames(c, screen, 1920, 1080);
+    bench_frames(c, screen, 3840, 2160);
+
+    xcb_disconnect(c);
+    return 0;
+}
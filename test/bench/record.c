@@ -0,0 +1,178 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ *
+ * @brief dispatch overhead of enabled RECORD contexts
+ *
+ * Enables 0, 1 and then 8 RECORD contexts on all clients, each recording
+ * only something the measured client never does (GetAtomName replies and
+ * Expose events), like an idle macro recorder or accessibility tool.  The
+ * measured client then does reply and event heavy work that none of the
+ * contexts is interested in; ideally that costs the same with and without
+ * contexts.  A number of idle connections make the contexts' client lists
+ * as long as on a busy desktop.
+ *
+ * The RECORD requests are built by hand, to not depend on xcb-record.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <xcb/xcbext.h>
+
+#include "bench.h"
+
+#define IDLE_CLIENTS 64
+#define MAX_CONTEXTS 8
+#define BATCH 100
+#define BATCHES 200
+
+#define RECORD_CREATE_CONTEXT 1
+#define RECORD_ENABLE_CONTEXT 5
+#define RECORD_ALL_CLIENTS 3
+
+#define X_GET_ATOM_NAME 17
+
+static xcb_extension_t record_id = { "RECORD", 0 };
+
+/* create a context on all clients and enable it; the connection is busy
+ * delivering recorded data from then on and is only ever disconnected */
+static void
+record_start(xcb_connection_t *c)
+{
+    static const xcb_protocol_request_t create_req = {
+        .count = 1, .ext = &record_id, .opcode = RECORD_CREATE_CONTEXT,
+        .isvoid = 1,
+    };
+    static const xcb_protocol_request_t enable_req = {
+        .count = 1, .ext = &record_id, .opcode = RECORD_ENABLE_CONTEXT,
+        .isvoid = 0,
+    };
+    struct {
+        uint8_t major, minor;
+        uint16_t length;
+        uint32_t context;
+        uint8_t element_header, pad[3];
+        uint32_t num_client_specs;
+        uint32_t num_ranges;
+        uint32_t client_spec;
+        /* xRecordRange: core requests, core replies, extension requests
+         * and replies, delivered events, device events, errors, client
+         * started and died */
+        uint8_t range[24];
+    } create = {
+        .context = xcb_generate_id(c),
+        .num_client_specs = 1, .num_ranges = 1,
+        .client_spec = RECORD_ALL_CLIENTS,
+    };
+    struct {
+        uint8_t major, minor;
+        uint16_t length;
+        uint32_t context;
+    } enable = { .context = create.context };
+    struct iovec parts[3];
+    unsigned int seq;
+
+    create.range[2] = create.range[3] = X_GET_ATOM_NAME;
+    create.range[16] = create.range[17] = XCB_EXPOSE;
+
+    parts[2].iov_base = &create;
+    parts[2].iov_len = sizeof(create);
+    xcb_send_request(c, 0, parts + 2, &create_req);
+
+    parts[2].iov_base = &enable;
+    parts[2].iov_len = sizeof(enable);
+    seq = xcb_send_request(c, 0, parts + 2, &enable_req);
+
+    /* the first reply is StartOfData, sent once the context is enabled */
+    free(xcb_wait_for_reply(c, seq, NULL));
+}
+
+static void
+bench_replies(xcb_connection_t *c, const char *name)
+{
+    xcb_get_input_focus_cookie_t cookies[BATCH];
+    uint64_t start = bench_now_ns();
+
+    for (int b = 0; b < BATCHES; b++) {
+        for (int i = 0; i < BATCH; i++)
+            cookies[i] = xcb_get_input_focus(c);
+        for (int i = 0; i < BATCH; i++)
+            free(xcb_get_input_focus_reply(c, cookies[i], NULL));
+    }
+    bench_report(name, BATCH * BATCHES, bench_now_ns() - start);
+}
+
+static void
+bench_events(xcb_connection_t *c, xcb_window_t window, const char *name)
+{
+    xcb_generic_event_t *ev;
+    uint32_t value = 0;
+    uint64_t start = bench_now_ns();
+
+    for (int b = 0; b < BATCHES; b++) {
+        for (int i = 0; i < BATCH; i++)
+            xcb_change_property(c, XCB_PROP_MODE_REPLACE, window,
+                                XCB_ATOM_WM_NAME, XCB_ATOM_CARDINAL, 32,
+                                1, &value);
+        bench_sync(c);
+        while ((ev = xcb_poll_for_event(c)))
+            free(ev);
+    }
+    bench_report(name, BATCH * BATCHES, bench_now_ns() - start);
+}
+
+int
+main(int argc, char **argv)
+{
+    static const int levels[] = { 0, 1, MAX_CONTEXTS };
+    xcb_connection_t *idle[IDLE_CLIENTS];
+    xcb_connection_t *recorders[MAX_CONTEXTS];
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+    const xcb_query_extension_reply_t *ext;
+    xcb_window_t window;
+    int enabled = 0;
+
+    ext = xcb_get_extension_data(c, &record_id);
+    if (!ext || !ext->present) {
+        printf("RECORD not available\n");
+        exit(77);
+    }
+
+    for (int i = 0; i < IDLE_CLIENTS; i++) {
+        xcb_screen_t *idle_screen;
+
+        idle[i] = bench_connect(&idle_screen);
+        bench_sync(idle[i]);
+    }
+
+    window = bench_create_window(c, screen, 0, 0, 64, 64);
+    xcb_change_window_attributes(c, window, XCB_CW_EVENT_MASK,
+                                 (uint32_t[]) { XCB_EVENT_MASK_PROPERTY_CHANGE });
+    bench_sync(c);
+
+    for (int l = 0; l < ARRAY_SIZE(levels); l++) {
+        char name[64];
+
+        while (enabled < levels[l]) {
+            xcb_screen_t *recorder_screen;
+
+            recorders[enabled] = bench_connect(&recorder_screen);
+            record_start(recorders[enabled++]);
+        }
+        bench_sync(c);
+
+        snprintf(name, sizeof(name), "record-%d-replies", enabled);
+        bench_replies(c, name);
+        snprintf(name, sizeof(name), "record-%d-events", enabled);
+        bench_events(c, window, name);
+    }
+
+    for (int i = 0; i < enabled; i++)
+        xcb_disconnect(recorders[i]);
+    for (int i = 0; i < IDLE_CLIENTS; i++)
+        xcb_disconnect(idle[i]);
+    xcb_disconnect(c);
+    return 0;
+}
@@ -0,0 +1,1036 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ *
+ * @brief many-client protocol replay
+ *
+ * Replays recorded client request streams against the server, many
+ * connections at once, to see how scheduling, I/O and resource handling
+ * behave under a desktop-like load rather than one benchmark client.
+ *
+ *   bench-replay -R 9 -o DIR      record: act as display :9, forward every
+ *                                 client to $DISPLAY and write one capture
+ *                                 file per client into DIR
+ *   bench-replay [opts] FILE...   replay the captures against $DISPLAY
+ *   bench-replay [opts]           replay a built-in synthetic client
+ *
+ *   -n N    number of clients, captures are reused round robin (default:
+ *           one per capture, or 100 for the synthetic client)
+ *   -s X    replay speed factor (default 1)
+ *   -r MS   start the clients evenly spread over MS milliseconds
+ *   -v      print per-client results
+ *
+ * xcb does the connection setup and authorization; after that the socket
+ * is driven directly, so requests go out byte for byte as recorded.  XIDs
+ * from the recorded client's resource range and the recorded root window
+ * are rewritten to the new connection's.  That is a heuristic on every
+ * request word, and extension major opcodes must match between the two
+ * servers, so record and replay with the same build and configuration.
+ *
+ * After every burst of requests a GetInputFocus is appended and the time
+ * to its reply is taken as the client's latency sample.  A client does
+ * not run more than MAX_PENDING bursts ahead of its replies, so a slow
+ * server shows as clients falling behind their recorded schedule.
+ *
+ * Capture files are in host byte order: a struct capture_header, then
+ * per request a struct capture_record followed by the request bytes.
+ */
+#define _GNU_SOURCE             /* struct ucred */
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "bench.h"
+
+#define CAPTURE_MAGIC 0x4c505258 /* "XRPL" */
+#define CAPTURE_VERSION 1
+#define CAPTURE_BYTE_ORDER 0x01020304
+
+#define MAX_PENDING 4
+#define READ_SIZE 65536
+#define MAX_RECORDERS 64
+
+#define X_GetInputFocus 43
+#define X_Error 0
+#define X_Reply 1
+#define GenericEvent 35
+
+/* synthetic client: 10 s of 60 Hz frames */
+#define SYNTH_FRAMES 600
+#define SYNTH_FRAME_NS 16666667ULL
+#define SYNTH_CLIENTS 100
+#define SYNTH_BASE 0x00200000
+#define SYNTH_MASK 0x001fffff
+#define SYNTH_ROOT 0x00000100
+
+struct capture_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t resource_base;
+    uint32_t resource_mask;
+    uint32_t root;
+};
+
+struct capture_record {
+    uint64_t time_ns;           /* since the connection was set up */
+    uint32_t length;            /* request bytes that follow */
+};
+
+struct request {
+    uint64_t time_ns;
+    uint32_t length;
+    uint8_t *data;
+};
+
+struct capture {
+    const char *name;
+    struct capture_header header;
+    struct request *requests;
+    size_t count, size;
+};
+
+struct client {
+    const struct capture *capture;
+    xcb_connection_t *c;
+    int fd;
+    uint32_t base, mask, root;
+
+    uint64_t start_ns;
+    size_t next;                /* next request to send */
+    uint32_t seq;               /* last sequence number used */
+
+    uint8_t *out;
+    size_t out_len, out_pos, out_size;
+
+    uint8_t in[READ_SIZE];
+    size_t in_len;
+    size_t skip;                /* reply bytes still to discard */
+
+    uint16_t pending_seq[MAX_PENDING];
+    uint64_t pending_ns[MAX_PENDING];
+    int pending_head, pending_count;
+
+    uint64_t *latency;
+    size_t samples, samples_size;
+    uint64_t errors;
+    uint64_t lag_ns;            /* finished this late against the capture */
+    int done, failed;
+};
+
+static void *
+xrealloc(void *ptr, size_t size)
+{
+    void *ret = realloc(ptr, size);
+
+    if (!ret) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    return ret;
+}
+
+static uint32_t
+pad4(uint32_t n)
+{
+    return (n + 3) & ~3;
+}
+
+static uint16_t
+get16(const uint8_t *p)
+{
+    uint16_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t
+get32(const uint8_t *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/* length of the request at p in bytes, 0 if not known yet */
+static uint32_t
+request_length(const uint8_t *p, size_t avail)
+{
+    if (avail < 4)
+        return 0;
+    if (get16(p + 2))
+        return get16(p + 2) * 4;
+    /* BIG-REQUESTS */
+    if (avail < 8)
+        return 0;
+    return get32(p + 4) * 4;
+}
+
+static void
+capture_add(struct capture *cap, uint64_t time_ns, const void *data,
+            uint32_t length)
+{
+    struct request *req;
+
+    if (cap->count == cap->size) {
+        cap->size = cap->size ? cap->size * 2 : 256;
+        cap->requests = xrealloc(cap->requests,
+                                 cap->size * sizeof(*cap->requests));
+    }
+    req = &cap->requests[cap->count++];
+    req->time_ns = time_ns;
+    req->length = length;
+    req->data = xrealloc(NULL, length);
+    memcpy(req->data, data, length);
+}
+
+static void
+capture_load(struct capture *cap, const char *path)
+{
+    struct capture_record rec;
+    FILE *f = fopen(path, "rb");
+    uint8_t *buf = NULL;
+
+    memset(cap, 0, sizeof(*cap));
+    cap->name = path;
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    if (fread(&cap->header, sizeof(cap->header), 1, f) != 1 ||
+        cap->header.magic != CAPTURE_MAGIC ||
+        cap->header.version != CAPTURE_VERSION ||
+        cap->header.byte_order != CAPTURE_BYTE_ORDER) {
+        fprintf(stderr, "%s: not a capture file for this host\n", path);
+        exit(1);
+    }
+    while (fread(&rec, sizeof(rec), 1, f) == 1) {
+        if (rec.length < 4 || rec.length % 4) {
+            fprintf(stderr, "%s: bad request length %u\n", path, rec.length);
+            exit(1);
+        }
+        buf = xrealloc(buf, rec.length);
+        if (fread(buf, rec.length, 1, f) != 1) {
+            fprintf(stderr, "%s: truncated\n", path);
+            exit(1);
+        }
+        capture_add(cap, rec.time_ns, buf, rec.length);
+    }
+    free(buf);
+    fclose(f);
+}
+
+/*
+ * Synthetic client: a mapped window that gets a few fills and a title
+ * round trip every frame, roughly what a busy terminal or status bar
+ * does.
+ */
+static void
+synth_request(struct capture *cap, uint64_t t, uint8_t opcode, uint8_t data,
+              const uint32_t *words, uint16_t count)
+{
+    uint8_t req[64];
+
+    req[0] = opcode;
+    req[1] = data;
+    uint16_t length = count + 1;
+    memcpy(req + 2, &length, sizeof(length));
+    memcpy(req + 4, words, count * 4);
+    capture_add(cap, t, req, length * 4);
+}
+
+static uint32_t
+pack8(uint8_t first)
+{
+    /* a CARD8 followed by padding, as one host order word */
+    uint8_t bytes[4] = { first };
+    uint32_t v;
+
+    memcpy(&v, bytes, sizeof(v));
+    return v;
+}
+
+static uint32_t
+pack16(uint16_t lo, uint16_t hi)
+{
+    /* two CARD16s in request order, as one host order word */
+    uint16_t pair[2] = { lo, hi };
+    uint32_t v;
+
+    memcpy(&v, pair, sizeof(v));
+    return v;
+}
+
+static void
+capture_synthetic(struct capture *cap)
+{
+    const uint32_t window = SYNTH_BASE | 1, gc = SYNTH_BASE | 2;
+    const uint32_t XA_STRING = 31, XA_WM_NAME = 39;
+
+    memset(cap, 0, sizeof(*cap));
+    cap->name = "synthetic";
+    cap->header = (struct capture_header) {
+        .magic = CAPTURE_MAGIC,
+        .version = CAPTURE_VERSION,
+        .byte_order = CAPTURE_BYTE_ORDER,
+        .resource_base = SYNTH_BASE,
+        .resource_mask = SYNTH_MASK,
+        .root = SYNTH_ROOT,
+    };
+
+    /* CreateWindow 64x64, CWBackPixel */
+    synth_request(cap, 0, 1, 0, (uint32_t[]) {
+                  window, SYNTH_ROOT, pack16(0, 0), pack16(64, 64),
+                  pack16(0, 1), 0, 0x2, 0 }, 8);
+    /* MapWindow */
+    synth_request(cap, 0, 8, 0, (uint32_t[]) { window }, 1);
+    /* CreateGC, GCForeground */
+    synth_request(cap, 0, 55, 0, (uint32_t[]) { gc, window, 0x4, 0 }, 4);
+
+    for (uint32_t f = 0; f < SYNTH_FRAMES; f++) {
+        uint64_t t = (f + 1) * SYNTH_FRAME_NS;
+
+        for (uint16_t i = 0; i < 4; i++)
+            /* PolyFillRectangle */
+            synth_request(cap, t, 70, 0, (uint32_t[]) {
+                          window, gc, pack16((f + i * 13) % 48, i * 12),
+                          pack16(16, 8) }, 4);
+        /* ChangeProperty WM_NAME, 16 bytes of STRING */
+        synth_request(cap, t, 18, 0, (uint32_t[]) {
+                      window, XA_WM_NAME, XA_STRING, pack8(8), 16,
+                      0x61626364, 0x65666768, 0x696a6b6c, 0x6d6e6f70 }, 9);
+        /* GetProperty WM_NAME */
+        synth_request(cap, t, 20, 0, (uint32_t[]) {
+                      window, XA_WM_NAME, 0, 0, 16 }, 5);
+    }
+}
+
+static void
+client_queue(struct client *cl, const void *data, size_t length)
+{
+    if (cl->out_len + length > cl->out_size) {
+        cl->out_size = (cl->out_len + length) * 2;
+        cl->out = xrealloc(cl->out, cl->out_size);
+    }
+    memcpy(cl->out + cl->out_len, data, length);
+    cl->out_len += length;
+}
+
+static void
+client_queue_request(struct client *cl, const struct request *req)
+{
+    const struct capture_header *h = &cl->capture->header;
+    uint32_t first = get16(req->data + 2) ? 4 : 8;
+    uint8_t *p;
+
+    client_queue(cl, req->data, req->length);
+    p = cl->out + cl->out_len - req->length;
+    for (uint32_t i = first; i + 4 <= req->length; i += 4) {
+        uint32_t v = get32(p + i);
+
+        if (v == h->root)
+            v = cl->root;
+        else if (v && (v & ~h->resource_mask) == h->resource_base)
+            v = cl->base | (v & h->resource_mask & cl->mask);
+        else
+            continue;
+        memcpy(p + i, &v, sizeof(v));
+    }
+    cl->seq++;
+}
+
+/* queue every request that is due, then a GetInputFocus to time them */
+static void
+client_schedule(struct client *cl, uint64_t now, double speed)
+{
+    const struct capture *cap = cl->capture;
+    uint8_t sync[4] = { X_GetInputFocus, 0 };
+    uint16_t length = 1;
+    int queued = 0;
+
+    if (cl->done || cl->pending_count == MAX_PENDING)
+        return;
+
+    while (cl->next < cap->count &&
+           cl->start_ns + cap->requests[cl->next].time_ns / speed <= now) {
+        client_queue_request(cl, &cap->requests[cl->next++]);
+        queued = 1;
+    }
+    if (!queued)
+        return;
+
+    memcpy(sync + 2, &length, sizeof(length));
+    client_queue(cl, sync, sizeof(sync));
+    cl->seq++;
+
+    int slot = (cl->pending_head + cl->pending_count) % MAX_PENDING;
+    cl->pending_seq[slot] = cl->seq;
+    cl->pending_ns[slot] = now;
+    cl->pending_count++;
+}
+
+static void
+client_finish(struct client *cl, uint64_t now, double speed)
+{
+    const struct capture *cap = cl->capture;
+    uint64_t due = cl->start_ns;
+
+    if (cap->count)
+        due += cap->requests[cap->count - 1].time_ns / speed;
+    cl->lag_ns = now > due ? now - due : 0;
+    cl->done = 1;
+}
+
+static void
+client_reply(struct client *cl, const uint8_t *packet, uint64_t now)
+{
+    uint16_t seq = get16(packet + 2);
+
+    if (!cl->pending_count || cl->pending_seq[cl->pending_head] != seq)
+        return;
+
+    if (cl->samples == cl->samples_size) {
+        cl->samples_size = cl->samples_size ? cl->samples_size * 2 : 256;
+        cl->latency = xrealloc(cl->latency,
+                               cl->samples_size * sizeof(*cl->latency));
+    }
+    cl->latency[cl->samples++] = now - cl->pending_ns[cl->pending_head];
+    cl->pending_head = (cl->pending_head + 1) % MAX_PENDING;
+    cl->pending_count--;
+}
+
+static void
+client_read(struct client *cl, uint64_t now)
+{
+    ssize_t n = read(cl->fd, cl->in + cl->in_len,
+                     sizeof(cl->in) - cl->in_len);
+    size_t pos = 0;
+
+    if (n <= 0) {
+        if (n < 0 && (errno == EAGAIN || errno == EINTR))
+            return;
+        fprintf(stderr, "%s: connection lost\n", cl->capture->name);
+        cl->failed = cl->done = 1;
+        return;
+    }
+    cl->in_len += n;
+
+    while (pos < cl->in_len) {
+        const uint8_t *p = cl->in + pos;
+        size_t avail = cl->in_len - pos;
+
+        if (cl->skip) {
+            size_t s = avail < cl->skip ? avail : cl->skip;
+
+            cl->skip -= s;
+            pos += s;
+            continue;
+        }
+        if (avail < 32)
+            break;
+
+        switch (p[0] & 0x7f) {
+        case X_Error:
+            cl->errors++;
+            break;
+        case X_Reply:
+            client_reply(cl, p, now);
+            /* fallthrough */
+        case GenericEvent:
+            cl->skip = (size_t) get32(p + 4) * 4;
+            break;
+        }
+        pos += 32;
+    }
+    memmove(cl->in, cl->in + pos, cl->in_len - pos);
+    cl->in_len -= pos;
+}
+
+static void
+client_write(struct client *cl)
+{
+    ssize_t n = write(cl->fd, cl->out + cl->out_pos,
+                      cl->out_len - cl->out_pos);
+
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EINTR)
+            return;
+        fprintf(stderr, "%s: connection lost\n", cl->capture->name);
+        cl->failed = cl->done = 1;
+        return;
+    }
+    cl->out_pos += n;
+    if (cl->out_pos == cl->out_len)
+        cl->out_pos = cl->out_len = 0;
+}
+
+static void
+client_connect(struct client *cl, const struct capture *cap)
+{
+    xcb_screen_t *screen;
+    const xcb_setup_t *setup;
+
+    memset(cl, 0, sizeof(*cl));
+    cl->capture = cap;
+    cl->c = bench_connect(&screen);
+    setup = xcb_get_setup(cl->c);
+    cl->base = setup->resource_id_base;
+    cl->mask = setup->resource_id_mask;
+    cl->root = screen->root;
+    cl->fd = xcb_get_file_descriptor(cl->c);
+    fcntl(cl->fd, F_SETFL, fcntl(cl->fd, F_GETFL) | O_NONBLOCK);
+}
+
+/* utime + stime of the process at the other end of fd, in seconds */
+static double
+peer_cpu_seconds(int fd)
+{
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    unsigned long utime, stime;
+    char path[64], buf[1024], *p;
+    FILE *f;
+    int ok;
+
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0)
+        return -1;
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int) cred.pid);
+    f = fopen(path, "r");
+    if (!f)
+        return -1;
+    ok = fgets(buf, sizeof(buf), f) != NULL;
+    fclose(f);
+    /* the command name may contain spaces, fields continue after ')' */
+    if (!ok || !(p = strrchr(buf, ')')) ||
+        sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+               &utime, &stime) != 2)
+        return -1;
+    return (double) (utime + stime) / sysconf(_SC_CLK_TCK);
+}
+
+static int
+cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+
+    return x < y ? -1 : x > y;
+}
+
+static uint64_t
+percentile(const uint64_t *sorted, size_t count, int pct)
+{
+    if (!count)
+        return 0;
+    return sorted[(count - 1) * pct / 100];
+}
+
+static void
+report(struct client *clients, int count, uint64_t elapsed_ns,
+       double cpu_seconds, int verbose)
+{
+    uint64_t *all = NULL, lag_max = 0, lag_sum = 0;
+    size_t total = 0;
+    double sum = 0, sum_sq = 0;
+    int failed = 0;
+    uint64_t errors = 0;
+
+    for (int i = 0; i < count; i++) {
+        struct client *cl = &clients[i];
+        double mean = 0;
+
+        qsort(cl->latency, cl->samples, sizeof(*cl->latency), cmp_u64);
+        all = xrealloc(all, (total + cl->samples) * sizeof(*all));
+        memcpy(all + total, cl->latency, cl->samples * sizeof(*all));
+        total += cl->samples;
+
+        for (size_t s = 0; s < cl->samples; s++)
+            mean += cl->latency[s];
+        if (cl->samples)
+            mean /= cl->samples;
+        sum += mean;
+        sum_sq += mean * mean;
+
+        if (cl->lag_ns > lag_max)
+            lag_max = cl->lag_ns;
+        lag_sum += cl->lag_ns;
+        errors += cl->errors;
+        failed += cl->failed;
+
+        if (verbose)
+            printf("client %3d %-20s %6zu samples  p50 %8.3f ms  "
+                   "p99 %8.3f ms  max %8.3f ms  lag %8.3f ms%s\n",
+                   i, cl->capture->name, cl->samples,
+                   percentile(cl->latency, cl->samples, 50) / 1e6,
+                   percentile(cl->latency, cl->samples, 99) / 1e6,
+                   percentile(cl->latency, cl->samples, 100) / 1e6,
+                   cl->lag_ns / 1e6, cl->failed ? "  FAILED" : "");
+    }
+    qsort(all, total, sizeof(*all), cmp_u64);
+
+    printf("%d clients, %zu samples, %" PRIu64 " errors, %d failed, "
+           "%.3f s\n", count, total, errors, failed, elapsed_ns / 1e9);
+    printf("latency p50 %.3f ms  p90 %.3f ms  p99 %.3f ms  max %.3f ms\n",
+           percentile(all, total, 50) / 1e6, percentile(all, total, 90) / 1e6,
+           percentile(all, total, 99) / 1e6,
+           percentile(all, total, 100) / 1e6);
+    /* Jain's index over the per-client mean latency: 1 is perfectly fair,
+     * 1/N means one client got all the bad service */
+    printf("fairness %.3f  lag mean %.3f ms  max %.3f ms\n",
+           sum_sq ? sum * sum / (count * sum_sq) : 1.0,
+           lag_sum / 1e6 / count, lag_max / 1e6);
+    if (cpu_seconds >= 0)
+        printf("server cpu %.3f s (%.1f%%)\n", cpu_seconds,
+               cpu_seconds * 1e11 / elapsed_ns);
+    else
+        printf("server cpu unknown\n");
+
+    /* one "op" per percentile, so compare.py can track them */
+    bench_report("replay-latency-p50", 1, percentile(all, total, 50));
+    bench_report("replay-latency-p99", 1, percentile(all, total, 99));
+    bench_report("replay-lag-max", 1, lag_max);
+    free(all);
+}
+
+static int
+replay(struct capture *captures, int ncaptures, int count, double speed,
+       uint64_t ramp_ns, int verbose)
+{
+    struct client *clients = xrealloc(NULL, count * sizeof(*clients));
+    struct pollfd *fds = xrealloc(NULL, count * sizeof(*fds));
+    double cpu_start, cpu_end;
+    uint64_t start, now;
+    int active = count, failed = 0;
+
+    for (int i = 0; i < count; i++)
+        client_connect(&clients[i], &captures[i % ncaptures]);
+    cpu_start = peer_cpu_seconds(clients[0].fd);
+
+    start = bench_now_ns();
+    for (int i = 0; i < count; i++)
+        clients[i].start_ns = start + ramp_ns * i / count;
+
+    while (active) {
+        uint64_t wake = UINT64_MAX;
+        int timeout;
+
+        now = bench_now_ns();
+        for (int i = 0; i < count; i++) {
+            struct client *cl = &clients[i];
+            const struct capture *cap = cl->capture;
+
+            fds[i].fd = -1;
+            if (cl->done)
+                continue;
+
+            client_schedule(cl, now, speed);
+            if (cl->next == cap->count && !cl->pending_count &&
+                !cl->out_len) {
+                client_finish(cl, now, speed);
+                active--;
+                continue;
+            }
+            if (cl->next < cap->count && cl->pending_count < MAX_PENDING) {
+                uint64_t due = cl->start_ns +
+                    cap->requests[cl->next].time_ns / speed;
+
+                if (due < wake)
+                    wake = due;
+            }
+            fds[i].fd = cl->fd;
+            fds[i].events = POLLIN | (cl->out_len ? POLLOUT : 0);
+        }
+        if (!active)
+            break;
+
+        if (wake == UINT64_MAX)
+            timeout = -1;
+        else
+            timeout = wake > now ? (wake - now + 999999) / 1000000 : 0;
+        if (poll(fds, count, timeout) < 0 && errno != EINTR) {
+            perror("poll");
+            exit(1);
+        }
+
+        now = bench_now_ns();
+        for (int i = 0; i < count; i++) {
+            struct client *cl = &clients[i];
+
+            if (fds[i].fd < 0)
+                continue;
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+                client_read(cl, now);
+            if (!cl->done && (fds[i].revents & POLLOUT))
+                client_write(cl);
+            if (cl->done)
+                active--;
+        }
+    }
+    now = bench_now_ns();
+    cpu_end = peer_cpu_seconds(clients[0].fd);
+
+    report(clients, count, now - start,
+           cpu_start >= 0 && cpu_end >= 0 ? cpu_end - cpu_start : -1,
+           verbose);
+
+    for (int i = 0; i < count; i++) {
+        failed += clients[i].failed;
+        xcb_disconnect(clients[i].c);
+        free(clients[i].out);
+        free(clients[i].latency);
+    }
+    free(clients);
+    free(fds);
+    return failed ? 1 : 0;
+}
+
+/*
+ * Recording proxy.  Every byte is passed through unchanged; the client's
+ * stream is split into requests for the capture file and the server's
+ * connection setup reply is parsed for the XID range and root window.
+ */
+struct recorder {
+    int client_fd, server_fd;
+    FILE *capture;
+    uint64_t start_ns;
+    struct capture_header header;
+
+    uint8_t *cbuf;              /* client bytes not yet split */
+    size_t clen, csize;
+    int setup_done;             /* client setup skipped */
+
+    uint8_t *sbuf;              /* server bytes until the setup reply */
+    size_t slen, ssize;
+    int reply_done;
+};
+
+static int
+write_all(int fd, const uint8_t *buf, size_t len)
+{
+    while (len) {
+        ssize_t n = write(fd, buf, len);
+
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static void
+append(uint8_t **buf, size_t *len, size_t *size, const uint8_t *data,
+       size_t n)
+{
+    if (*len + n > *size) {
+        *size = (*len + n) * 2;
+        *buf = xrealloc(*buf, *size);
+    }
+    memcpy(*buf + *len, data, n);
+    *len += n;
+}
+
+static void
+recorder_client_data(struct recorder *r, const uint8_t *data, size_t n)
+{
+    size_t pos = 0;
+
+    if (!r->capture)
+        return;
+    append(&r->cbuf, &r->clen, &r->csize, data, n);
+
+    if (!r->setup_done) {
+        uint16_t probe = 1;
+        uint8_t host_order = *(uint8_t *) &probe ? 'l' : 'B';
+        uint32_t length;
+
+        if (r->clen < 12)
+            return;
+        if (r->cbuf[0] != host_order) {
+            fprintf(stderr, "client byte order differs from ours, "
+                    "not recording it\n");
+            fclose(r->capture);
+            r->capture = NULL;
+            return;
+        }
+        length = 12 + pad4(get16(r->cbuf + 6)) + pad4(get16(r->cbuf + 8));
+        if (r->clen < length)
+            return;
+        pos = length;
+        r->setup_done = 1;
+    }
+
+    while (pos < r->clen) {
+        uint32_t length = request_length(r->cbuf + pos, r->clen - pos);
+        struct capture_record rec;
+
+        if (!length || r->clen - pos < length)
+            break;
+        rec.time_ns = bench_now_ns() - r->start_ns;
+        rec.length = length;
+        fwrite(&rec, sizeof(rec), 1, r->capture);
+        fwrite(r->cbuf + pos, length, 1, r->capture);
+        pos += length;
+    }
+    memmove(r->cbuf, r->cbuf + pos, r->clen - pos);
+    r->clen -= pos;
+}
+
+static void
+recorder_server_data(struct recorder *r, const uint8_t *data, size_t n)
+{
+    const uint8_t *p;
+    uint32_t length, screen;
+
+    if (r->reply_done || !r->capture)
+        return;
+    append(&r->sbuf, &r->slen, &r->ssize, data, n);
+    if (r->slen < 8)
+        return;
+    length = 8 + get16(r->sbuf + 6) * 4;
+    if (r->slen < length)
+        return;
+    r->reply_done = 1;
+
+    p = r->sbuf;
+    if (p[0] != 1 || length < 40)
+        return;
+    r->header.resource_base = get32(p + 12);
+    r->header.resource_mask = get32(p + 16);
+    /* vendor string and pixmap formats come before the first screen */
+    screen = 40 + pad4(get16(p + 24)) + p[29] * 8;
+    if (screen + 4 <= length)
+        r->header.root = get32(p + screen);
+
+    r->start_ns = bench_now_ns();
+    fseek(r->capture, 0, SEEK_SET);
+    fwrite(&r->header, sizeof(r->header), 1, r->capture);
+    fseek(r->capture, 0, SEEK_END);
+}
+
+static int
+unix_socket(const char *path, int listening)
+{
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0)
+        return -1;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    if (listening) {
+        unlink(path);
+        if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0 ||
+            listen(fd, 16) < 0) {
+            close(fd);
+            return -1;
+        }
+    } else if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void
+recorder_close(struct recorder *r)
+{
+    close(r->client_fd);
+    close(r->server_fd);
+    if (r->capture)
+        fclose(r->capture);
+    free(r->cbuf);
+    free(r->sbuf);
+    r->client_fd = -1;
+}
+
+static int
+record(int display, const char *dir)
+{
+    struct recorder recorders[MAX_RECORDERS];
+    struct pollfd fds[1 + 2 * MAX_RECORDERS];
+    char listen_path[108], server_path[108];
+    const char *upstream = getenv("DISPLAY");
+    int listen_fd, nclients = 0;
+
+    if (!upstream || upstream[0] != ':') {
+        fprintf(stderr, "recording needs a local $DISPLAY\n");
+        return 1;
+    }
+    snprintf(server_path, sizeof(server_path), "/tmp/.X11-unix/X%d",
+             atoi(upstream + 1));
+    snprintf(listen_path, sizeof(listen_path), "/tmp/.X11-unix/X%d", display);
+    mkdir(dir, 0755);
+
+    listen_fd = unix_socket(listen_path, 1);
+    if (listen_fd < 0) {
+        perror(listen_path);
+        return 1;
+    }
+    for (int i = 0; i < MAX_RECORDERS; i++)
+        recorders[i].client_fd = -1;
+    printf("recording clients of :%d into %s\n", display, dir);
+    fflush(stdout);
+
+    for (;;) {
+        uint8_t buf[READ_SIZE];
+
+        fds[0] = (struct pollfd) { .fd = listen_fd, .events = POLLIN };
+        for (int i = 0; i < MAX_RECORDERS; i++) {
+            int active = recorders[i].client_fd >= 0;
+
+            fds[1 + 2 * i] = (struct pollfd) {
+                .fd = active ? recorders[i].client_fd : -1, .events = POLLIN };
+            fds[2 + 2 * i] = (struct pollfd) {
+                .fd = active ? recorders[i].server_fd : -1, .events = POLLIN };
+        }
+        if (poll(fds, ARRAY_SIZE(fds), -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("poll");
+            return 1;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(listen_fd, NULL, NULL);
+            struct recorder *r = NULL;
+            char path[PATH_MAX];
+
+            for (int i = 0; fd >= 0 && i < MAX_RECORDERS; i++)
+                if (recorders[i].client_fd < 0) {
+                    r = &recorders[i];
+                    break;
+                }
+            if (!r) {
+                if (fd >= 0)
+                    close(fd);
+                continue;
+            }
+            memset(r, 0, sizeof(*r));
+            r->client_fd = fd;
+            r->server_fd = unix_socket(server_path, 0);
+            if (r->server_fd < 0) {
+                perror(server_path);
+                close(fd);
+                r->client_fd = -1;
+                continue;
+            }
+            snprintf(path, sizeof(path), "%s/client-%03d.xrpl", dir,
+                     nclients++);
+            r->capture = fopen(path, "wb");
+            if (!r->capture)
+                perror(path);
+            r->header = (struct capture_header) {
+                .magic = CAPTURE_MAGIC,
+                .version = CAPTURE_VERSION,
+                .byte_order = CAPTURE_BYTE_ORDER,
+            };
+            r->start_ns = bench_now_ns();
+            if (r->capture)
+                fwrite(&r->header, sizeof(r->header), 1, r->capture);
+        }
+
+        for (int i = 0; i < MAX_RECORDERS; i++) {
+            struct recorder *r = &recorders[i];
+            ssize_t n;
+
+            if (r->client_fd < 0)
+                continue;
+            if (fds[1 + 2 * i].revents) {
+                n = read(r->client_fd, buf, sizeof(buf));
+                if (n <= 0 || write_all(r->server_fd, buf, n) < 0) {
+                    recorder_close(r);
+                    continue;
+                }
+                recorder_client_data(r, buf, n);
+            }
+            if (fds[2 + 2 * i].revents) {
+                n = read(r->server_fd, buf, sizeof(buf));
+                if (n <= 0 || write_all(r->client_fd, buf, n) < 0) {
+                    recorder_close(r);
+                    continue;
+                }
+                recorder_server_data(r, buf, n);
+            }
+        }
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    struct capture *captures;
+    int opt, count = 0, verbose = 0, record_display = -1, ncaptures;
+    const char *record_dir = NULL;
+    double speed = 1;
+    uint64_t ramp_ns = 0;
+
+    while ((opt = getopt(argc, argv, "n:s:r:vR:o:")) != -1) {
+        switch (opt) {
+        case 'n':
+            count = atoi(optarg);
+            break;
+        case 's':
+            speed = atof(optarg);
+            break;
+        case 'r':
+            ramp_ns = strtoull(optarg, NULL, 10) * 1000000;
+            break;
+        case 'v':
+            verbose = 1;
+            break;
+        case 'R':
+            record_display = atoi(optarg);
+            break;
+        case 'o':
+            record_dir = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n clients] [-s speed] [-r ramp-ms] "
+                    "[-v] [capture...]\n"
+                    "       %s -R display -o dir\n", argv[0], argv[0]);
+            return 1;
+        }
+    }
+
+    /* a dropped connection is reported, not fatal */
+    signal(SIGPIPE, SIG_IGN);
+
+    if (record_display >= 0)
+        return record(record_display, record_dir ? record_dir : ".");
+
+    if (speed <= 0) {
+        fprintf(stderr, "speed must be positive\n");
+        return 1;
+    }
+
+    ncaptures = argc - optind;
+    if (ncaptures) {
+        captures = xrealloc(NULL, ncaptures * sizeof(*captures));
+        for (int i = 0; i < ncaptures; i++)
+            capture_load(&captures[i], argv[optind + i]);
+    } else {
+        ncaptures = 1;
+        captures = xrealloc(NULL, sizeof(*captures));
+        capture_synthetic(&captures[0]);
+        if (!count)
+            count = SYNTH_CLIENTS;
+    }
+    if (!count)
+        count = ncaptures;
+
+    return replay(captures, ncaptures, count, speed, ramp_ns, verbose);
+}
@@ -0,0 +1,113 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ *
+ * @brief shape animation benchmark
+ *
+ * Reshapes a mapped window every frame the way animated docks and shaped
+ * video overlays do: cycling through a few mask bitmaps, moving a hole
+ * with ShapeRectangles, and reapplying an unchanged shape.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <xcb/shape.h>
+
+#include "bench.h"
+
+#define WIN_SIZE 512
+#define FRAMES 2000
+#define MASK_FRAMES 6
+
+static xcb_pixmap_t
+create_mask(xcb_connection_t *c, xcb_window_t window, int frame)
+{
+    xcb_pixmap_t pixmap = xcb_generate_id(c);
+    xcb_gcontext_t gc = xcb_generate_id(c);
+    uint32_t fg = 0;
+    xcb_rectangle_t all = { 0, 0, WIN_SIZE, WIN_SIZE };
+    uint16_t r = WIN_SIZE / 4 + frame * (WIN_SIZE / 4) / MASK_FRAMES;
+    xcb_arc_t arc = {
+        WIN_SIZE / 2 - r, WIN_SIZE / 2 - r, 2 * r, 2 * r, 0, 360 * 64
+    };
+
+    xcb_create_pixmap(c, 1, pixmap, window, WIN_SIZE, WIN_SIZE);
+    xcb_create_gc(c, gc, pixmap, XCB_GC_FOREGROUND, &fg);
+    xcb_poly_fill_rectangle(c, pixmap, gc, 1, &all);
+    fg = 1;
+    xcb_change_gc(c, gc, XCB_GC_FOREGROUND, &fg);
+    xcb_poly_fill_arc(c, pixmap, gc, 1, &arc);
+    xcb_free_gc(c, gc);
+    return pixmap;
+}
+
+static void
+bench_mask_cycle(xcb_connection_t *c, xcb_window_t window)
+{
+    xcb_pixmap_t masks[MASK_FRAMES];
+
+    for (int i = 0; i < MASK_FRAMES; i++)
+        masks[i] = create_mask(c, window, i);
+    bench_sync(c);
+
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < FRAMES; i++)
+        xcb_shape_mask(c, XCB_SHAPE_SO_SET, XCB_SHAPE_SK_BOUNDING, window,
+                       0, 0, masks[i % MASK_FRAMES]);
+    bench_sync(c);
+    bench_report("shape-mask-cycle", FRAMES, bench_now_ns() - start);
+
+    for (int i = 0; i < MASK_FRAMES; i++)
+        xcb_free_pixmap(c, masks[i]);
+}
+
+static void
+bench_rects(xcb_connection_t *c, xcb_window_t window, const char *name,
+            int moving)
+{
+    uint64_t start = bench_now_ns();
+
+    for (int i = 0; i < FRAMES; i++) {
+        int16_t hole = moving ? (i % (WIN_SIZE / 2)) : WIN_SIZE / 4;
+        xcb_rectangle_t rects[] = {
+            { 0, 0, WIN_SIZE, hole },
+            { 0, hole, hole, 32 },
+            { hole + 32, hole, WIN_SIZE - hole - 32, 32 },
+            { 0, hole + 32, WIN_SIZE, WIN_SIZE - hole - 32 },
+        };
+
+        xcb_shape_rectangles(c, XCB_SHAPE_SO_SET, XCB_SHAPE_SK_BOUNDING,
+                             XCB_CLIP_ORDERING_YX_BANDED, window, 0, 0,
+                             ARRAY_SIZE(rects), rects);
+    }
+    bench_sync(c);
+    bench_report(name, FRAMES, bench_now_ns() - start);
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+    const xcb_query_extension_reply_t *ext =
+        xcb_get_extension_data(c, &xcb_shape_id);
+
+    if (!ext->present) {
+        printf("No SHAPE present\n");
+        exit(77);
+    }
+
+    /* a few siblings below so revalidation has something to clip */
+    for (int i = 0; i < 16; i++)
+        bench_create_window(c, screen, (i % 4) * 128, (i / 4) * 128,
+                            256, 256);
+    xcb_window_t window = bench_create_window(c, screen, 64, 64,
+                                              WIN_SIZE, WIN_SIZE);
+    bench_sync(c);
+
+    bench_mask_cycle(c, window);
+    bench_rects(c, window, "shape-rects-moving", 1);
+    bench_rects(c, window, "shape-rects-unchanged", 0);
+
+    xcb_disconnect(c);
+    return 0;
+}
@@ -0,0 +1,129 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ *
+ * @brief XC-MISC free ID lookups of a long-running client
+ *
+ * A client that has been running for a long time has created and freed
+ * lots of resources, leaving the IDs it still uses scattered over a large
+ * part of its ID range.  This keeps every other one of 2 * LIVE GCs, for a
+ * growing LIVE, and times the XC-MISC GetXIDRange and GetXIDList requests
+ * that Xlib based clients send once they run out of IDs.
+ *
+ * The XC-MISC requests are built by hand, to not depend on xcb-xc_misc.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <xcb/xcbext.h>
+
+#include "bench.h"
+
+#define LOOKUPS 500
+#define LIST_COUNT 256
+
+#define XCMISC_GET_XID_RANGE 1
+#define XCMISC_GET_XID_LIST 2
+
+static xcb_extension_t xcmisc_id = { "XC-MISC", 0 };
+
+/* returns the number of IDs in the range, 0 if there are none */
+static uint32_t
+get_xid_range(xcb_connection_t *c)
+{
+    static const xcb_protocol_request_t req = {
+        .count = 1, .ext = &xcmisc_id, .opcode = XCMISC_GET_XID_RANGE,
+    };
+    struct {
+        uint8_t major, minor;
+        uint16_t length;
+    } out = { .length = 1 };
+    struct iovec parts[3] = { [2] = { &out, sizeof(out) } };
+    uint8_t *reply;
+    uint32_t count = 0;
+
+    reply = xcb_wait_for_reply(c, xcb_send_request(c, 0, parts + 2, &req),
+                               NULL);
+    if (reply)
+        memcpy(&count, reply + 12, 4);
+    free(reply);
+    return count;
+}
+
+/* returns the number of IDs in the list */
+static uint32_t
+get_xid_list(xcb_connection_t *c, uint32_t count)
+{
+    static const xcb_protocol_request_t req = {
+        .count = 1, .ext = &xcmisc_id, .opcode = XCMISC_GET_XID_LIST,
+    };
+    struct {
+        uint8_t major, minor;
+        uint16_t length;
+        uint32_t count;
+    } out = { .length = 2, .count = count };
+    struct iovec parts[3] = { [2] = { &out, sizeof(out) } };
+    uint8_t *reply;
+    uint32_t found = 0;
+
+    reply = xcb_wait_for_reply(c, xcb_send_request(c, 0, parts + 2, &req),
+                               NULL);
+    if (reply)
+        memcpy(&found, reply + 8, 4);
+    free(reply);
+    return found;
+}
+
+int
+main(int argc, char **argv)
+{
+    static const int levels[] = { 0, 1000, 10000, 100000 };
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+    const xcb_query_extension_reply_t *ext;
+    int live = 0;
+
+    ext = xcb_get_extension_data(c, &xcmisc_id);
+    if (!ext || !ext->present) {
+        printf("XC-MISC not available\n");
+        exit(77);
+    }
+
+    for (int l = 0; l < ARRAY_SIZE(levels); l++) {
+        char name[64];
+        uint64_t start;
+
+        for (; live < levels[l]; live++) {
+            xcb_gcontext_t gc = xcb_generate_id(c);
+
+            xcb_create_gc(c, gc, screen->root, 0, NULL);
+            xcb_create_gc(c, xcb_generate_id(c), screen->root, 0, NULL);
+            xcb_free_gc(c, gc);
+        }
+        bench_sync(c);
+
+        start = bench_now_ns();
+        for (int i = 0; i < LOOKUPS; i++) {
+            if (!get_xid_range(c)) {
+                printf("GetXIDRange found no free IDs\n");
+                exit(1);
+            }
+        }
+        snprintf(name, sizeof(name), "xidrange-%d-range", live);
+        bench_report(name, LOOKUPS, bench_now_ns() - start);
+
+        start = bench_now_ns();
+        for (int i = 0; i < LOOKUPS; i++) {
+            if (get_xid_list(c, LIST_COUNT) != LIST_COUNT) {
+                printf("GetXIDList found too few free IDs\n");
+                exit(1);
+            }
+        }
+        snprintf(name, sizeof(name), "xidrange-%d-list", live);
+        bench_report(name, LOOKUPS, bench_now_ns() - start);
+    }
+
+    xcb_disconnect(c);
+    return 0;
+}
@@ -0,0 +1,130 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ *
+ * @brief XTEST fake input throughput, as driven by UI automation
+ *
+ * Injects pointer motion and button clicks two ways: one FakeInput
+ * request per event followed by a round trip, like most automation
+ * libraries do, and one FakeInput request per event without waiting.
+ * A window selects the resulting events, so delivery is part of the cost.
+ *
+ * The XTEST requests are built by hand, to not depend on xcb-xtest.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <xcb/xcbext.h>
+
+#include "bench.h"
+
+#define EVENTS 20000
+#define SYNC_EVENTS 2000
+
+#define XTEST_FAKE_INPUT 2
+
+static xcb_extension_t xtest_id = { "XTEST", 0 };
+
+/* the event of a FakeInput request: time is a delay in ms */
+typedef struct {
+    uint8_t type, detail;
+    uint16_t pad0;
+    uint32_t time;
+    uint32_t root;
+    uint32_t pad1[2];
+    int16_t root_x, root_y;
+    uint32_t pad2[2];
+} fake_event_t;
+
+/* the i-th event of the workload: a click every 16 motions */
+static void
+make_event(fake_event_t *ev, int i)
+{
+    memset(ev, 0, sizeof(*ev));
+    switch (i % 16) {
+    case 14:
+        ev->type = XCB_BUTTON_PRESS;
+        ev->detail = 1;
+        break;
+    case 15:
+        ev->type = XCB_BUTTON_RELEASE;
+        ev->detail = 1;
+        break;
+    default:
+        ev->type = XCB_MOTION_NOTIFY;
+        ev->root_x = 10 + (i * 7) % 200;
+        ev->root_y = 10 + (i * 13) % 200;
+        break;
+    }
+}
+
+static unsigned int
+fake_input(xcb_connection_t *c, int i)
+{
+    static const xcb_protocol_request_t req = {
+        .count = 1, .ext = &xtest_id, .opcode = XTEST_FAKE_INPUT,
+        .isvoid = 1,
+    };
+    struct {
+        uint8_t major, minor;
+        uint16_t length;
+        fake_event_t ev;
+    } out = { .length = 1 + sizeof(fake_event_t) / 4 };
+    struct iovec parts[3] = { [2] = { &out, sizeof(out) } };
+
+    make_event(&out.ev, i);
+    return xcb_send_request(c, 0, parts + 2, &req);
+}
+
+static void
+drain(xcb_connection_t *c)
+{
+    xcb_generic_event_t *ev;
+
+    bench_sync(c);
+    while ((ev = xcb_poll_for_event(c)))
+        free(ev);
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+    const xcb_query_extension_reply_t *ext;
+    xcb_window_t window;
+    uint64_t start;
+
+    ext = xcb_get_extension_data(c, &xtest_id);
+    if (!ext || !ext->present) {
+        printf("XTEST not available\n");
+        exit(77);
+    }
+
+    window = bench_create_window(c, screen, 0, 0, 256, 256);
+    xcb_change_window_attributes(c, window, XCB_CW_EVENT_MASK,
+                                 (uint32_t[]) {
+                                     XCB_EVENT_MASK_POINTER_MOTION |
+                                     XCB_EVENT_MASK_BUTTON_PRESS |
+                                     XCB_EVENT_MASK_BUTTON_RELEASE });
+    drain(c);
+
+    start = bench_now_ns();
+    for (int i = 0; i < SYNC_EVENTS; i++) {
+        fake_input(c, i);
+        bench_sync(c);
+    }
+    bench_report("xtest-single-sync", SYNC_EVENTS, bench_now_ns() - start);
+    drain(c);
+
+    start = bench_now_ns();
+    for (int i = 0; i < EVENTS; i++)
+        fake_input(c, i);
+    bench_sync(c);
+    bench_report("xtest-single", EVENTS, bench_now_ns() - start);
+    drain(c);
+
+    xcb_disconnect(c);
+    return 0;
+}
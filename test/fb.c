@@ -0,0 +1,112 @@
+/* SPDX-License-Identifier: MIT OR X11
+ *
+ * Copyright © 2026 XLibre contributors
+ */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <dix-config.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fb/fb.h"
+
+#include "tests-common.h"
+
+static FbBits
+fb_test_replicate(CARD32 pixel, int bpp)
+{
+    return bpp == 32 ? pixel : fbReplicatePixel(pixel, bpp);
+}
+
+/*
+ * Straightforward per-pixel version of fbBltOne, used as a reference for
+ * the optimized expansion paths.
+ */
+static void
+fb_test_blt_one_reference(FbStip *src, FbStride srcStride, int srcX,
+                          FbBits *dst, FbStride dstStride, int dstX,
+                          int bpp, int width, int height,
+                          FbBits fgand, FbBits fgxor,
+                          FbBits bgand, FbBits bgxor)
+{
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width / bpp; x++) {
+            int sx = srcX + x;
+            FbStip stip = src[y * srcStride + (sx >> FB_STIP_SHIFT)];
+            Bool set = FbLeftStipBits(FbStipLeft(stip, sx & FB_STIP_MASK), 1);
+            int dx = dstX + x * bpp;
+            FbBits *d = &dst[y * dstStride + (dx >> FB_SHIFT)];
+            FbBits mask = FbBitsMask(dx & FB_MASK, bpp);
+            FbBits and = set ? fgand : bgand;
+            FbBits xor = set ? fgxor : bgxor;
+
+            *d = (*d & ~mask) | (((*d & and) ^ xor) & mask);
+        }
+    }
+}
+
+static void
+fb_blt_one_matches_reference(void)
+{
+    static const int depths[] = { 8, 16, 32 };
+    static const int alus[] = { GXcopy, GXxor, GXand, GXor, GXinvert };
+
+    srand(0x1bb1);
+
+    for (int iter = 0; iter < 20000; iter++) {
+        int bpp = depths[rand() % ARRAY_SIZE(depths)];
+        int alu = alus[rand() % ARRAY_SIZE(alus)];
+        int width = rand() % 100 + 1;
+        int height = rand() % 4 + 1;
+        int srcX = rand() % 70;
+        int dstX = (rand() % 40) * bpp;
+        FbStride srcStride = (srcX + width + FB_STIP_MASK) / FB_STIP_UNIT + 1;
+        FbStride dstStride = (dstX + width * bpp + FB_MASK) / FB_UNIT + 1;
+        FbBits pm = (rand() % 2) ? FB_ALLONES :
+            fb_test_replicate(rand(), bpp);
+        FbBits fg = fb_test_replicate(rand(), bpp);
+        FbBits bg = fb_test_replicate(rand(), bpp);
+        Bool opaque = rand() % 2;
+        FbBits fgand = fbAnd(alu, fg, pm), fgxor = fbXor(alu, fg, pm);
+        FbBits bgand = opaque ? fbAnd(alu, bg, pm) : FB_ALLONES;
+        FbBits bgxor = opaque ? fbXor(alu, bg, pm) : 0;
+        size_t srcSize = srcStride * height * sizeof(FbStip);
+        size_t dstSize = dstStride * height * sizeof(FbBits);
+        FbStip *src = malloc(srcSize);
+        FbBits *expected = malloc(dstSize);
+        FbBits *result = malloc(dstSize);
+
+        assert(src && expected && result);
+        for (size_t i = 0; i < srcSize / sizeof(FbStip); i++)
+            src[i] = (FbStip) rand() ^ ((FbStip) rand() << 16);
+        for (size_t i = 0; i < dstSize / sizeof(FbBits); i++)
+            expected[i] = (FbBits) rand() ^ ((FbBits) rand() << 16);
+        memcpy(result, expected, dstSize);
+
+        fb_test_blt_one_reference(src, srcStride, srcX,
+                                  expected, dstStride, dstX, bpp,
+                                  width * bpp, height,
+                                  fgand, fgxor, bgand, bgxor);
+        fbBltOne(src, srcStride, srcX, result, dstStride, dstX, bpp,
+                 width * bpp, height, fgand, fgxor, bgand, bgxor);
+        assert(memcmp(expected, result, dstSize) == 0);
+
+        free(src);
+        free(expected);
+        free(result);
+    }
+}
+
+const testfunc_t*
+fb_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+        fb_blt_one_matches_reference,
+        NULL,
+    };
+    return testfuncs;
+}
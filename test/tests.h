@@ -23,6 +23,7 @@ extern int verbose;
 
 typedef void (*testfunc_t)(void);
 
+const testfunc_t* fb_test(void);
 const testfunc_t* fixes_test(void);
 const testfunc_t* hashtabletest_test(void);
 const testfunc_t* input_test(void);
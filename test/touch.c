@@ -32,6 +32,7 @@
 #include "dix/input_priv.h"
 
 #include "inputstr.h"
+#include "eventstr.h"
 #include "assert.h"
 #include "scrnintstr.h"
 #include "tests-common.h"
@@ -307,6 +308,118 @@ touch_init(void)
     free_device(&dev);
 }
 
+static void
+touch_history(void)
+{
+    DeviceIntRec dev;
+    TouchPointInfoPtr ti;
+    DeviceEvent ev;
+    SpriteInfoRec sprite;
+    ScreenRec screen;
+    Atom labels[2] = { 0 };
+    const int ntouches = 40;
+    const int nupdates = 10 * TOUCH_HISTORY_SIZE;
+
+    screenInfo.screens[0] = &screen;
+
+    memset(&dev, 0, sizeof(dev));
+    dev.type = MASTER_POINTER;  /* claim it's a master to stop ptracccel */
+    dev.name = XNFstrdup("test device");
+    dev.id = 2;
+
+    InitValuatorClassDeviceStruct(&dev, 2, labels, 10, Absolute);
+    InitTouchClassDeviceStruct(&dev, ntouches, XIDirectTouch, 2);
+    assert(dev.touch->history_pool);
+    assert(dev.touch->history_pool_touches == ntouches);
+
+    memset(&sprite, 0, sizeof(sprite));
+    dev.spriteInfo = &sprite;
+
+    /* one more touch than the device claims to support: that one grows
+     * the touch array and doesn't get pool storage */
+    for (int i = 0; i <= ntouches; i++) {
+        ti = TouchBeginTouch(&dev, dev.id, 100 + i, FALSE);
+        assert(ti);
+        assert(TouchEventHistoryAllocate(ti));
+        assert(ti->history_size == TOUCH_HISTORY_SIZE);
+
+        memset(&ev, 0, sizeof(ev));
+        ev.type = ET_TouchBegin;
+        ev.touchid = 100 + i;
+        SetBit(ev.valuators.mask, 0);
+        SetBit(ev.valuators.mode, 0);
+        SetBit(ev.valuators.mask, 1);
+        SetBit(ev.valuators.mode, 1);
+        TouchEventHistoryPush(ti, &ev);
+        /* a second TouchBegin is ignored */
+        TouchEventHistoryPush(ti, &ev);
+        assert(ti->history_elements == 1);
+    }
+    assert(dev.touch->num_touches == ntouches + 1);
+
+    /* y only changes on the first update, x on every one after that */
+    for (int n = 0; n < nupdates; n++) {
+        for (int i = 0; i <= ntouches; i++) {
+            ti = TouchFindByClientID(&dev, 100 + i);
+            assert(ti);
+
+            memset(&ev, 0, sizeof(ev));
+            ev.type = ET_TouchUpdate;
+            ev.touchid = 100 + i;
+            ev.time = n + 1;
+            if (n == 0) {
+                SetBit(ev.valuators.mask, 1);
+                SetBit(ev.valuators.mode, 1);
+                ev.valuators.data[1] = 50;
+            }
+            else {
+                SetBit(ev.valuators.mask, 0);
+                SetBit(ev.valuators.mode, 0);
+                ev.valuators.data[0] = n;
+            }
+            TouchEventHistoryPush(ti, &ev);
+        }
+    }
+
+    for (int i = 0; i <= ntouches; i++) {
+        DeviceEvent *h;
+        size_t start;
+
+        ti = TouchFindByClientID(&dev, 100 + i);
+        assert(ti);
+
+        /* the first touches live in the pool, memory stays bounded */
+        if (i < ntouches)
+            assert(ti->history ==
+                   &dev.touch->history_pool[i * TOUCH_HISTORY_SIZE]);
+        else
+            assert(ti->history_buffer);
+        assert(ti->history_elements == TOUCH_HISTORY_SIZE);
+
+        /* TouchBegin is kept */
+        assert(ti->history[0].type == ET_TouchBegin);
+
+        /* the most recent updates are kept in order, the oldest kept one
+         * carries the y value of the dropped first update */
+        start = nupdates - (TOUCH_HISTORY_SIZE - 1) + 1;
+        for (int n = 1; n < TOUCH_HISTORY_SIZE; n++) {
+            h = &ti->history[1 + (ti->history_start + n - 1) %
+                             (TOUCH_HISTORY_SIZE - 1)];
+            assert(h->type == ET_TouchUpdate);
+            assert(h->time == start + n - 1);
+            assert(h->valuators.data[0] == start + n - 2);
+            assert(BitIsOn(h->valuators.mask, 1) == (n == 1));
+        }
+        h = &ti->history[1 + ti->history_start];
+        assert(h->valuators.data[1] == 50);
+
+        TouchEndTouch(&dev, ti);
+        assert(!ti->history);
+    }
+
+    free_device(&dev);
+}
+
 const testfunc_t*
 touch_test(void)
 {
@@ -316,6 +429,7 @@ touch_test(void)
         touch_begin_ddxtouch,
         touch_init,
         touch_begin_touch,
+        touch_history,
         NULL,
     };
     return testfuncs;